@@ -82,9 +82,6 @@ void sqlite3Fts3HashClear(Fts3Hash *pH){
   pH->htsize = 0;
   while( elem ){
     Fts3HashElem *next_elem = elem->next;
-    if( pH->copyKey && elem->pKey ){
-      fts3HashFree(elem->pKey);
-    }
     fts3HashFree(elem);
     elem = next_elem;
   }
@@ -93,16 +90,19 @@ void sqlite3Fts3HashClear(Fts3Hash *pH){
 
 /*
 ** Hash and comparison functions when the mode is FTS3_HASH_STRING
+**
+** Both hash functions compute the FNV-1a hash of the key, which mixes
+** every byte into the low-order bits used to select a slot.
 */
 static int fts3StrHash(const void *pKey, int nKey){
-  const char *z = (const char *)pKey;
-  int h = 0;
-  if( nKey<=0 ) nKey = (int) strlen(z);
+  const unsigned char *z = (const unsigned char *)pKey;
+  unsigned int h = 2166136261u;
+  if( nKey<=0 ) nKey = (int) strlen((const char *)z);
   while( nKey > 0  ){
-    h = (h<<3) ^ h ^ *z++;
+    h = (h ^ *z++) * 16777619u;
     nKey--;
   }
-  return h & 0x7fffffff;
+  return (int)(h & 0x7fffffff);
 }
 static int fts3StrCompare(const void *pKey1, int n1, const void *pKey2, int n2){
   if( n1!=n2 ) return 1;
@@ -113,12 +113,12 @@ static int fts3StrCompare(const void *pKey1, int n1, const void *pKey2, int n2){
 ** Hash and comparison functions when the mode is FTS3_HASH_BINARY
 */
 static int fts3BinHash(const void *pKey, int nKey){
-  int h = 0;
-  const char *z = (const char *)pKey;
+  const unsigned char *z = (const unsigned char *)pKey;
+  unsigned int h = 2166136261u;
   while( nKey-- > 0 ){
-    h = (h<<3) ^ h ^ *(z++);
+    h = (h ^ *(z++)) * 16777619u;
   }
-  return h & 0x7fffffff;
+  return (int)(h & 0x7fffffff);
 }
 static int fts3BinCompare(const void *pKey1, int n1, const void *pKey2, int n2){
   if( n1!=n2 ) return 1;
@@ -161,33 +161,58 @@ static int (*ftsCompareFunction(int keyClass))(const void*,int,const void*,int){
   }
 }
 
+/* Add element pNew to the slot table of pH. There must be at least one
+** free slot.
+*/
+static void fts3HashInsertSlot(Fts3Hash *pH, Fts3HashElem *pNew){
+  int mask = pH->htsize-1;
+  int i = pNew->h & mask;
+  while( pH->ht[i].elem ){
+    i = (i+1) & mask;
+  }
+  pH->ht[i].h = pNew->h;
+  pH->ht[i].elem = pNew;
+}
+
+/* Remove element elem from the slot table of pH, moving back elements
+** from the following run of occupied slots as required so that each
+** can still be found by probing forward from the slot its hash selects.
+*/
+static void fts3HashRemoveSlot(Fts3Hash *pH, Fts3HashElem *elem){
+  struct _fts3ht *ht = pH->ht;
+  int mask = pH->htsize-1;
+  int i = elem->h & mask;         /* The slot being emptied */
+  int j;                          /* Slot that might be moved into i */
+  int k;                          /* Slot selected by the hash of j */
+
+  while( ht[i].elem!=elem ){
+    assert( ht[i].elem );
+    i = (i+1) & mask;
+  }
+  for(j=(i+1)&mask; ht[j].elem; j=(j+1)&mask){
+    k = ht[j].h & mask;
+    if( i<=j ? (i<k && k<=j) : (i<k || k<=j) ) continue;
+    ht[i] = ht[j];
+    i = j;
+  }
+  ht[i].elem = 0;
+}
+
 /* Link an element into the hash table
 */
 static void fts3HashInsertElement(
   Fts3Hash *pH,            /* The complete hash table */
-  struct _fts3ht *pEntry,  /* The entry into which pNew is inserted */
   Fts3HashElem *pNew       /* The element to be inserted */
 ){
-  Fts3HashElem *pHead;     /* First element already in pEntry */
-  pHead = pEntry->chain;
-  if( pHead ){
-    pNew->next = pHead;
-    pNew->prev = pHead->prev;
-    if( pHead->prev ){ pHead->prev->next = pNew; }
-    else             { pH->first = pNew; }
-    pHead->prev = pNew;
-  }else{
-    pNew->next = pH->first;
-    if( pH->first ){ pH->first->prev = pNew; }
-    pNew->prev = 0;
-    pH->first = pNew;
-  }
-  pEntry->count++;
-  pEntry->chain = pNew;
+  pNew->next = pH->first;
+  if( pH->first ){ pH->first->prev = pNew; }
+  pNew->prev = 0;
+  pH->first = pNew;
+  fts3HashInsertSlot(pH, pNew);
 }
 
 
-/* Resize the hash table so that it cantains "new_size" buckets.
+/* Resize the hash table so that it cantains "new_size" slots.
 ** "new_size" must be a power of 2.  The hash table might fail 
 ** to resize if sqliteMalloc() fails.
 **
@@ -195,20 +220,17 @@ static void fts3HashInsertElement(
 */
 static int fts3Rehash(Fts3Hash *pH, int new_size){
   struct _fts3ht *new_ht;          /* The new hash table */
-  Fts3HashElem *elem, *next_elem;  /* For looping over existing elements */
-  int (*xHash)(const void*,int);   /* The hash function */
+  Fts3HashElem *elem;              /* For looping over existing elements */
 
   assert( (new_size & (new_size-1))==0 );
+  assert( new_size>pH->count );
   new_ht = (struct _fts3ht *)fts3HashMalloc( new_size*sizeof(struct _fts3ht) );
   if( new_ht==0 ) return 1;
   fts3HashFree(pH->ht);
   pH->ht = new_ht;
   pH->htsize = new_size;
-  xHash = ftsHashFunction(pH->keyClass);
-  for(elem=pH->first, pH->first=0; elem; elem = next_elem){
-    int h = (*xHash)(elem->pKey, elem->nKey) & (new_size-1);
-    next_elem = elem->next;
-    fts3HashInsertElement(pH, &new_ht[h], elem);
+  for(elem=pH->first; elem; elem=elem->next){
+    fts3HashInsertSlot(pH, elem);
   }
   return 0;
 }
@@ -223,34 +245,29 @@ static Fts3HashElem *fts3FindElementByHash(
   int nKey,
   int h               /* The hash for this key. */
 ){
-  Fts3HashElem *elem;            /* Used to loop thru the element list */
-  int count;                     /* Number of elements left to test */
+  Fts3HashElem *elem;            /* Used to loop thru the slots */
   int (*xCompare)(const void*,int,const void*,int);  /* comparison function */
 
   if( pH->ht ){
-    struct _fts3ht *pEntry = &pH->ht[h];
-    elem = pEntry->chain;
-    count = pEntry->count;
+    int mask = pH->htsize-1;
+    int i;
     xCompare = ftsCompareFunction(pH->keyClass);
-    while( count-- && elem ){
-      if( (*xCompare)(elem->pKey,elem->nKey,pKey,nKey)==0 ){ 
+    for(i=h&mask; (elem = pH->ht[i].elem)!=0; i=(i+1)&mask){
+      if( pH->ht[i].h==h && (*xCompare)(elem->pKey,elem->nKey,pKey,nKey)==0 ){
         return elem;
       }
-      elem = elem->next;
     }
   }
   return 0;
 }
 
 /* Remove a single entry from the hash table given a pointer to that
-** element and a hash on the element's key.
+** element.
 */
-static void fts3RemoveElementByHash(
+static void fts3RemoveElement(
   Fts3Hash *pH,         /* The pH containing "elem" */
-  Fts3HashElem* elem,   /* The element to be removed from the pH */
-  int h                 /* Hash value for the element */
+  Fts3HashElem* elem    /* The element to be removed from the pH */
 ){
-  struct _fts3ht *pEntry;
   if( elem->prev ){
     elem->prev->next = elem->next; 
   }else{
@@ -259,17 +276,7 @@ static void fts3RemoveElementByHash(
   if( elem->next ){
     elem->next->prev = elem->prev;
   }
-  pEntry = &pH->ht[h];
-  if( pEntry->chain==elem ){
-    pEntry->chain = elem->next;
-  }
-  pEntry->count--;
-  if( pEntry->count<=0 ){
-    pEntry->chain = 0;
-  }
-  if( pH->copyKey && elem->pKey ){
-    fts3HashFree(elem->pKey);
-  }
+  fts3HashRemoveSlot(pH, elem);
   fts3HashFree( elem );
   pH->count--;
   if( pH->count<=0 ){
@@ -292,7 +299,7 @@ Fts3HashElem *sqlite3Fts3HashFindElem(
   assert( xHash!=0 );
   h = (*xHash)(pKey,nKey);
   assert( (pH->htsize & (pH->htsize-1))==0 );
-  return fts3FindElementByHash(pH,pKey,nKey, h & (pH->htsize-1));
+  return fts3FindElementByHash(pH,pKey,nKey,h);
 }
 
 /* 
@@ -328,54 +335,48 @@ void *sqlite3Fts3HashInsert(
   int nKey,            /* Number of bytes in the key */
   void *data           /* The data */
 ){
-  int hraw;                 /* Raw hash value of the key */
-  int h;                    /* the hash of the key modulo hash table size */
+  int h;                    /* Hash of the key */
   Fts3HashElem *elem;       /* Used to loop thru the element list */
   Fts3HashElem *new_elem;   /* New element added to the pH */
   int (*xHash)(const void*,int);  /* The hash function */
+  int nByte;                /* Bytes to allocate for the new element */
 
   assert( pH!=0 );
   xHash = ftsHashFunction(pH->keyClass);
   assert( xHash!=0 );
-  hraw = (*xHash)(pKey, nKey);
+  h = (*xHash)(pKey, nKey);
   assert( (pH->htsize & (pH->htsize-1))==0 );
-  h = hraw & (pH->htsize-1);
   elem = fts3FindElementByHash(pH,pKey,nKey,h);
   if( elem ){
     void *old_data = elem->data;
     if( data==0 ){
-      fts3RemoveElementByHash(pH,elem,h);
+      fts3RemoveElement(pH,elem);
     }else{
       elem->data = data;
     }
     return old_data;
   }
   if( data==0 ) return 0;
-  if( (pH->htsize==0 && fts3Rehash(pH,8))
-   || (pH->count>=pH->htsize && fts3Rehash(pH, pH->htsize*2))
+  if( (pH->htsize==0 && fts3Rehash(pH,16))
+   || ((pH->count+1)*4>pH->htsize*3 && fts3Rehash(pH, pH->htsize*2))
   ){
-    pH->count = 0;
     return data;
   }
   assert( pH->htsize>0 );
-  new_elem = (Fts3HashElem*)fts3HashMalloc( sizeof(Fts3HashElem) );
+  nByte = sizeof(Fts3HashElem);
+  if( pH->copyKey && pKey!=0 ) nByte += nKey;
+  new_elem = (Fts3HashElem*)fts3HashMalloc( nByte );
   if( new_elem==0 ) return data;
   if( pH->copyKey && pKey!=0 ){
-    new_elem->pKey = fts3HashMalloc( nKey );
-    if( new_elem->pKey==0 ){
-      fts3HashFree(new_elem);
-      return data;
-    }
-    memcpy((void*)new_elem->pKey, pKey, nKey);
+    new_elem->pKey = (void*)&new_elem[1];
+    memcpy(new_elem->pKey, pKey, nKey);
   }else{
     new_elem->pKey = (void*)pKey;
   }
   new_elem->nKey = nKey;
+  new_elem->h = h;
   pH->count++;
-  assert( pH->htsize>0 );
-  assert( (pH->htsize & (pH->htsize-1))==0 );
-  h = hraw & (pH->htsize-1);
-  fts3HashInsertElement(pH, &pH->ht[h], new_elem);
+  fts3HashInsertElement(pH, new_elem);
   new_elem->data = data;
   return 0;
 }
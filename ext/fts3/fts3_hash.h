@@ -28,16 +28,21 @@ typedef struct Fts3HashElem Fts3HashElem;
 ** However, many of the "procedures" and "functions" for modifying and
 ** accessing this structure are really macros, so we can't really make
 ** this structure opaque.
+**
+** As in the core hash table, Fts3Hash.ht is an open-addressing table of
+** Fts3Hash.htsize slots, each of which holds an element and a copy of
+** its full hash value. All elements are also on a single doubly-linked
+** list that starts at Fts3Hash.first.
 */
 struct Fts3Hash {
   char keyClass;          /* HASH_INT, _POINTER, _STRING, _BINARY */
   char copyKey;           /* True if copy of key made on insert */
   int count;              /* Number of entries in this table */
   Fts3HashElem *first;    /* The first element of the array */
-  int htsize;             /* Number of buckets in the hash table */
+  int htsize;             /* Number of slots in the hash table */
   struct _fts3ht {        /* the hash table */
-    int count;               /* Number of entries with this hash */
-    Fts3HashElem *chain;     /* Pointer to first entry with this hash */
+    int h;                   /* Hash of the key of elem */
+    Fts3HashElem *elem;      /* Element in this slot, or NULL if empty */
   } *ht;
 };
 
@@ -51,6 +56,7 @@ struct Fts3HashElem {
   Fts3HashElem *next, *prev; /* Next and previous elements in the table */
   void *data;                /* Data associated with this element */
   void *pKey; int nKey;      /* Key associated with this element */
+  int h;                     /* Hash of the key */
 };
 
 /*
@@ -63,7 +69,8 @@ struct Fts3HashElem {
 **   FTS3_HASH_BINARY        pKey points to binary data nKey bytes long. 
 **                           memcmp() is used to compare keys.
 **
-** A copy of the key is made if the copyKey parameter to fts3HashInit is 1.  
+** A copy of the key is made if the copyKey parameter to fts3HashInit is 1.
+** The copy is stored in the same allocation as the element itself.
 */
 #define FTS3_HASH_STRING    1
 #define FTS3_HASH_BINARY    2
@@ -57,13 +57,13 @@ LIBOBJ+= alter.o analyze.o attach.o auth.o \
          fts3_snippet.o fts3_tokenizer.o fts3_tokenizer1.o \
          fts3_write.o func.o global.o hash.o \
          icu.o insert.o journal.o legacy.o loadext.o \
-         main.o malloc.o mem0.o mem1.o mem2.o mem3.o mem5.o \
+         main.o malloc.o mem0.o mem1.o mem2.o mem3.o mem5.o mem6.o \
          memjournal.o \
          mutex.o mutex_noop.o mutex_os2.o mutex_unix.o mutex_w32.o \
          notify.o opcodes.o os.o os_os2.o os_unix.o os_win.o \
          pager.o parse.o pcache.o pcache1.o pragma.o prepare.o printf.o \
-         random.o resolve.o rowset.o rtree.o select.o status.o \
-         table.o tokenize.o trigger.o \
+         random.o resolve.o rowset.o rtree.o schemacache.o select.o \
+         status.o table.o tokenize.o trigger.o \
          update.o util.o vacuum.o \
          vdbe.o vdbeapi.o vdbeaux.o vdbeblob.o vdbemem.o vdbesort.o \
 	 vdbetrace.o wal.o walker.o where.o utf.o vtab.o
@@ -108,6 +108,7 @@ SRC = \
   $(TOP)/src/mem2.c \
   $(TOP)/src/mem3.c \
   $(TOP)/src/mem5.c \
+  $(TOP)/src/mem6.c \
   $(TOP)/src/memjournal.c \
   $(TOP)/src/mutex.c \
   $(TOP)/src/mutex.h \
@@ -134,6 +135,7 @@ SRC = \
   $(TOP)/src/random.c \
   $(TOP)/src/resolve.c \
   $(TOP)/src/rowset.c \
+  $(TOP)/src/schemacache.c \
   $(TOP)/src/select.c \
   $(TOP)/src/status.c \
   $(TOP)/src/shell.c \
@@ -278,6 +280,7 @@ TESTSRC2 = \
   $(TOP)/src/insert.c \
   $(TOP)/src/wal.c \
   $(TOP)/src/mem5.c \
+  $(TOP)/src/mem6.c \
   $(TOP)/src/os.c \
   $(TOP)/src/os_os2.c \
   $(TOP)/src/os_unix.c \
@@ -392,6 +392,7 @@ static void analyzeDatabase(Parse *pParse, int iDb){
   openStatTable(pParse, iDb, iStatCur, 0, 0);
   iMem = pParse->nMem+1;
   assert( sqlite3SchemaMutexHeld(db, iDb, 0) );
+  sqlite3LazyParseAll(db, iDb);
   for(k=sqliteHashFirst(&pSchema->tblHash); k; k=sqliteHashNext(k)){
     Table *pTab = (Table*)sqliteHashData(k);
     analyzeOneTable(pParse, pTab, 0, iStatCur, iMem);
@@ -500,8 +501,72 @@ typedef struct analysisInfo analysisInfo;
 struct analysisInfo {
   sqlite3 *db;
   const char *zDatabase;
+  Schema *pSchema;
 };
 
+/*
+** Decode the "stat" column of an sqlite_stat1 row for table pTable and
+** index pIndex, or for the table alone if pIndex is NULL.
+*/
+void sqlite3DecodeStat1(Table *pTable, Index *pIndex, const char *z){
+  int i, c, n;
+  unsigned int v;
+
+  n = pIndex ? pIndex->nColumn : 0;
+  for(i=0; *z && i<=n; i++){
+    v = 0;
+    while( (c=z[0])>='0' && c<='9' ){
+      v = v*10 + c - '0';
+      z++;
+    }
+    if( i==0 ) pTable->nRowEst = v;
+    if( pIndex==0 ) break;
+    pIndex->aiRowEst[i] = v;
+    if( *z==' ' ) z++;
+    if( memcmp(z, "unordered", 10)==0 ){
+      pIndex->bUnordered = 1;
+      break;
+    }
+  }
+}
+
+/*
+** If table zTab in the schema being loaded has not been parsed yet, save
+** an sqlite_stat1 row for it on its LazyTable, to be decoded when it is
+** parsed, and return 1. Otherwise return 0.
+*/
+static int analysisDefer(analysisInfo *pInfo, char **argv){
+  LazyTable *p;
+  LazyRow *pRow;
+  LazyRow **pp;
+  int nName;
+  int nStat;
+
+  p = sqlite3HashFind(&pInfo->pSchema->lazyHash, argv[0],
+                      sqlite3Strlen30(argv[0]));
+  if( p==0 || sqlite3StrICmp(p->zName, argv[0]) ) return 0;
+  nName = argv[1] ? sqlite3Strlen30(argv[1])+1 : 0;
+  nStat = sqlite3Strlen30(argv[2])+1;
+  pRow = (LazyRow*)sqlite3DbMallocRaw(0, sizeof(LazyRow) + nName + nStat);
+  if( pRow==0 ){
+    pInfo->db->mallocFailed = 1;
+    return 1;
+  }
+  pRow->zSql = (char*)&pRow[1];
+  memcpy(pRow->zSql, argv[2], nStat);
+  if( argv[1] ){
+    pRow->zName = &pRow->zSql[nStat];
+    memcpy(pRow->zName, argv[1], nName);
+  }else{
+    pRow->zName = 0;
+  }
+  pRow->iRoot = 0;
+  pRow->pNext = 0;
+  for(pp=&p->pStat; *pp; pp=&(*pp)->pNext);
+  *pp = pRow;
+  return 1;
+}
+
 /*
 ** This callback is invoked once for each index when reading the
 ** sqlite_stat1 table.  
@@ -517,9 +582,6 @@ static int analysisLoader(void *pData, int argc, char **argv, char **NotUsed){
   analysisInfo *pInfo = (analysisInfo*)pData;
   Index *pIndex;
   Table *pTable;
-  int i, c, n;
-  unsigned int v;
-  const char *z;
 
   assert( argc==3 );
   UNUSED_PARAMETER2(NotUsed, argc);
@@ -527,6 +589,9 @@ static int analysisLoader(void *pData, int argc, char **argv, char **NotUsed){
   if( argv==0 || argv[0]==0 || argv[2]==0 ){
     return 0;
   }
+  if( pInfo->pSchema->pLazy && analysisDefer(pInfo, argv) ){
+    return 0;
+  }
   pTable = sqlite3FindTable(pInfo->db, argv[0], pInfo->zDatabase);
   if( pTable==0 ){
     return 0;
@@ -536,23 +601,7 @@ static int analysisLoader(void *pData, int argc, char **argv, char **NotUsed){
   }else{
     pIndex = 0;
   }
-  n = pIndex ? pIndex->nColumn : 0;
-  z = argv[2];
-  for(i=0; *z && i<=n; i++){
-    v = 0;
-    while( (c=z[0])>='0' && c<='9' ){
-      v = v*10 + c - '0';
-      z++;
-    }
-    if( i==0 ) pTable->nRowEst = v;
-    if( pIndex==0 ) break;
-    pIndex->aiRowEst[i] = v;
-    if( *z==' ' ) z++;
-    if( memcmp(z, "unordered", 10)==0 ){
-      pIndex->bUnordered = 1;
-      break;
-    }
-  }
+  sqlite3DecodeStat1(pTable, pIndex, argv[2]);
   return 0;
 }
 
@@ -601,6 +650,7 @@ void sqlite3DeleteIndexSamples(sqlite3 *db, Index *pIdx){
 int sqlite3AnalysisLoad(sqlite3 *db, int iDb){
   analysisInfo sInfo;
   HashElem *i;
+  LazyTable *pLazy;
   char *zSql;
   int rc;
 
@@ -615,10 +665,18 @@ int sqlite3AnalysisLoad(sqlite3 *db, int iDb){
     sqlite3DeleteIndexSamples(db, pIdx);
     pIdx->aSample = 0;
   }
+  for(pLazy=db->aDb[iDb].pSchema->pLazy; pLazy; pLazy=pLazy->pNext){
+    LazyRow *pRow;
+    while( (pRow = pLazy->pStat)!=0 ){
+      pLazy->pStat = pRow->pNext;
+      sqlite3DbFree(db, pRow);
+    }
+  }
 
   /* Check to make sure the sqlite_stat1 table exists */
   sInfo.db = db;
   sInfo.zDatabase = db->aDb[iDb].zName;
+  sInfo.pSchema = db->aDb[iDb].pSchema;
   if( sqlite3FindTable(db, "sqlite_stat1", sInfo.zDatabase)==0 ){
     return SQLITE_ERROR;
   }
@@ -2499,6 +2499,20 @@ static int newDatabase(BtShared *pBt){
   return SQLITE_OK;
 }
 
+/*
+** Return true if the database connection that owns Btree p has begun a
+** BEGIN CONCURRENT transaction. Such transactions are not supported on 
+** a shared cache in use by more than one connection, for which this 
+** routine always returns false. The sharable flag alone is not tested,
+** as in debug builds it is set for all persistent databases.
+*/
+static int btreeIsConcurrent(Btree *p){
+#ifndef SQLITE_OMIT_SHARED_CACHE
+  if( p->sharable && p->pBt->nRef>1 ) return 0;
+#endif
+  return p->db->isConcurrent && !p->db->autoCommit;
+}
+
 /*
 ** Attempt to start a new transaction. A write-transaction
 ** is started if the second argument is nonzero, otherwise a read-
@@ -2533,6 +2547,14 @@ static int newDatabase(BtShared *pBt){
 ** no progress.  By returning SQLITE_BUSY and not invoking the busy callback
 ** when A already has a read lock, we encourage A to give up and let B
 ** proceed.
+**
+** Within a BEGIN CONCURRENT transaction on a WAL database, a write
+** transaction does not lock out other writers. The WAL write lock is 
+** only taken when the transaction commits (see sqlite3PagerSetConcurrent()).
+** This requires that every page read from the read snapshot is recorded,
+** so it only applies if the snapshot is opened within the BEGIN CONCURRENT
+** transaction. If a statement started before it still holds an older 
+** read transaction open, the write lock is taken as for BEGIN DEFERRED.
 */
 int sqlite3BtreeBeginTrans(Btree *p, int wrflag){
   sqlite3 *pBlock = 0;
@@ -2596,6 +2618,9 @@ int sqlite3BtreeBeginTrans(Btree *p, int wrflag){
     */
     while( pBt->pPage1==0 && SQLITE_OK==(rc = lockBtree(pBt)) );
 
+    if( rc==SQLITE_OK && pBt->inTransaction==TRANS_NONE ){
+      sqlite3PagerSetConcurrent(pBt->pPager, btreeIsConcurrent(p));
+    }
     if( rc==SQLITE_OK && wrflag ){
       if( pBt->readOnly ){
         rc = SQLITE_READONLY;
@@ -3007,6 +3032,34 @@ int sqlite3BtreeIncrVacuum(Btree *p){
   return rc;
 }
 
+/*
+** If a BEGIN CONCURRENT write transaction is open on b-tree p, obtain the
+** WAL write lock for it and check that it does not conflict with the
+** transactions committed by other connections since its snapshot was
+** taken (see sqlite3PagerLockForCommit()). Otherwise, this is a no-op.
+*/
+int sqlite3BtreeLockForCommit(Btree *p){
+  int rc = SQLITE_OK;
+  if( p && p->inTrans==TRANS_WRITE ){
+    sqlite3BtreeEnter(p);
+    rc = sqlite3PagerLockForCommit(p->pBt->pPager);
+    sqlite3BtreeLeave(p);
+  }
+  return rc;
+}
+
+/*
+** Release the WAL write lock obtained by sqlite3BtreeLockForCommit(), if
+** any. The BEGIN CONCURRENT transaction remains open.
+*/
+void sqlite3BtreeUnlockForCommit(Btree *p){
+  if( p && p->inTrans==TRANS_WRITE ){
+    sqlite3BtreeEnter(p);
+    sqlite3PagerUnlockForCommit(p->pBt->pPager);
+    sqlite3BtreeLeave(p);
+  }
+}
+
 /*
 ** This routine is called prior to sqlite3PagerCommit when a transaction
 ** is commited for an auto-vacuum database.
@@ -3844,6 +3897,9 @@ static int accessPayload(
   int iIdx = 0;
   MemPage *pPage = pCur->apPage[pCur->iPage]; /* Btree page of current entry */
   BtShared *pBt = pCur->pBt;                  /* Btree this cursor belongs to */
+#ifndef SQLITE_OMIT_DIRECT_OVERFLOW_READ
+  unsigned char * const pBufStart = pBuf;     /* Start of output buffer */
+#endif
 
   assert( pPage );
   assert( pCur->eState==CURSOR_VALID );
@@ -3878,6 +3934,10 @@ static int accessPayload(
   if( rc==SQLITE_OK && amt>0 ){
     const u32 ovflSize = pBt->usableSize - 4;  /* Bytes content per ovfl page */
     Pgno nextPage;
+    /* True if this is a big payload. Small ones are better off cached
+    ** in case they are read again. */
+    const int bBig = (pCur->info.nPayload - pCur->info.nLocal)
+                                    > ovflSize*BTREE_BIG_PAYLOAD;
 
     nextPage = get4byte(&aPayload[pCur->info.nLocal]);
 
@@ -3940,14 +4000,43 @@ static int accessPayload(
         */
         DbPage *pDbPage;
         int a = amt;
+        if( a + offset > ovflSize ){
+          a = ovflSize - offset;
+        }
+
+#ifndef SQLITE_OMIT_DIRECT_OVERFLOW_READ
+        /* If this is a read of a large payload that starts at the 
+        ** beginning of the overflow page content, and the page is not in
+        ** the page cache and may be read directly from the database file
+        ** (see sqlite3PagerDirectReadOk()), then read the page straight 
+        ** into the output buffer instead of loading it into the cache and
+        ** copying it out. The 4 bytes of the buffer immediately before 
+        ** pBuf (which must not precede the start of the buffer) are 
+        ** temporarily overwritten with the next-page pointer from the
+        ** page header.
+        */
+        if( bBig && eOp==0 && offset==0 && &pBuf[-4]>=pBufStart
+         && sqlite3PagerDirectReadOk(pBt->pPager, nextPage)
+        ){
+          sqlite3_file *fd = sqlite3PagerFile(pBt->pPager);
+          u8 aSave[4];
+          u8 *aWrite = &pBuf[-4];
+          memcpy(aSave, aWrite, 4);
+          rc = sqlite3OsRead(fd, aWrite, a+4, (i64)pBt->pageSize*(nextPage-1));
+          nextPage = get4byte(aWrite);
+          memcpy(aWrite, aSave, 4);
+          amt -= a;
+          pBuf += a;
+          continue;
+        }
+#endif
+
         rc = sqlite3PagerGet(pBt->pPager, nextPage, &pDbPage);
         if( rc==SQLITE_OK ){
           aPayload = sqlite3PagerGetData(pDbPage);
           nextPage = get4byte(aPayload);
-          if( a + offset > ovflSize ){
-            a = ovflSize - offset;
-          }
           rc = copyPayload(&aPayload[offset+4], pBuf, a, eOp, pDbPage);
+          if( bBig ) sqlite3PagerReuseUnlikely(pDbPage);
           sqlite3PagerUnref(pDbPage);
           offset = 0;
           amt -= a;
@@ -4221,6 +4310,7 @@ static int moveToRoot(BtCursor *pCur){
     sqlite3BtreeClearCursor(pCur);
   }
 
+  pCur->nLeafStep = 0;
   if( pCur->iPage>=0 ){
     int i;
     for(i=1; i<=pCur->iPage; i++){
@@ -4320,7 +4410,7 @@ static int moveToRightmost(BtCursor *pCur){
     rc = moveToChild(pCur, pgno);
   }
   if( rc==SQLITE_OK ){
-    pCur->aiIdx[pCur->iPage] = pPage->nCell-1;
+    pCur->aiIdx[pCur->iPage] = (u16)(pPage->nCell-1);
     pCur->info.nSize = 0;
     pCur->validNKey = 0;
   }
@@ -4390,6 +4480,165 @@ int sqlite3BtreeLast(BtCursor *pCur, int *pRes){
   return rc;
 }
 
+/*
+** Compare the index key stored in the cell that cursor pCur currently
+** points to with the unpacked key pIdxKey. The page that pCur points to
+** must be an index b-tree page. If successful, SQLITE_OK is returned and
+** *pRes is set to a value less than, equal to or greater than zero 
+** according to the value returned by sqlite3VdbeRecordCompare(). 
+** Otherwise, an SQLite error code is returned.
+*/
+static int btreeCompareIdxCell(
+  BtCursor *pCur,          /* Cursor pointing at the cell to compare */
+  UnpackedRecord *pIdxKey, /* Key to compare against */
+  int *pRes                /* OUT: Result of comparison */
+){
+  MemPage *pPage = pCur->apPage[pCur->iPage];
+  u8 *pCell = findCell(pPage, pCur->aiIdx[pCur->iPage]) + pPage->childPtrSize;
+  int nCell;
+
+  assert( pPage->intKey==0 );
+
+  /* The maximum supported page-size is 65536 bytes. This means that
+  ** the maximum number of record bytes stored on an index B-Tree
+  ** page is less than 16384 bytes and may be stored as a 2-byte
+  ** varint. This information is used to attempt to avoid parsing 
+  ** the entire cell by checking for the cases where the record is 
+  ** stored entirely within the b-tree page by inspecting the first 
+  ** 2 bytes of the cell.
+  */
+  nCell = pCell[0];
+  if( !(nCell & 0x80) && nCell<=pPage->maxLocal ){
+    /* This branch runs if the record-size field of the cell is a
+    ** single byte varint and the record fits entirely on the main
+    ** b-tree page.  */
+    *pRes = sqlite3VdbeRecordCompare(nCell, (void*)&pCell[1], pIdxKey);
+  }else if( !(pCell[1] & 0x80) 
+    && (nCell = ((nCell&0x7f)<<7) + pCell[1])<=pPage->maxLocal
+  ){
+    /* The record-size field is a 2 byte varint and the record 
+    ** fits entirely on the main b-tree page.  */
+    *pRes = sqlite3VdbeRecordCompare(nCell, (void*)&pCell[2], pIdxKey);
+  }else{
+    /* The record flows over onto one or more overflow pages. In
+    ** this case the whole cell needs to be parsed, a buffer allocated
+    ** and accessPayload() used to retrieve the record into the
+    ** buffer before VdbeRecordCompare() can be called. */
+    int rc;
+    void *pCellKey;
+    u8 * const pCellBody = pCell - pPage->childPtrSize;
+    btreeParseCellPtr(pPage, pCellBody, &pCur->info);
+    nCell = (int)pCur->info.nKey;
+    pCellKey = sqlite3Malloc( nCell );
+    if( pCellKey==0 ){
+      return SQLITE_NOMEM;
+    }
+    rc = accessPayload(pCur, 0, nCell, (unsigned char*)pCellKey, 0);
+    if( rc ){
+      sqlite3_free(pCellKey);
+      return rc;
+    }
+    *pRes = sqlite3VdbeRecordCompare(nCell, pCellKey, pIdxKey);
+    sqlite3_free(pCellKey);
+  }
+  return SQLITE_OK;
+}
+
+/*
+** Compare the key of the cell that cursor pCur currently points to with
+** intKey (for an intkey b-tree) or pIdxKey (for an index b-tree). Set
+** *pRes to a value less than, equal to or greater than zero if the cell
+** key is smaller than, equal to or larger than the search key.
+*/
+static int btreeCompareCell(
+  BtCursor *pCur,          /* Cursor pointing at the cell to compare */
+  UnpackedRecord *pIdxKey, /* Key to compare against for index b-trees */
+  i64 intKey,              /* Key to compare against for intkey b-trees */
+  int *pRes                /* OUT: Result of comparison */
+){
+  MemPage *pPage = pCur->apPage[pCur->iPage];
+  if( pPage->intKey ){
+    i64 nCellKey;
+    u8 *pCell = findCell(pPage, pCur->aiIdx[pCur->iPage]) + pPage->childPtrSize;
+    if( pPage->hasData ){
+      u32 dummy;
+      pCell += getVarint32(pCell, dummy);
+    }
+    getVarint(pCell, (u64*)&nCellKey);
+    *pRes = (nCellKey<intKey) ? -1 : (nCellKey>intKey);
+    return SQLITE_OK;
+  }
+  return btreeCompareIdxCell(pCur, pIdxKey, pRes);
+}
+
+/*
+** Cursor pCur points to a valid entry on a page other than the root
+** page. This routine is called by sqlite3BtreeMovetoUnpacked() to check 
+** if the key being sought lies within the sub-tree rooted at the page
+** the cursor currently points into, or within the sub-tree rooted at 
+** the parent of that page. If so, the cursor is moved up to the root of
+** that sub-tree and *pbLocal set to true, so that the search may start
+** from there instead of from the root page. Otherwise, *pbLocal is set 
+** to false and the cursor is left pointing at an arbitrary page.
+**
+** A key lies within the sub-tree rooted at page P if it is greater than
+** the first cell on P and less than the last (an intkey b-tree may also
+** match the last cell, or the first if P is a leaf). This usually 
+** succeeds when successive seeks use nearby keys, as for example when 
+** the inner loop of a join is driven by an ordered outer loop.
+**
+** If several consecutive checks on a cursor fail, the check is skipped
+** for the next few seeks so that cursors used for random lookups do not
+** pay for the extra comparisons.
+*/
+static int btreeSeekLocal(
+  BtCursor *pCur,          /* The cursor to be moved */
+  UnpackedRecord *pIdxKey, /* Unpacked index key */
+  i64 intKey,              /* The table key */
+  int *pbLocal             /* OUT: True if search may start at current page */
+){
+  int i;
+  *pbLocal = 0;
+  assert( pCur->eState==CURSOR_VALID && pCur->iPage>0 );
+
+  if( pCur->nSeekMiss>=4 ){
+    if( ++pCur->nSeekMiss>=32 ) pCur->nSeekMiss = 3;
+    return SQLITE_OK;
+  }
+
+  for(i=0; i<2 && pCur->iPage>0; i++){
+    MemPage *pPage = pCur->apPage[pCur->iPage];
+    int c;
+    int rc;
+    if( pPage->nCell==0 ) break;
+
+    /* Compare with the last cell on the page first. When seeking through
+    ** keys in ascending order, this is the test that usually fails. */
+    pCur->aiIdx[pCur->iPage] = (u16)(pPage->nCell-1);
+    pCur->info.nSize = 0;
+    rc = btreeCompareCell(pCur, pIdxKey, intKey, &c);
+    if( rc ) return rc;
+    if( c>0 || (c==0 && pPage->intKey) ){
+      pCur->aiIdx[pCur->iPage] = 0;
+      pCur->info.nSize = 0;
+      rc = btreeCompareCell(pCur, pIdxKey, intKey, &c);
+      if( rc ) return rc;
+      if( c<0 || (c==0 && pPage->intKey && pPage->leaf) ){
+        pCur->info.nSize = 0;
+        pCur->validNKey = 0;
+        pCur->atLast = 0;
+        pCur->nSeekMiss = 0;
+        *pbLocal = 1;
+        return SQLITE_OK;
+      }
+    }
+    moveToParent(pCur);
+  }
+
+  pCur->nSeekMiss++;
+  return SQLITE_OK;
+}
+
 /* Move the cursor so that it points to an entry near the key 
 ** specified by pIdxKey or intKey.   Return a success code.
 **
@@ -4426,6 +4675,7 @@ int sqlite3BtreeMovetoUnpacked(
   int *pRes                /* Write search results here */
 ){
   int rc;
+  int bLocal = 0;          /* True to start the search below the root */
 
   assert( cursorHoldsMutex(pCur) );
   assert( sqlite3_mutex_held(pCur->pBtree->db->mutex) );
@@ -4438,18 +4688,34 @@ int sqlite3BtreeMovetoUnpacked(
    && pCur->apPage[0]->intKey 
   ){
     if( pCur->info.nKey==intKey ){
+      pCur->pBtree->nSeekLocal++;
       *pRes = 0;
       return SQLITE_OK;
     }
     if( pCur->atLast && pCur->info.nKey<intKey ){
+      pCur->pBtree->nSeekLocal++;
       *pRes = -1;
       return SQLITE_OK;
     }
   }
 
-  rc = moveToRoot(pCur);
-  if( rc ){
-    return rc;
+  /* If the cursor points into a page other than the root, check if the
+  ** search can start from that page or its parent. Otherwise, start
+  ** from the root page. */
+  if( pCur->eState==CURSOR_VALID && pCur->iPage>0 ){
+    rc = btreeSeekLocal(pCur, pIdxKey, intKey, &bLocal);
+    if( rc ){
+      return rc;
+    }
+  }
+  if( bLocal ){
+    pCur->pBtree->nSeekLocal++;
+  }else{
+    pCur->pBtree->nSeekRoot++;
+    rc = moveToRoot(pCur);
+    if( rc ){
+      return rc;
+    }
   }
   assert( pCur->pgnoRoot==0 || pCur->apPage[pCur->iPage] );
   assert( pCur->pgnoRoot==0 || pCur->apPage[pCur->iPage]->isInit );
@@ -4505,48 +4771,8 @@ int sqlite3BtreeMovetoUnpacked(
         pCur->validNKey = 1;
         pCur->info.nKey = nCellKey;
       }else{
-        /* The maximum supported page-size is 65536 bytes. This means that
-        ** the maximum number of record bytes stored on an index B-Tree
-        ** page is less than 16384 bytes and may be stored as a 2-byte
-        ** varint. This information is used to attempt to avoid parsing 
-        ** the entire cell by checking for the cases where the record is 
-        ** stored entirely within the b-tree page by inspecting the first 
-        ** 2 bytes of the cell.
-        */
-        int nCell = pCell[0];
-        if( !(nCell & 0x80) && nCell<=pPage->maxLocal ){
-          /* This branch runs if the record-size field of the cell is a
-          ** single byte varint and the record fits entirely on the main
-          ** b-tree page.  */
-          c = sqlite3VdbeRecordCompare(nCell, (void*)&pCell[1], pIdxKey);
-        }else if( !(pCell[1] & 0x80) 
-          && (nCell = ((nCell&0x7f)<<7) + pCell[1])<=pPage->maxLocal
-        ){
-          /* The record-size field is a 2 byte varint and the record 
-          ** fits entirely on the main b-tree page.  */
-          c = sqlite3VdbeRecordCompare(nCell, (void*)&pCell[2], pIdxKey);
-        }else{
-          /* The record flows over onto one or more overflow pages. In
-          ** this case the whole cell needs to be parsed, a buffer allocated
-          ** and accessPayload() used to retrieve the record into the
-          ** buffer before VdbeRecordCompare() can be called. */
-          void *pCellKey;
-          u8 * const pCellBody = pCell - pPage->childPtrSize;
-          btreeParseCellPtr(pPage, pCellBody, &pCur->info);
-          nCell = (int)pCur->info.nKey;
-          pCellKey = sqlite3Malloc( nCell );
-          if( pCellKey==0 ){
-            rc = SQLITE_NOMEM;
-            goto moveto_finish;
-          }
-          rc = accessPayload(pCur, 0, nCell, (unsigned char*)pCellKey, 0);
-          if( rc ){
-            sqlite3_free(pCellKey);
-            goto moveto_finish;
-          }
-          c = sqlite3VdbeRecordCompare(nCell, pCellKey, pIdxKey);
-          sqlite3_free(pCellKey);
-        }
+        rc = btreeCompareIdxCell(pCur, pIdxKey, &c);
+        if( rc ) goto moveto_finish;
       }
       if( c==0 ){
         if( pPage->intKey && !pPage->leaf ){
@@ -4594,6 +4820,103 @@ moveto_finish:
   return rc;
 }
 
+/*
+** Cursor pCur is open on an index b-tree and the caller is about to
+** seek it to the first entry that is greater than or equal to pIdxKey
+** (or strictly greater, if pIdxKey has the UNPACKED_INCRKEY flag set).
+** If the keys being sought arrive in ascending order, as they do when
+** iterating through the sorted values on the RHS of an IN operator,
+** the target entry is often on the same leaf page as the current entry
+** or on its right-hand sibling. This routine tries to find it there by
+** moving forward from the current position, without returning to the
+** root page.
+**
+** If the target entry is found, the cursor is left pointing at it and
+** *pRes is set to 1. Otherwise *pRes is set to 0 and the cursor is left
+** at some unspecified position, so the caller must fall back to 
+** sqlite3BtreeMovetoUnpacked(). The search is abandoned without doing
+** any work unless the cursor currently points to a valid entry that is
+** smaller than pIdxKey.
+*/
+int sqlite3BtreeSeekForward(
+  BtCursor *pCur,          /* The cursor to be moved */
+  UnpackedRecord *pIdxKey, /* Unpacked index key */
+  int *pRes                /* OUT: True if the cursor was moved */
+){
+  int rc = SQLITE_OK;
+  int nLeaf = 0;           /* Number of leaf pages visited */
+  int bSkip = 1;           /* True if current entry is known to be small */
+  int c;                   /* Result of key comparison */
+
+  assert( cursorHoldsMutex(pCur) );
+  assert( sqlite3_mutex_held(pCur->pBtree->db->mutex) );
+  assert( pIdxKey && pCur->pKeyInfo );
+
+  *pRes = 0;
+  if( pCur->eState!=CURSOR_VALID || pCur->skipNext!=0 ){
+    return SQLITE_OK;
+  }
+  assert( pCur->apPage[0]->intKey==0 );
+
+  /* The cursor must currently point to an entry smaller than the key.
+  ** Otherwise the target might lie anywhere to the left of it. */
+  rc = btreeCompareIdxCell(pCur, pIdxKey, &c);
+  if( rc!=SQLITE_OK || c>=0 ) return rc;
+
+  for(;;){
+    MemPage *pPage = pCur->apPage[pCur->iPage];
+    int res;
+    if( pPage->leaf ){
+      /* Binary search the remainder of this leaf for the first entry 
+      ** that is not smaller than the key. The last cell is tested first
+      ** so that a key that lies beyond this leaf costs one comparison. */
+      int lwr = pCur->aiIdx[pCur->iPage]+bSkip;
+      int upr = pPage->nCell-1;
+      nLeaf++;
+      if( lwr<=upr ){
+        pCur->aiIdx[pCur->iPage] = (u16)upr;
+        pCur->info.nSize = 0;
+        pCur->validNKey = 0;
+        rc = btreeCompareIdxCell(pCur, pIdxKey, &c);
+        if( rc ) return rc;
+        if( c>=0 ){
+          upr--;
+          while( lwr<=upr ){
+            int idx = (lwr+upr)/2;
+            pCur->aiIdx[pCur->iPage] = (u16)idx;
+            pCur->info.nSize = 0;
+            rc = btreeCompareIdxCell(pCur, pIdxKey, &c);
+            if( rc ) return rc;
+            if( c<0 ){
+              lwr = idx+1;
+            }else{
+              upr = idx-1;
+            }
+          }
+          pCur->aiIdx[pCur->iPage] = (u16)lwr;
+          pCur->info.nSize = 0;
+          pCur->pBtree->nSeekLocal++;
+          *pRes = 1;
+          return SQLITE_OK;
+        }
+      }
+      if( nLeaf>=2 ) return SQLITE_OK;
+    }else if( !bSkip ){
+      /* The cursor points to a divider cell on an interior page. */
+      rc = btreeCompareIdxCell(pCur, pIdxKey, &c);
+      if( rc ) return rc;
+      if( c>=0 ){
+        pCur->pBtree->nSeekLocal++;
+        *pRes = 1;
+        return SQLITE_OK;
+      }
+    }
+    rc = sqlite3BtreeNext(pCur, &res);
+    if( rc!=SQLITE_OK || res ) return rc;
+    bSkip = 0;
+  }
+}
+
 
 /*
 ** Return TRUE if the cursor is not pointing at an entry of the table.
@@ -4610,6 +4933,47 @@ int sqlite3BtreeEof(BtCursor *pCur){
   return (CURSOR_VALID!=pCur->eState);
 }
 
+/*
+** Cursor pCur has just moved up from a leaf page to its parent in the 
+** course of an in-order scan of the b-tree, and will next descend into
+** the child of cell aiIdx+1 of the parent (or its right-child). Ask the
+** pager to prefetch the leaf pages that follow, up to BTREE_PREFETCH 
+** children ahead of the current position.
+**
+** Once a set of leaves has been hinted, no further hints are sent until
+** the cursor is half-way through them, so that each leaf is only passed
+** to the pager once.
+*/
+static void btreePrefetchLeaves(BtCursor *pCur){
+  MemPage *pPage = pCur->apPage[pCur->iPage];
+  int iNext = pCur->aiIdx[pCur->iPage] + 1;
+  int iFirst = iNext;
+  int iLast;
+  int i;
+  int nPgno = 0;
+  Pgno aPgno[BTREE_PREFETCH];
+
+  assert( !pPage->leaf );
+  if( pCur->pgnoPrefetch==pPage->pgno && pCur->iPrefetch>=iNext ){
+    if( pCur->iPrefetch>=iNext+BTREE_PREFETCH/2 ) return;
+    iFirst = pCur->iPrefetch+1;
+  }
+  iLast = iNext + BTREE_PREFETCH - 1;
+  if( iLast>pPage->nCell ) iLast = pPage->nCell;
+  for(i=iFirst; i<=iLast; i++){
+    if( i==pPage->nCell ){
+      aPgno[nPgno++] = get4byte(&pPage->aData[pPage->hdrOffset+8]);
+    }else{
+      aPgno[nPgno++] = get4byte(findCell(pPage, i));
+    }
+  }
+  if( nPgno>0 ){
+    sqlite3PagerPrefetch(pCur->pBt->pPager, nPgno, aPgno);
+  }
+  pCur->pgnoPrefetch = pPage->pgno;
+  pCur->iPrefetch = (u16)iLast;
+}
+
 /*
 ** Advance the cursor to the next entry in the database.  If
 ** successful then set *pRes=0.  If the cursor
@@ -4646,6 +5010,7 @@ int sqlite3BtreeNext(BtCursor *pCur, int *pRes){
   pCur->info.nSize = 0;
   pCur->validNKey = 0;
   if( idx>=pPage->nCell ){
+    int iLeaf = pCur->iPage;
     if( !pPage->leaf ){
       rc = moveToChild(pCur, get4byte(&pPage->aData[pPage->hdrOffset+8]));
       if( rc ) return rc;
@@ -4662,6 +5027,13 @@ int sqlite3BtreeNext(BtCursor *pCur, int *pRes){
       moveToParent(pCur);
       pPage = pCur->apPage[pCur->iPage];
     }while( pCur->aiIdx[pCur->iPage]>=pPage->nCell );
+    if( pCur->iPage==iLeaf-1 ){
+      if( pCur->nLeafStep<BTREE_PREFETCH_AFTER ){
+        pCur->nLeafStep++;
+      }else{
+        btreePrefetchLeaves(pCur);
+      }
+    }
     *pRes = 0;
     if( pPage->intKey ){
       rc = sqlite3BtreeNext(pCur, pRes);
@@ -5176,6 +5548,7 @@ static int clearCell(MemPage *pPage, unsigned char *pCell){
   Pgno ovflPgno;
   int rc;
   int nOvfl;
+  int bBig;                       /* True if this is a big payload */
   u32 ovflPageSize;
 
   assert( sqlite3_mutex_held(pPage->pBt->mutex) );
@@ -5191,6 +5564,7 @@ static int clearCell(MemPage *pPage, unsigned char *pCell){
   ovflPageSize = pBt->usableSize - 4;
   nOvfl = (info.nPayload - info.nLocal + ovflPageSize - 1)/ovflPageSize;
   assert( ovflPgno==0 || nOvfl>0 );
+  bBig = nOvfl>BTREE_BIG_PAYLOAD;
   while( nOvfl-- ){
     Pgno iNext = 0;
     MemPage *pOvfl = 0;
@@ -5224,6 +5598,7 @@ static int clearCell(MemPage *pPage, unsigned char *pCell){
     }
 
     if( pOvfl ){
+      if( bBig ) sqlite3PagerReuseUnlikely(pOvfl->pDbPage);
       sqlite3PagerUnref(pOvfl->pDbPage);
     }
     if( rc ) return rc;
@@ -5263,6 +5638,7 @@ static int fillInCell(
   BtShared *pBt = pPage->pBt;
   Pgno pgnoOvfl = 0;
   int nHeader;
+  int bBig;                      /* True if this is a big payload */
   CellInfo info;
 
   assert( sqlite3_mutex_held(pPage->pBt->mutex) );
@@ -5306,6 +5682,7 @@ static int fillInCell(
   spaceLeft = info.nLocal;
   pPayload = &pCell[nHeader];
   pPrior = &pCell[info.iOverflow];
+  bBig = (u32)(nPayload - info.nLocal) > (pBt->usableSize-4)*BTREE_BIG_PAYLOAD;
 
   while( nPayload>0 ){
     if( spaceLeft==0 ){
@@ -5356,6 +5733,7 @@ static int fillInCell(
       put4byte(pPrior, pgnoOvfl);
       releasePage(pToRelease);
       pToRelease = pOvfl;
+      if( bBig ) sqlite3PagerReuseUnlikely(pOvfl->pDbPage);
       pPrior = pOvfl->aData;
       put4byte(pPrior, 0);
       pPayload = &pOvfl->aData[4];
@@ -7432,6 +7810,21 @@ int sqlite3BtreeCount(BtCursor *pCur, i64 *pnEntry){
 }
 #endif
 
+/*
+** Return the number of seeks performed on b-tree p since it was opened
+** or since the count was last reset. If bLocal is true, the number of
+** seeks that did not need to start from the root page is returned. 
+** Otherwise, the number of seeks that did. If resetFlag is true, the 
+** count is zeroed before returning.
+*/
+int sqlite3BtreeSeekCount(Btree *p, int bLocal, int resetFlag){
+  int *pnSeek = bLocal ? &p->nSeekLocal : &p->nSeekRoot;
+  int nSeek = *pnSeek;
+  assert( sqlite3BtreeHoldsMutex(p) );
+  if( resetFlag ) *pnSeek = 0;
+  return nSeek;
+}
+
 /*
 ** Return the pager associated with a BTree.  This routine is used for
 ** testing and debugging only.
@@ -349,6 +349,8 @@ struct Btree {
   int nBackup;       /* Number of backup operations reading this btree */
   Btree *pNext;      /* List of other sharable Btrees from the same db */
   Btree *pPrev;      /* Back pointer of the same list */
+  int nSeekLocal;    /* Seeks that did not start from the root page */
+  int nSeekRoot;     /* Seeks that started from the root page */
 #ifndef SQLITE_OMIT_SHARED_CACHE
   BtLock lock;       /* Object used to lock page 1 */
 #endif
@@ -496,6 +498,10 @@ struct BtCursor {
   u8 atLast;                /* Cursor pointing to the last entry */
   u8 validNKey;             /* True if info.nKey is valid */
   u8 eState;                /* One of the CURSOR_XXX constants (see below) */
+  u8 nSeekMiss;             /* Recent seeks that could not be done locally */
+  u8 nLeafStep;             /* Leaf-to-leaf steps since cursor was moved */
+  u16 iPrefetch;            /* Last child of pgnoPrefetch prefetched */
+  Pgno pgnoPrefetch;        /* Parent page of last prefetched leaves */
 #ifndef SQLITE_OMIT_INCRBLOB
   Pgno *aOverflow;          /* Cache of overflow page locations */
   u8 isIncrblobHandle;      /* True if this cursor is an incr. io handle */
@@ -505,6 +511,26 @@ struct BtCursor {
   MemPage *apPage[BTCURSOR_MAX_DEPTH];  /* Pages from root to current page */
 };
 
+/*
+** A payload that spans more than this many overflow pages is a "big"
+** payload. The overflow pages of big payloads are kept out of the page
+** cache as far as possible: they are read directly from the database file
+** into the output buffer where this is safe (see accessPayload()), and
+** are otherwise evicted from the cache as soon as they are clean and
+** unreferenced (see sqlite3PagerReuseUnlikely()).
+*/
+#define BTREE_BIG_PAYLOAD 16
+
+/*
+** Once a cursor has stepped from one leaf page to the next more than
+** BTREE_PREFETCH_AFTER times without being moved to the root, it is
+** assumed to be scanning the b-tree in order. From then on, each time
+** sqlite3BtreeNext() moves onto a new leaf it asks the pager to prefetch
+** the next BTREE_PREFETCH sibling leaves (see btreePrefetchLeaves()).
+*/
+#define BTREE_PREFETCH_AFTER 2
+#define BTREE_PREFETCH 8
+
 /*
 ** Potential values for BtCursor.eState.
 **
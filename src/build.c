@@ -277,6 +277,10 @@ Table *sqlite3FindTable(sqlite3 *db, const char *zName, const char *zDatabase){
     if( zDatabase!=0 && sqlite3StrICmp(zDatabase, db->aDb[j].zName) ) continue;
     assert( sqlite3SchemaMutexHeld(db, j, 0) );
     p = sqlite3HashFind(&db->aDb[j].pSchema->tblHash, zName, nName);
+    if( p==0 && db->aDb[j].pSchema->pLazy ){
+      sqlite3LazyParse(db, j, zName);
+      p = sqlite3HashFind(&db->aDb[j].pSchema->tblHash, zName, nName);
+    }
     if( p ) break;
   }
   return p;
@@ -344,6 +348,10 @@ Index *sqlite3FindIndex(sqlite3 *db, const char *zName, const char *zDb){
     if( zDb && sqlite3StrICmp(zDb, db->aDb[j].zName) ) continue;
     assert( sqlite3SchemaMutexHeld(db, j, 0) );
     p = sqlite3HashFind(&pSchema->idxHash, zName, nName);
+    if( p==0 && pSchema->pLazy ){
+      sqlite3LazyParse(db, j, zName);
+      p = sqlite3HashFind(&pSchema->idxHash, zName, nName);
+    }
     if( p ) break;
   }
   return p;
@@ -1873,6 +1881,7 @@ void sqlite3RootPageMoved(sqlite3 *db, int iDb, int iFrom, int iTo){
   HashElem *pElem;
   Hash *pHash;
   Db *pDb;
+  LazyTable *pLazy;
 
   assert( sqlite3SchemaMutexHeld(db, iDb, 0) );
   pDb = &db->aDb[iDb];
@@ -1890,6 +1899,14 @@ void sqlite3RootPageMoved(sqlite3 *db, int iDb, int iFrom, int iTo){
       pIdx->tnum = iTo;
     }
   }
+  for(pLazy=pDb->pSchema->pLazy; pLazy; pLazy=pLazy->pNext){
+    LazyRow *pRow;
+    for(pRow=pLazy->pRow; pRow; pRow=pRow->pNext){
+      if( pRow->iRoot==iFrom ){
+        pRow->iRoot = iTo;
+      }
+    }
+  }
 }
 #endif
 
@@ -3066,7 +3083,7 @@ void *sqlite3ArrayAllocate(
 IdList *sqlite3IdListAppend(sqlite3 *db, IdList *pList, Token *pToken){
   int i;
   if( pList==0 ){
-    pList = sqlite3DbMallocZero(db, sizeof(IdList) );
+    pList = sqlite3ArenaMallocZero(db, sizeof(IdList) );
     if( pList==0 ) return 0;
     pList->nAlloc = 0;
   }
@@ -3223,7 +3240,7 @@ SrcList *sqlite3SrcListAppend(
   struct SrcList_item *pItem;
   assert( pDatabase==0 || pTable!=0 );  /* Cannot have C without B */
   if( pList==0 ){
-    pList = sqlite3DbMallocZero(db, sizeof(SrcList) );
+    pList = sqlite3ArenaMallocZero(db, sizeof(SrcList) );
     if( pList==0 ) return 0;
     pList->nAlloc = 1;
   }
@@ -3402,13 +3419,13 @@ void sqlite3BeginTransaction(Parse *pParse, int type){
   }
   v = sqlite3GetVdbe(pParse);
   if( !v ) return;
-  if( type!=TK_DEFERRED ){
+  if( type!=TK_DEFERRED && type!=TK_CONCURRENT ){
     for(i=0; i<db->nDb; i++){
       sqlite3VdbeAddOp2(v, OP_Transaction, i, (type==TK_EXCLUSIVE)+1);
       sqlite3VdbeUsesBtree(v, i);
     }
   }
-  sqlite3VdbeAddOp2(v, OP_AutoCommit, 0, 0);
+  sqlite3VdbeAddOp3(v, OP_AutoCommit, 0, 0, (type==TK_CONCURRENT));
 }
 
 /*
@@ -3687,6 +3704,7 @@ static void reindexDatabases(Parse *pParse, char const *zColl){
   assert( sqlite3BtreeHoldsAllMutexes(db) );  /* Needed for schema access */
   for(iDb=0, pDb=db->aDb; iDb<db->nDb; iDb++, pDb++){
     assert( pDb!=0 );
+    sqlite3LazyParseAll(db, iDb);
     for(k=sqliteHashFirst(&pDb->pSchema->tblHash);  k; k=sqliteHashNext(k)){
       pTab = (Table*)sqliteHashData(k);
       reindexTable(pParse, pTab, zColl);
@@ -3733,6 +3751,11 @@ void sqlite3Reindex(Parse *pParse, Token *pName1, Token *pName2){
     assert( pName1->z );
     zColl = sqlite3NameFromToken(pParse->db, pName1);
     if( !zColl ) return;
+    /* A collation sequence is only known to the connection once an index
+    ** or table that uses it has been parsed. */
+    for(iDb=0; iDb<db->nDb; iDb++){
+      sqlite3LazyParseAll(db, iDb);
+    }
     pColl = sqlite3FindCollSeq(db, ENC(db), zColl, 0);
     if( pColl ){
       reindexDatabases(pParse, zColl);
@@ -409,6 +409,7 @@ void sqlite3SchemaClear(void *p){
   Hash temp1;
   Hash temp2;
   HashElem *pElem;
+  LazyTable *pLazy;
   Schema *pSchema = (Schema *)p;
 
   temp1 = pSchema->tblHash;
@@ -426,6 +427,11 @@ void sqlite3SchemaClear(void *p){
   }
   sqlite3HashClear(&temp1);
   sqlite3HashClear(&pSchema->fkeyHash);
+  sqlite3HashClear(&pSchema->lazyHash);
+  while( (pLazy = pSchema->pLazy)!=0 ){
+    pSchema->pLazy = pLazy->pNext;
+    sqlite3LazyDelete(0, pLazy);
+  }
   pSchema->pSeqTab = 0;
   if( pSchema->flags & DB_SchemaLoaded ){
     pSchema->iGeneration++;
@@ -451,6 +457,7 @@ Schema *sqlite3SchemaGet(sqlite3 *db, Btree *pBt){
     sqlite3HashInit(&p->idxHash);
     sqlite3HashInit(&p->trigHash);
     sqlite3HashInit(&p->fkeyHash);
+    sqlite3HashInit(&p->lazyHash);
     p->enc = SQLITE_UTF8;
   }
   return p;
@@ -90,6 +90,9 @@ static const char * const azCompileOpt[] = {
 #ifdef SQLITE_ENABLE_ICU
   "ENABLE_ICU",
 #endif
+#ifdef SQLITE_ENABLE_IO_URING
+  "ENABLE_IO_URING",
+#endif
 #ifdef SQLITE_ENABLE_IOTRACE
   "ENABLE_IOTRACE",
 #endif
@@ -108,6 +111,9 @@ static const char * const azCompileOpt[] = {
 #ifdef SQLITE_ENABLE_MEMSYS5
   "ENABLE_MEMSYS5",
 #endif
+#ifdef SQLITE_ENABLE_MEMSYS6
+  "ENABLE_MEMSYS6",
+#endif
 #ifdef SQLITE_ENABLE_OVERSIZE_CELL_CHECK
   "ENABLE_OVERSIZE_CELL_CHECK",
 #endif
@@ -221,6 +227,12 @@ static const char * const azCompileOpt[] = {
 #ifdef SQLITE_OMIT_DEPRECATED
   "OMIT_DEPRECATED",
 #endif
+#ifdef SQLITE_OMIT_DIRECT_IO
+  "OMIT_DIRECT_IO",
+#endif
+#ifdef SQLITE_OMIT_DIRECT_OVERFLOW_READ
+  "OMIT_DIRECT_OVERFLOW_READ",
+#endif
 #ifdef SQLITE_OMIT_DISKIO
   "OMIT_DISKIO",
 #endif
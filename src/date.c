@@ -1097,18 +1097,21 @@ static void currentTimeFunc(
 ** This function registered all of the above C functions as SQL
 ** functions.  This should be the only routine in this file with
 ** external linkage.
+**
+** None of the functions is deterministic, as any of them may be asked
+** for the current time ("now").
 */
 void sqlite3RegisterDateTimeFunctions(void){
   static SQLITE_WSD FuncDef aDateTimeFuncs[] = {
 #ifndef SQLITE_OMIT_DATETIME_FUNCS
-    FUNCTION(julianday,        -1, 0, 0, juliandayFunc ),
-    FUNCTION(date,             -1, 0, 0, dateFunc      ),
-    FUNCTION(time,             -1, 0, 0, timeFunc      ),
-    FUNCTION(datetime,         -1, 0, 0, datetimeFunc  ),
-    FUNCTION(strftime,         -1, 0, 0, strftimeFunc  ),
-    FUNCTION(current_time,      0, 0, 0, ctimeFunc     ),
-    FUNCTION(current_timestamp, 0, 0, 0, ctimestampFunc),
-    FUNCTION(current_date,      0, 0, 0, cdateFunc     ),
+    VFUNCTION(julianday,       -1, 0, 0, juliandayFunc ),
+    VFUNCTION(date,            -1, 0, 0, dateFunc      ),
+    VFUNCTION(time,            -1, 0, 0, timeFunc      ),
+    VFUNCTION(datetime,        -1, 0, 0, datetimeFunc  ),
+    VFUNCTION(strftime,        -1, 0, 0, strftimeFunc  ),
+    VFUNCTION(current_time,     0, 0, 0, ctimeFunc     ),
+    VFUNCTION(current_timestamp, 0, 0, 0, ctimestampFunc),
+    VFUNCTION(current_date,     0, 0, 0, cdateFunc     ),
 #else
     STR_FUNCTION(current_time,      0, "%H:%M:%S",          0, currentTimeFunc),
     STR_FUNCTION(current_date,      0, "%Y-%m-%d",          0, currentTimeFunc),
@@ -392,7 +392,7 @@ Expr *sqlite3ExprAlloc(
       assert( iValue>=0 );
     }
   }
-  pNew = sqlite3DbMallocZero(db, sizeof(Expr)+nExtra);
+  pNew = sqlite3ArenaMallocZero(db, sizeof(Expr)+nExtra);
   if( pNew ){
     pNew->op = (u8)op;
     pNew->iAgg = -1;
@@ -985,7 +985,7 @@ ExprList *sqlite3ExprListAppend(
 ){
   sqlite3 *db = pParse->db;
   if( pList==0 ){
-    pList = sqlite3DbMallocZero(db, sizeof(ExprList) );
+    pList = sqlite3ArenaMallocZero(db, sizeof(ExprList) );
     if( pList==0 ){
       goto no_mem;
     }
@@ -994,7 +994,11 @@ ExprList *sqlite3ExprListAppend(
   if( pList->nAlloc<=pList->nExpr ){
     struct ExprList_item *a;
     int n = pList->nAlloc*2 + 4;
-    a = sqlite3DbRealloc(db, pList->a, n*sizeof(pList->a[0]));
+    if( pList->a==0 ){
+      a = sqlite3ArenaMallocRaw(db, n*sizeof(pList->a[0]));
+    }else{
+      a = sqlite3DbRealloc(db, pList->a, n*sizeof(pList->a[0]));
+    }
     if( a==0 ){
       goto no_mem;
     }
@@ -1982,17 +1986,58 @@ static void cacheEntryClear(Parse *pParse, struct yColCache *p){
     }
     p->tempReg = 0;
   }
+  if( p->pExpr ){
+    sqlite3ExprDelete(pParse->db, p->pExpr);
+    p->pExpr = 0;
+  }
 }
 
+/*
+** Return a cache entry to hold a new value stored in register iReg.
+** An empty slot is used if there is one, otherwise the least recently
+** used entry is replaced.  The caller fills in iTable, iColumn and
+** pExpr.
+*/
+static struct yColCache *cacheNewEntry(Parse *pParse, int iReg){
+  int i;
+  int minLru;
+  int idxLru;
+  struct yColCache *p;
+
+  /* Find an empty slot */
+  for(i=0, p=pParse->aColCache; i<SQLITE_N_COLCACHE; i++, p++){
+    if( p->iReg==0 ) break;
+  }
+
+  /* Or replace the last recently used */
+  if( i==SQLITE_N_COLCACHE ){
+    minLru = 0x7fffffff;
+    idxLru = 0;
+    for(i=0, p=pParse->aColCache; i<SQLITE_N_COLCACHE; i++, p++){
+      if( p->lru<minLru ){
+        idxLru = i;
+        minLru = p->lru;
+      }
+    }
+    p = &pParse->aColCache[idxLru];
+    if( p->pExpr ){
+      sqlite3ExprDelete(pParse->db, p->pExpr);
+      p->pExpr = 0;
+    }
+  }
+  assert( p->pExpr==0 );
+  p->iLevel = pParse->iCacheLevel;
+  p->iReg = iReg;
+  p->tempReg = 0;
+  p->lru = pParse->iCacheCnt++;
+  return p;
+}
 
 /*
 ** Record in the column cache that a particular column from a
 ** particular table is stored in a particular register.
 */
 void sqlite3ExprCacheStore(Parse *pParse, int iTab, int iCol, int iReg){
-  int i;
-  int minLru;
-  int idxLru;
   struct yColCache *p;
 
   assert( iReg>0 );  /* Register numbers are always positive */
@@ -2010,52 +2055,100 @@ void sqlite3ExprCacheStore(Parse *pParse, int iTab, int iCol, int iReg){
   ** that the object will never already be in cache.  Verify this guarantee.
   */
 #ifndef NDEBUG
-  for(i=0, p=pParse->aColCache; i<SQLITE_N_COLCACHE; i++, p++){
-#if 0 /* This code wold remove the entry from the cache if it existed */
-    if( p->iReg && p->iTable==iTab && p->iColumn==iCol ){
-      cacheEntryClear(pParse, p);
-      p->iLevel = pParse->iCacheLevel;
-      p->iReg = iReg;
-      p->lru = pParse->iCacheCnt++;
-      return;
+  {
+    int i;
+    for(i=0, p=pParse->aColCache; i<SQLITE_N_COLCACHE; i++, p++){
+      assert( p->iReg==0 || p->pExpr || p->iTable!=iTab || p->iColumn!=iCol );
     }
-#endif
-    assert( p->iReg==0 || p->iTable!=iTab || p->iColumn!=iCol );
   }
 #endif
 
-  /* Find an empty slot and replace it */
-  for(i=0, p=pParse->aColCache; i<SQLITE_N_COLCACHE; i++, p++){
-    if( p->iReg==0 ){
-      p->iLevel = pParse->iCacheLevel;
-      p->iTable = iTab;
-      p->iColumn = iCol;
-      p->iReg = iReg;
-      p->tempReg = 0;
-      p->lru = pParse->iCacheCnt++;
-      return;
-    }
-  }
+  p = cacheNewEntry(pParse, iReg);
+  p->iTable = iTab;
+  p->iColumn = iCol;
+}
 
-  /* Replace the last recently used */
-  minLru = 0x7fffffff;
-  idxLru = -1;
-  for(i=0, p=pParse->aColCache; i<SQLITE_N_COLCACHE; i++, p++){
-    if( p->lru<minLru ){
-      idxLru = i;
-      minLru = p->lru;
+/*
+** Walker callback used by exprIsDeterministic().
+*/
+static int exprNodeIsDeterministic(Walker *pWalker, Expr *pExpr){
+  switch( pExpr->op ){
+    case TK_FUNCTION: {
+      sqlite3 *db = pWalker->pParse->db;
+      int nArg = 0;
+      FuncDef *pDef;
+      if( !ExprHasAnyProperty(pExpr, EP_TokenOnly) && pExpr->x.pList ){
+        nArg = pExpr->x.pList->nExpr;
+      }
+      pDef = sqlite3FindFunction(db, pExpr->u.zToken,
+          sqlite3Strlen30(pExpr->u.zToken), nArg, ENC(db), 0);
+      if( pDef && (pDef->flags & SQLITE_FUNC_CONSTANT)!=0 ){
+        return WRC_Continue;
+      }
+      break;
+    }
+    case TK_COLUMN: {
+      /* Columns read through a cursor.  A negative cursor number means
+      ** a column of the row being checked by a CHECK constraint.  Virtual
+      ** table columns are excluded, as they may overload functions. */
+      if( pExpr->iTable>=0 && (pExpr->pTab==0 || !IsVirtual(pExpr->pTab)) ){
+        pWalker->u.i = 2;
+        return WRC_Continue;
+      }
+      break;
+    }
+    case TK_TRIGGER: {
+      /* The old.* and new.* values do not change while a trigger
+      ** program runs */
+      pWalker->u.i = 2;
+      return WRC_Continue;
+    }
+    case TK_ID:
+    case TK_DOT:
+    case TK_CONST_FUNC:
+    case TK_AGG_FUNCTION:
+    case TK_AGG_COLUMN:
+    case TK_REGISTER:
+    case TK_RAISE: {
+      testcase( pExpr->op==TK_ID );
+      testcase( pExpr->op==TK_DOT );
+      testcase( pExpr->op==TK_CONST_FUNC );
+      testcase( pExpr->op==TK_AGG_FUNCTION );
+      testcase( pExpr->op==TK_AGG_COLUMN );
+      testcase( pExpr->op==TK_REGISTER );
+      testcase( pExpr->op==TK_RAISE );
+      break;
+    }
+    default: {
+      return WRC_Continue;
     }
   }
-  if( ALWAYS(idxLru>=0) ){
-    p = &pParse->aColCache[idxLru];
-    p->iLevel = pParse->iCacheLevel;
-    p->iTable = iTab;
-    p->iColumn = iCol;
-    p->iReg = iReg;
-    p->tempReg = 0;
-    p->lru = pParse->iCacheCnt++;
-    return;
-  }
+  pWalker->u.i = 0;
+  return WRC_Abort;
+}
+
+/*
+** Determine whether or not expression p computes the same result each
+** time it is evaluated for the same row.  The return value is:
+**
+**    0    p is not deterministic.  It contains a call to a function
+**         that is not deterministic, a subquery, an aggregate or some
+**         other value that may change between two evaluations.
+**
+**    1    p is a constant.  It may contain deterministic functions, but
+**         only literals and variables as leaves.
+**
+**    2    p depends on the values of table columns and deterministic
+**         functions only.
+*/
+static int exprIsDeterministic(Parse *pParse, Expr *p){
+  Walker w;
+  w.u.i = 1;
+  w.xExprCallback = exprNodeIsDeterministic;
+  w.xSelectCallback = selectNodeIsConstant;
+  w.pParse = pParse;
+  sqlite3WalkExpr(&w, p);
+  return w.u.i;
 }
 
 /*
@@ -2119,6 +2212,58 @@ static void sqlite3ExprCachePinRegister(Parse *pParse, int iReg){
   }
 }
 
+/*
+** Search the column cache for an earlier evaluation of deterministic
+** expression pExpr.  Return the register holding its result, or 0 if
+** there is none.
+*/
+static int exprCacheFind(Parse *pParse, Expr *pExpr){
+  int i;
+  struct yColCache *p;
+  for(i=0, p=pParse->aColCache; i<SQLITE_N_COLCACHE; i++, p++){
+    if( p->iReg>0 && p->pExpr && sqlite3ExprCompare(p->pExpr, pExpr)==0 ){
+      p->lru = pParse->iCacheCnt++;
+      sqlite3ExprCachePinRegister(pParse, p->iReg);
+      return p->iReg;
+    }
+  }
+  return 0;
+}
+
+/*
+** Record in the column cache that the result of deterministic expression
+** pExpr is stored in register iReg.  The cache keeps its own copy of
+** the expression, as pExpr may be deleted before the entry expires.
+*/
+static void exprCacheStore(Parse *pParse, Expr *pExpr, int iReg){
+  Expr *pCopy;
+  struct yColCache *p;
+
+  assert( iReg>0 );
+  if( pParse->db->flags & SQLITE_ColumnCache ) return;
+  pCopy = sqlite3ExprDup(pParse->db, pExpr, 0);
+  if( pCopy==0 ) return;
+  p = cacheNewEntry(pParse, iReg);
+  p->iTable = -1;
+  p->iColumn = -1;
+  p->pExpr = pCopy;
+}
+
+/*
+** Record in the column cache that register iReg holds the value of
+** expression pExpr, computed earlier for the current row, if pExpr is
+** a call to a deterministic function that a later evaluation of the
+** same expression could look up.
+*/
+void sqlite3ExprCacheStoreExpr(Parse *pParse, Expr *pExpr, int iReg){
+  if( pExpr && pExpr->op==TK_FUNCTION
+   && !ExprHasAnyProperty(pExpr, EP_Reduced|EP_TokenOnly)
+   && exprIsDeterministic(pParse, pExpr)==2
+  ){
+    exprCacheStore(pParse, pExpr, iReg);
+  }
+}
+
 /*
 ** Generate code to extract the value of the iCol-th column of a table.
 */
@@ -2161,7 +2306,9 @@ int sqlite3ExprCodeGetColumn(
   struct yColCache *p;
 
   for(i=0, p=pParse->aColCache; i<SQLITE_N_COLCACHE; i++, p++){
-    if( p->iReg>0 && p->iTable==iTable && p->iColumn==iColumn ){
+    if( p->iReg>0 && p->pExpr==0
+     && p->iTable==iTable && p->iColumn==iColumn
+    ){
       p->lru = pParse->iCacheCnt++;
       sqlite3ExprCachePinRegister(pParse, p->iReg);
       return p->iReg;
@@ -2533,6 +2680,8 @@ int sqlite3ExprCodeTarget(Parse *pParse, Expr *pExpr, int target){
       int i;                 /* Loop counter */
       u8 enc = ENC(db);      /* The text encoding used by this database */
       CollSeq *pColl = 0;    /* A collating sequence */
+      int eDeterm = 0;       /* Value returned by exprIsDeterministic() */
+      int addrOnce = 0;      /* OP_Once guarding a constant function call */
 
       assert( !ExprHasProperty(pExpr, EP_xIsSelect) );
       testcase( op==TK_CONST_FUNC );
@@ -2571,6 +2720,29 @@ int sqlite3ExprCodeTarget(Parse *pParse, Expr *pExpr, int target){
         break;
       }
 
+      /* A deterministic function with constant arguments is called once
+      ** only, the first time the code is run, and its result kept in a
+      ** register of its own.  Otherwise, if the arguments depend on table
+      ** columns, the result is remembered in the column cache so that
+      ** later evaluations of the same expression for the same row reuse
+      ** it instead of calling the function again.
+      */
+      if( op==TK_FUNCTION && (pDef->flags & SQLITE_FUNC_CONSTANT)!=0 ){
+        eDeterm = exprIsDeterministic(pParse, pExpr);
+        if( eDeterm==1 && (db->flags & SQLITE_FactorOutConst)==0 ){
+          int regOnce = ++pParse->nMem;
+          target = inReg = ++pParse->nMem;
+          addrOnce = sqlite3VdbeAddOp1(v, OP_Once, regOnce);
+          sqlite3ExprCachePush(pParse);
+        }else if( eDeterm==2 ){
+          if( ExprHasAnyProperty(pExpr, EP_Reduced|EP_TokenOnly) ){
+            eDeterm = 0;
+          }else if( (r1 = exprCacheFind(pParse, pExpr))!=0 ){
+            inReg = r1;
+            break;
+          }
+        }
+      }
 
       if( pFarg ){
         r1 = sqlite3GetTempRange(pParse, nFarg);
@@ -2617,6 +2789,12 @@ int sqlite3ExprCodeTarget(Parse *pParse, Expr *pExpr, int target){
       if( nFarg ){
         sqlite3ReleaseTempRange(pParse, r1, nFarg);
       }
+      if( addrOnce ){
+        sqlite3ExprCachePop(pParse, 1);
+        sqlite3VdbeJumpHere(v, addrOnce);
+      }else if( eDeterm==2 ){
+        exprCacheStore(pParse, pExpr, target);
+      }
       break;
     }
 #ifndef SQLITE_OMIT_SUBQUERY
@@ -3453,7 +3631,9 @@ int sqlite3ExprCompare(Expr *pA, Expr *pB){
     }
   }else if( pA->op!=TK_COLUMN && pA->u.zToken ){
     if( ExprHasProperty(pB, EP_IntValue) || NEVER(pB->u.zToken==0) ) return 2;
-    if( sqlite3StrICmp(pA->u.zToken,pB->u.zToken)!=0 ){
+    if( pA->op==TK_STRING ){
+      if( strcmp(pA->u.zToken,pB->u.zToken)!=0 ) return 2;
+    }else if( sqlite3StrICmp(pA->u.zToken,pB->u.zToken)!=0 ){
       return 2;
     }
   }
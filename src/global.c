@@ -133,6 +133,20 @@ const unsigned char sqlite3CtypeMap[256] = {
 # define  SQLITE_USE_URI 0
 #endif
 
+/* The default maximum number of schemas held by the cache enabled by
+** SQLITE_CONFIG_SCHEMACACHE. The cache is disabled by default.
+*/
+#ifndef SQLITE_DEFAULT_SCHEMACACHE
+# define SQLITE_DEFAULT_SCHEMACACHE 0
+#endif
+
+/* The default setting of SQLITE_CONFIG_LAZYSCHEMA. By default the
+** whole schema is parsed when it is loaded.
+*/
+#ifndef SQLITE_DEFAULT_LAZYSCHEMA
+# define SQLITE_DEFAULT_LAZYSCHEMA 0
+#endif
+
 /*
 ** The following singleton contains the global configuration for
 ** the SQLite library.
@@ -159,6 +173,8 @@ SQLITE_WSD struct Sqlite3Config sqlite3Config = {
    0,                         /* nPage */
    0,                         /* mxParserStack */
    0,                         /* sharedCacheEnabled */
+   SQLITE_DEFAULT_SCHEMACACHE, /* nSchemaCache */
+   SQLITE_DEFAULT_LAZYSCHEMA, /* bLazySchema */
    /* All the rest should always be initialized to zero */
    0,                         /* isInit */
    0,                         /* inProgress */
@@ -50,66 +50,88 @@ void sqlite3HashClear(Hash *pH){
 }
 
 /*
-** The hashing function.
+** The hashing function.  This is the FNV-1a hash of the key folded to
+** lower case.  Unlike a simple shift-and-xor hash, it mixes every byte of
+** the key into the low-order bits of the result, so the slot number can
+** be taken from those bits with a mask instead of a division.
 */
 static unsigned int strHash(const char *z, int nKey){
-  int h = 0;
+  unsigned int h = 2166136261u;
   assert( nKey>=0 );
   while( nKey > 0  ){
-    h = (h<<3) ^ h ^ sqlite3UpperToLower[(unsigned char)*z++];
+    h = (h ^ sqlite3UpperToLower[(unsigned char)*z++]) * 16777619u;
     nKey--;
   }
   return h;
 }
 
+/* Add element pNew to the Hash.ht table of pH.  There must be at least
+** one free slot in the table.
+*/
+static void insertSlot(Hash *pH, HashElem *pNew){
+  unsigned int mask = pH->htsize-1;
+  unsigned int i = pNew->h & mask;
+  while( pH->ht[i].elem ){
+    i = (i+1) & mask;
+  }
+  pH->ht[i].h = pNew->h;
+  pH->ht[i].elem = pNew;
+}
 
-/* Link pNew element into the hash table pH.  If pEntry!=0 then also
-** insert pNew into the pEntry hash bucket.
+/* Remove element elem from the Hash.ht table of pH.  Any elements in
+** the run of occupied slots that follows it are moved back, if required,
+** so that each of them can still be reached from the slot indexed by
+** its hash value without passing over an empty slot.
 */
-static void insertElement(
-  Hash *pH,              /* The complete hash table */
-  struct _ht *pEntry,    /* The entry into which pNew is inserted */
-  HashElem *pNew         /* The element to be inserted */
-){
-  HashElem *pHead;       /* First element already in pEntry */
-  if( pEntry ){
-    pHead = pEntry->count ? pEntry->chain : 0;
-    pEntry->count++;
-    pEntry->chain = pNew;
-  }else{
-    pHead = 0;
+static void removeSlot(Hash *pH, HashElem *elem){
+  struct _ht *ht = pH->ht;
+  unsigned int mask = pH->htsize-1;
+  unsigned int i = elem->h & mask;   /* The slot being emptied */
+  unsigned int j;                    /* Slot that might be moved into i */
+  unsigned int k;                    /* Slot indexed by the hash of j */
+
+  while( ht[i].elem!=elem ){
+    assert( ht[i].elem );
+    i = (i+1) & mask;
   }
-  if( pHead ){
-    pNew->next = pHead;
-    pNew->prev = pHead->prev;
-    if( pHead->prev ){ pHead->prev->next = pNew; }
-    else             { pH->first = pNew; }
-    pHead->prev = pNew;
-  }else{
-    pNew->next = pH->first;
-    if( pH->first ){ pH->first->prev = pNew; }
-    pNew->prev = 0;
-    pH->first = pNew;
+  for(j=(i+1)&mask; ht[j].elem; j=(j+1)&mask){
+    k = ht[j].h & mask;
+    if( i<=j ? (i<k && k<=j) : (i<k || k<=j) ) continue;
+    ht[i] = ht[j];
+    i = j;
+  }
+  ht[i].elem = 0;
+}
+
+/* Link pNew element into the hash table pH.
+*/
+static void insertElement(Hash *pH, HashElem *pNew){
+  pNew->next = pH->first;
+  if( pH->first ){ pH->first->prev = pNew; }
+  pNew->prev = 0;
+  pH->first = pNew;
+  if( pH->ht ){
+    insertSlot(pH, pNew);
   }
 }
 
 
-/* Resize the hash table so that it cantains "new_size" buckets.
+/* Resize the hash table so that it contains "new_size" slots.
+** "new_size" must be a power of two.
 **
-** The hash table might fail to resize if sqlite3_malloc() fails or
-** if the new size is the same as the prior size.
+** The hash table might fail to resize if sqlite3_malloc() fails.
 ** Return TRUE if the resize occurs and false if not.
+**
+** SQLITE_MALLOC_SOFT_LIMIT is not applied here.  An open-addressing
+** table cannot hold more elements than it has slots, so capping its
+** size would mean falling back to a linear search of the whole table.
 */
 static int rehash(Hash *pH, unsigned int new_size){
   struct _ht *new_ht;            /* The new hash table */
-  HashElem *elem, *next_elem;    /* For looping over existing elements */
+  HashElem *elem;                /* For looping over existing elements */
 
-#if SQLITE_MALLOC_SOFT_LIMIT>0
-  if( new_size*sizeof(struct _ht)>SQLITE_MALLOC_SOFT_LIMIT ){
-    new_size = SQLITE_MALLOC_SOFT_LIMIT/sizeof(struct _ht);
-  }
-  if( new_size==pH->htsize ) return 0;
-#endif
+  assert( (new_size & (new_size-1))==0 );
+  assert( new_size*3>=pH->count*4 );
 
   /* The inability to allocates space for a larger hash table is
   ** a performance hit but it is not a fatal error.  So mark the
@@ -122,12 +144,10 @@ static int rehash(Hash *pH, unsigned int new_size){
   if( new_ht==0 ) return 0;
   sqlite3_free(pH->ht);
   pH->ht = new_ht;
-  pH->htsize = new_size = sqlite3MallocSize(new_ht)/sizeof(struct _ht);
+  pH->htsize = new_size;
   memset(new_ht, 0, new_size*sizeof(struct _ht));
-  for(elem=pH->first, pH->first=0; elem; elem = next_elem){
-    unsigned int h = strHash(elem->pKey, elem->nKey) % new_size;
-    next_elem = elem->next;
-    insertElement(pH, &new_ht[h], elem);
+  for(elem=pH->first; elem; elem=elem->next){
+    insertSlot(pH, elem);
   }
   return 1;
 }
@@ -143,34 +163,36 @@ static HashElem *findElementGivenHash(
   unsigned int h      /* The hash for this key. */
 ){
   HashElem *elem;                /* Used to loop thru the element list */
-  int count;                     /* Number of elements left to test */
 
   if( pH->ht ){
-    struct _ht *pEntry = &pH->ht[h];
-    elem = pEntry->chain;
-    count = pEntry->count;
-  }else{
-    elem = pH->first;
-    count = pH->count;
+    unsigned int mask = pH->htsize-1;
+    unsigned int i;
+    for(i=h&mask; (elem = pH->ht[i].elem)!=0; i=(i+1)&mask){
+      if( pH->ht[i].h==h && elem->nKey==nKey
+       && sqlite3StrNICmp(elem->pKey,pKey,nKey)==0
+      ){
+        return elem;
+      }
+    }
+    return 0;
   }
-  while( count-- && ALWAYS(elem) ){
-    if( elem->nKey==nKey && sqlite3StrNICmp(elem->pKey,pKey,nKey)==0 ){ 
+  for(elem=pH->first; elem; elem=elem->next){
+    if( elem->h==h && elem->nKey==nKey
+     && sqlite3StrNICmp(elem->pKey,pKey,nKey)==0
+    ){ 
       return elem;
     }
-    elem = elem->next;
   }
   return 0;
 }
 
 /* Remove a single entry from the hash table given a pointer to that
-** element and a hash on the element's key.
+** element.
 */
-static void removeElementGivenHash(
+static void removeElement(
   Hash *pH,         /* The pH containing "elem" */
-  HashElem* elem,   /* The element to be removed from the pH */
-  unsigned int h    /* Hash value for the element */
+  HashElem* elem    /* The element to be removed from the pH */
 ){
-  struct _ht *pEntry;
   if( elem->prev ){
     elem->prev->next = elem->next; 
   }else{
@@ -180,12 +202,7 @@ static void removeElementGivenHash(
     elem->next->prev = elem->prev;
   }
   if( pH->ht ){
-    pEntry = &pH->ht[h];
-    if( pEntry->chain==elem ){
-      pEntry->chain = elem->next;
-    }
-    pEntry->count--;
-    assert( pEntry->count>=0 );
+    removeSlot(pH, elem);
   }
   sqlite3_free( elem );
   pH->count--;
@@ -202,17 +219,12 @@ static void removeElementGivenHash(
 */
 void *sqlite3HashFind(const Hash *pH, const char *pKey, int nKey){
   HashElem *elem;    /* The element that matches key */
-  unsigned int h;    /* A hash on key */
 
   assert( pH!=0 );
   assert( pKey!=0 );
   assert( nKey>=0 );
-  if( pH->ht ){
-    h = strHash(pKey, nKey) % pH->htsize;
-  }else{
-    h = 0;
-  }
-  elem = findElementGivenHash(pH, pKey, nKey, h);
+  if( pH->first==0 ) return 0;
+  elem = findElementGivenHash(pH, pKey, nKey, strHash(pKey, nKey));
   return elem ? elem->data : 0;
 }
 
@@ -231,23 +243,19 @@ void *sqlite3HashFind(const Hash *pH, const char *pKey, int nKey){
 ** element corresponding to "key" is removed from the hash table.
 */
 void *sqlite3HashInsert(Hash *pH, const char *pKey, int nKey, void *data){
-  unsigned int h;       /* the hash of the key modulo hash table size */
+  unsigned int h;       /* the hash of the key */
   HashElem *elem;       /* Used to loop thru the element list */
   HashElem *new_elem;   /* New element added to the pH */
 
   assert( pH!=0 );
   assert( pKey!=0 );
   assert( nKey>=0 );
-  if( pH->htsize ){
-    h = strHash(pKey, nKey) % pH->htsize;
-  }else{
-    h = 0;
-  }
+  h = strHash(pKey, nKey);
   elem = findElementGivenHash(pH,pKey,nKey,h);
   if( elem ){
     void *old_data = elem->data;
     if( data==0 ){
-      removeElementGivenHash(pH,elem,h);
+      removeElement(pH,elem);
     }else{
       elem->data = data;
       elem->pKey = pKey;
@@ -260,18 +268,20 @@ void *sqlite3HashInsert(Hash *pH, const char *pKey, int nKey, void *data){
   if( new_elem==0 ) return data;
   new_elem->pKey = pKey;
   new_elem->nKey = nKey;
+  new_elem->h = h;
   new_elem->data = data;
   pH->count++;
-  if( pH->count>=10 && pH->count > 2*pH->htsize ){
-    if( rehash(pH, pH->count*2) ){
-      assert( pH->htsize>0 );
-      h = strHash(pKey, nKey) % pH->htsize;
+  if( pH->count>=10 && pH->count*4>pH->htsize*3 ){
+    unsigned int new_size = 16;
+    while( new_size*3<pH->count*4 ) new_size *= 2;
+    if( !rehash(pH, new_size) && pH->count>=pH->htsize ){
+      /* The table is full and cannot be enlarged.  Search the list of
+      ** elements instead until a later rehash() succeeds. */
+      sqlite3_free(pH->ht);
+      pH->ht = 0;
+      pH->htsize = 0;
     }
   }
-  if( pH->ht ){
-    insertElement(pH, &pH->ht[h], new_elem);
-  }else{
-    insertElement(pH, 0, new_elem);
-  }
+  insertElement(pH, new_elem);
   return 0;
 }
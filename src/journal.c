@@ -186,7 +186,8 @@ static struct sqlite3_io_methods JournalFileMethods = {
   0,             /* xShmMap */
   0,             /* xShmLock */
   0,             /* xShmBarrier */
-  0              /* xShmUnmap */
+  0,             /* xShmUnmap */
+  0              /* xWriteV */
 };
 
 /* 
@@ -531,8 +531,9 @@ static const sqlite3_api_routines sqlite3Apis = { 0 };
 ** The following object holds the list of automatically loaded
 ** extensions.
 **
-** This list is shared across threads.  The SQLITE_MUTEX_STATIC_MASTER
-** mutex must be held while accessing this list.
+** This list is shared across threads.  The SQLITE_RWMUTEX_STATIC_AUTOEXT
+** mutex must be held while accessing this list, in exclusive mode if the
+** list is modified.
 */
 typedef struct sqlite3AutoExtList sqlite3AutoExtList;
 static SQLITE_WSD struct sqlite3AutoExtList {
@@ -570,11 +571,8 @@ int sqlite3_auto_extension(void (*xInit)(void)){
 #endif
   {
     int i;
-#if SQLITE_THREADSAFE
-    sqlite3_mutex *mutex = sqlite3MutexAlloc(SQLITE_MUTEX_STATIC_MASTER);
-#endif
     wsdAutoextInit;
-    sqlite3_mutex_enter(mutex);
+    sqlite3RwMutexEnter(SQLITE_RWMUTEX_STATIC_AUTOEXT, 0);
     for(i=0; i<wsdAutoext.nExt; i++){
       if( wsdAutoext.aExt[i]==xInit ) break;
     }
@@ -590,7 +588,7 @@ int sqlite3_auto_extension(void (*xInit)(void)){
         wsdAutoext.nExt++;
       }
     }
-    sqlite3_mutex_leave(mutex);
+    sqlite3RwMutexLeave(SQLITE_RWMUTEX_STATIC_AUTOEXT);
     assert( (rc&0xff)==rc );
     return rc;
   }
@@ -604,15 +602,12 @@ void sqlite3_reset_auto_extension(void){
   if( sqlite3_initialize()==SQLITE_OK )
 #endif
   {
-#if SQLITE_THREADSAFE
-    sqlite3_mutex *mutex = sqlite3MutexAlloc(SQLITE_MUTEX_STATIC_MASTER);
-#endif
     wsdAutoextInit;
-    sqlite3_mutex_enter(mutex);
+    sqlite3RwMutexEnter(SQLITE_RWMUTEX_STATIC_AUTOEXT, 0);
     sqlite3_free(wsdAutoext.aExt);
     wsdAutoext.aExt = 0;
     wsdAutoext.nExt = 0;
-    sqlite3_mutex_leave(mutex);
+    sqlite3RwMutexLeave(SQLITE_RWMUTEX_STATIC_AUTOEXT);
   }
 }
 
@@ -633,10 +628,7 @@ void sqlite3AutoLoadExtensions(sqlite3 *db){
   }
   for(i=0; go; i++){
     char *zErrmsg;
-#if SQLITE_THREADSAFE
-    sqlite3_mutex *mutex = sqlite3MutexAlloc(SQLITE_MUTEX_STATIC_MASTER);
-#endif
-    sqlite3_mutex_enter(mutex);
+    sqlite3RwMutexEnter(SQLITE_RWMUTEX_STATIC_AUTOEXT, 1);
     if( i>=wsdAutoext.nExt ){
       xInit = 0;
       go = 0;
@@ -644,7 +636,7 @@ void sqlite3AutoLoadExtensions(sqlite3 *db){
       xInit = (int(*)(sqlite3*,char**,const sqlite3_api_routines*))
               wsdAutoext.aExt[i];
     }
-    sqlite3_mutex_leave(mutex);
+    sqlite3RwMutexLeave(SQLITE_RWMUTEX_STATIC_AUTOEXT);
     zErrmsg = 0;
     if( xInit && xInit(db, &zErrmsg, &sqlite3Apis) ){
       sqlite3Error(db, SQLITE_ERROR,
@@ -259,6 +259,7 @@ int sqlite3_shutdown(void){
   if( sqlite3GlobalConfig.isInit ){
     sqlite3_os_end();
     sqlite3_reset_auto_extension();
+    sqlite3SchemaCacheReset();
     sqlite3GlobalConfig.isInit = 0;
   }
   if( sqlite3GlobalConfig.isPCacheInit ){
@@ -441,6 +442,25 @@ int sqlite3_config(int op, ...){
       break;
     }
 
+    case SQLITE_CONFIG_SCHEMACACHE: {
+      sqlite3GlobalConfig.nSchemaCache = va_arg(ap, int);
+      break;
+    }
+
+    case SQLITE_CONFIG_LAZYSCHEMA: {
+      sqlite3GlobalConfig.bLazySchema = va_arg(ap, int);
+      break;
+    }
+
+#ifdef SQLITE_ENABLE_MEMSYS6
+    case SQLITE_CONFIG_MALLOCCACHE: {
+      /* Place a set of caches in front of the current memory allocator,
+      ** or remove them. */
+      rc = sqlite3Memsys6Config(va_arg(ap, int));
+      break;
+    }
+#endif
+
     default: {
       rc = SQLITE_ERROR;
       break;
@@ -450,6 +470,38 @@ int sqlite3_config(int op, ...){
   return rc;
 }
 
+/*
+** Free the lookaside buffer of connection db, if it was obtained from
+** sqlite3_malloc(), and any chunks allocated to grow it. The caller
+** must ensure that no lookaside buffers are in use.
+*/
+static void freeLookaside(sqlite3 *db){
+  assert( db->lookaside.nOut==0 );
+  if( db->lookaside.bMalloced ){
+    sqlite3_free(db->lookaside.pStart);
+  }
+  while( db->lookaside.pChunk ){
+    LookasideChunk *pNext = db->lookaside.pChunk->pNext;
+    sqlite3_free(db->lookaside.pChunk);
+    db->lookaside.pChunk = pNext;
+  }
+  db->lookaside.nGrow = 0;
+  memset(db->lookaside.aClass, 0, sizeof(db->lookaside.aClass));
+}
+
+/*
+** Set the size of the largest lookaside buffer that connection db may
+** use. This is the size of class 0 buffers, unless the lookaside buffer
+** may grow, in which case larger classes are used too.
+*/
+static void setLookasideMax(sqlite3 *db){
+  if( db->lookaside.nGrowMax>0 ){
+    db->lookaside.szMax = db->lookaside.sz<<(LOOKASIDE_NCLASS-1);
+  }else{
+    db->lookaside.szMax = db->lookaside.sz;
+  }
+}
+
 /*
 ** Set up the lookaside buffers for a database connection.
 ** Return SQLITE_OK on success.  
@@ -470,9 +522,7 @@ static int setupLookaside(sqlite3 *db, void *pBuf, int sz, int cnt){
   ** allocating a new one so we don't have to have space for 
   ** both at the same time.
   */
-  if( db->lookaside.bMalloced ){
-    sqlite3_free(db->lookaside.pStart);
-  }
+  freeLookaside(db);
   /* The size of a lookaside slot needs to be larger than a pointer
   ** to be useful.
   */
@@ -491,18 +541,19 @@ static int setupLookaside(sqlite3 *db, void *pBuf, int sz, int cnt){
     pStart = pBuf;
   }
   db->lookaside.pStart = pStart;
-  db->lookaside.pFree = 0;
   db->lookaside.sz = (u16)sz;
+  setLookasideMax(db);
   if( pStart ){
     int i;
     LookasideSlot *p;
     assert( sz > (int)sizeof(LookasideSlot*) );
     p = (LookasideSlot*)pStart;
     for(i=cnt-1; i>=0; i--){
-      p->pNext = db->lookaside.pFree;
-      db->lookaside.pFree = p;
+      p->pNext = db->lookaside.aClass[0].pFree;
+      db->lookaside.aClass[0].pFree = p;
       p = (LookasideSlot*)&((u8*)p)[sz];
     }
+    db->lookaside.aClass[0].nSlot = cnt;
     db->lookaside.pEnd = p;
     db->lookaside.bEnabled = 1;
     db->lookaside.bMalloced = pBuf==0 ?1:0;
@@ -536,6 +587,19 @@ int sqlite3_db_config(sqlite3 *db, int op, ...){
       rc = setupLookaside(db, pBuf, sz, cnt);
       break;
     }
+    case SQLITE_DBCONFIG_LOOKASIDE_GROWTH: {
+      int nByte = va_arg(ap, int);
+      int *pRes = va_arg(ap, int*);
+      if( nByte>=0 ){
+        db->lookaside.nGrowMax = nByte;
+        setLookasideMax(db);
+      }
+      if( pRes ){
+        *pRes = db->lookaside.nGrowMax;
+      }
+      rc = SQLITE_OK;
+      break;
+    }
     default: {
       static const struct {
         int op;      /* The opcode */
@@ -808,9 +872,7 @@ int sqlite3_close(sqlite3 *db){
   db->magic = SQLITE_MAGIC_CLOSED;
   sqlite3_mutex_free(db->mutex);
   assert( db->lookaside.nOut==0 );  /* Fails on a lookaside memory leak */
-  if( db->lookaside.bMalloced ){
-    sqlite3_free(db->lookaside.pStart);
-  }
+  freeLookaside(db);
   sqlite3_free(db);
   return SQLITE_OK;
 }
@@ -1040,8 +1102,11 @@ int sqlite3CreateFunc(
 ){
   FuncDef *p;
   int nName;
+  int extraFlags;
 
   assert( sqlite3_mutex_held(db->mutex) );
+  extraFlags = enc & SQLITE_DETERMINISTIC;
+  enc &= ~SQLITE_DETERMINISTIC;
   if( zFunctionName==0 ||
       (xFunc && (xFinal || xStep)) || 
       (!xFunc && (xFinal && !xStep)) ||
@@ -1063,10 +1128,10 @@ int sqlite3CreateFunc(
     enc = SQLITE_UTF16NATIVE;
   }else if( enc==SQLITE_ANY ){
     int rc;
-    rc = sqlite3CreateFunc(db, zFunctionName, nArg, SQLITE_UTF8,
+    rc = sqlite3CreateFunc(db, zFunctionName, nArg, SQLITE_UTF8|extraFlags,
          pUserData, xFunc, xStep, xFinal, pDestructor);
     if( rc==SQLITE_OK ){
-      rc = sqlite3CreateFunc(db, zFunctionName, nArg, SQLITE_UTF16LE,
+      rc = sqlite3CreateFunc(db, zFunctionName, nArg, SQLITE_UTF16LE|extraFlags,
           pUserData, xFunc, xStep, xFinal, pDestructor);
     }
     if( rc!=SQLITE_OK ){
@@ -1109,7 +1174,7 @@ int sqlite3CreateFunc(
     pDestructor->nRef++;
   }
   p->pDestructor = pDestructor;
-  p->flags = 0;
+  p->flags = extraFlags ? SQLITE_FUNC_CONSTANT : 0;
   p->xFunc = xFunc;
   p->xStep = xStep;
   p->xFinalize = xFinal;
@@ -1445,6 +1510,86 @@ int sqlite3_wal_checkpoint(sqlite3 *db, const char *zDb){
   return sqlite3_wal_checkpoint_v2(db, zDb, SQLITE_CHECKPOINT_PASSIVE, 0, 0);
 }
 
+/*
+** Obtain a snapshot handle for the snapshot of database zDb currently 
+** being read by handle db. If no read transaction is open on zDb, one
+** is opened first.
+*/
+int sqlite3_snapshot_get(
+  sqlite3 *db, 
+  const char *zDb,
+  sqlite3_snapshot **ppSnapshot
+){
+#ifdef SQLITE_OMIT_WAL
+  *ppSnapshot = 0;
+  return SQLITE_ERROR;
+#else
+  int rc = SQLITE_ERROR;          /* Return code */
+  int iDb;                        /* sqlite3.aDb[] index of db zDb */
+
+  *ppSnapshot = 0;
+  sqlite3_mutex_enter(db->mutex);
+  if( db->autoCommit==0 ){
+    iDb = sqlite3FindDbName(db, zDb);
+    if( iDb==0 || iDb>1 ){
+      Btree *pBt = db->aDb[iDb].pBt;
+      if( sqlite3BtreeIsInTrans(pBt)==0 ){
+        sqlite3BtreeEnter(pBt);
+        rc = sqlite3BtreeBeginTrans(pBt, 0);
+        if( rc==SQLITE_OK ){
+          rc = sqlite3PagerSnapshotGet(sqlite3BtreePager(pBt), ppSnapshot);
+        }
+        sqlite3BtreeLeave(pBt);
+      }
+    }
+  }
+  sqlite3_mutex_leave(db->mutex);
+  return rc;
+#endif
+}
+
+/*
+** Open a read transaction on database zDb of handle db that reads the
+** historical snapshot pSnapshot.
+*/
+int sqlite3_snapshot_open(
+  sqlite3 *db, 
+  const char *zDb,
+  sqlite3_snapshot *pSnapshot
+){
+#ifdef SQLITE_OMIT_WAL
+  return SQLITE_ERROR;
+#else
+  int rc = SQLITE_ERROR;          /* Return code */
+  int iDb;                        /* sqlite3.aDb[] index of db zDb */
+
+  sqlite3_mutex_enter(db->mutex);
+  if( db->autoCommit==0 ){
+    iDb = sqlite3FindDbName(db, zDb);
+    if( iDb==0 || iDb>1 ){
+      Btree *pBt = db->aDb[iDb].pBt;
+      if( sqlite3BtreeIsInReadTrans(pBt)==0 ){
+        Pager *pPager = sqlite3BtreePager(pBt);
+        sqlite3BtreeEnter(pBt);
+        sqlite3PagerSnapshotOpen(pPager, pSnapshot);
+        rc = sqlite3BtreeBeginTrans(pBt, 0);
+        sqlite3PagerSnapshotOpen(pPager, 0);
+        sqlite3BtreeLeave(pBt);
+      }
+    }
+  }
+  sqlite3_mutex_leave(db->mutex);
+  return rc;
+#endif
+}
+
+/*
+** Free a snapshot handle obtained from sqlite3_snapshot_get().
+*/
+void sqlite3_snapshot_free(sqlite3_snapshot *pSnapshot){
+  sqlite3_free(pSnapshot);
+}
+
 #ifndef SQLITE_OMIT_WAL
 /*
 ** Run a checkpoint on database iDb. This is a no-op if database iDb is
@@ -2270,6 +2415,7 @@ static int openDatabase(
 #endif
 
   /* Enable the lookaside-malloc subsystem */
+  db->lookaside.nGrowMax = SQLITE_DEFAULT_LOOKASIDE_GROWTH;
   setupLookaside(db, 0, sqlite3GlobalConfig.szLookaside,
                         sqlite3GlobalConfig.nLookaside);
 
@@ -2686,6 +2832,11 @@ int sqlite3_file_control(sqlite3 *db, const char *zDbName, int op, void *pArg){
         rc = SQLITE_OK;
       }else if( fd->pMethods ){
         rc = sqlite3OsFileControl(fd, op, pArg);
+#ifndef SQLITE_OMIT_WAL
+        if( op==SQLITE_FCNTL_CHUNK_SIZE && rc==SQLITE_OK ){
+          sqlite3PagerWalChunkSize(pPager, *(int*)pArg);
+        }
+#endif
       }else{
         rc = SQLITE_NOTFOUND;
       }
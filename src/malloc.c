@@ -428,16 +428,84 @@ void sqlite3ScratchFree(void *p){
 }
 
 /*
-** TRUE if p is a lookaside memory allocation from db
+** If p is a lookaside memory allocation from db, return its size class.
+** Otherwise return -1.
 */
 #ifndef SQLITE_OMIT_LOOKASIDE
-static int isLookaside(sqlite3 *db, void *p){
-  return p && p>=db->lookaside.pStart && p<db->lookaside.pEnd;
+static int lookasideClass(sqlite3 *db, void *p){
+  LookasideChunk *pChunk;
+  if( p==0 ) return -1;
+  if( p>=db->lookaside.pStart && p<db->lookaside.pEnd ) return 0;
+  for(pChunk=db->lookaside.pChunk; pChunk; pChunk=pChunk->pNext){
+    if( (u8*)p>(u8*)pChunk && (u8*)p<pChunk->pEnd ) return pChunk->iClass;
+  }
+  return -1;
+}
+
+/*
+** Allocate a new chunk of lookaside buffers of class iClass for db and
+** add them to the list of available buffers for the class. Each chunk
+** holds as many buffers as the class already has, and at least
+** LOOKASIDE_MINGROW, so that the number of chunks stays small. Return
+** SQLITE_OK if successful, or SQLITE_FULL if the chunk would take the
+** connection past its limit or cannot be allocated.
+*/
+#define LOOKASIDE_MINGROW 16
+static int lookasideGrow(sqlite3 *db, int iClass){
+  Lookaside *p = &db->lookaside;
+  LookasideClass *pClass = &p->aClass[iClass];
+  LookasideChunk *pChunk;
+  LookasideSlot *pSlot;
+  int szSlot = p->sz<<iClass;
+  int szHdr = ROUND8(sizeof(LookasideChunk));
+  int nSlot;
+  int nByte;
+  int i;
+
+  nSlot = pClass->nSlot<LOOKASIDE_MINGROW ? LOOKASIDE_MINGROW : pClass->nSlot;
+  if( nSlot > (p->nGrowMax - p->nGrow - szHdr)/szSlot ){
+    nSlot = (p->nGrowMax - p->nGrow - szHdr)/szSlot;
+    if( nSlot<=0 ) return SQLITE_FULL;
+  }
+  nByte = szHdr + nSlot*szSlot;
+  sqlite3BeginBenignMalloc();
+  pChunk = (LookasideChunk*)sqlite3Malloc(nByte);
+  sqlite3EndBenignMalloc();
+  if( pChunk==0 ) return SQLITE_FULL;
+  pChunk->pEnd = &((u8*)pChunk)[nByte];
+  pChunk->iClass = iClass;
+  pChunk->pNext = p->pChunk;
+  p->pChunk = pChunk;
+  p->nGrow += nByte;
+  pSlot = (LookasideSlot*)&((u8*)pChunk)[szHdr];
+  for(i=0; i<nSlot; i++){
+    pSlot->pNext = pClass->pFree;
+    pClass->pFree = pSlot;
+    pSlot = (LookasideSlot*)&((u8*)pSlot)[szSlot];
+  }
+  pClass->nSlot += nSlot;
+  return SQLITE_OK;
 }
 #else
-#define isLookaside(A,B) 0
+#define lookasideClass(A,B) (-1)
 #endif
 
+/*
+** TRUE if p is an allocation from one of the parse arenas of db. The
+** size of such an allocation is stored in the 8 bytes before it.
+*/
+static int isArena(sqlite3 *db, void *p){
+  Arena *pArena;
+  for(pArena=db->pArena; pArena; pArena=pArena->pOuter){
+    ArenaChunk *pChunk;
+    for(pChunk=pArena->pChunk; pChunk; pChunk=pChunk->pNext){
+      if( (u8*)p>(u8*)pChunk && (u8*)p<pChunk->pEnd ) return 1;
+    }
+  }
+  return 0;
+}
+#define arenaSize(p) (*(int*)&((u8*)(p))[-8])
+
 /*
 ** Return the size of a memory allocation previously obtained from
 ** sqlite3Malloc() or sqlite3_malloc().
@@ -448,9 +516,12 @@ int sqlite3MallocSize(void *p){
   return sqlite3GlobalConfig.m.xSize(p);
 }
 int sqlite3DbMallocSize(sqlite3 *db, void *p){
+  int iClass;
   assert( db==0 || sqlite3_mutex_held(db->mutex) );
-  if( db && isLookaside(db, p) ){
-    return db->lookaside.sz;
+  if( db && (iClass = lookasideClass(db, p))>=0 ){
+    return db->lookaside.sz<<iClass;
+  }else if( db && db->pArena && isArena(db, p) ){
+    return arenaSize(p);
   }else{
     assert( sqlite3MemdebugHasType(p, MEMTYPE_DB) );
     assert( sqlite3MemdebugHasType(p, MEMTYPE_LOOKASIDE|MEMTYPE_HEAP) );
@@ -484,17 +555,22 @@ void sqlite3_free(void *p){
 void sqlite3DbFree(sqlite3 *db, void *p){
   assert( db==0 || sqlite3_mutex_held(db->mutex) );
   if( db ){
+    int iClass;
     if( db->pnBytesFreed ){
       *db->pnBytesFreed += sqlite3DbMallocSize(db, p);
       return;
     }
-    if( isLookaside(db, p) ){
+    if( (iClass = lookasideClass(db, p))>=0 ){
       LookasideSlot *pBuf = (LookasideSlot*)p;
-      pBuf->pNext = db->lookaside.pFree;
-      db->lookaside.pFree = pBuf;
+      pBuf->pNext = db->lookaside.aClass[iClass].pFree;
+      db->lookaside.aClass[iClass].pFree = pBuf;
       db->lookaside.nOut--;
       return;
     }
+    if( db->pArena && isArena(db, p) ){
+      /* Released by sqlite3ArenaEnd() */
+      return;
+    }
   }
   assert( sqlite3MemdebugHasType(p, MEMTYPE_DB) );
   assert( sqlite3MemdebugHasType(p, MEMTYPE_LOOKASIDE|MEMTYPE_HEAP) );
@@ -618,18 +694,33 @@ void *sqlite3DbMallocRaw(sqlite3 *db, int n){
       return 0;
     }
     if( db->lookaside.bEnabled ){
-      if( n>db->lookaside.sz ){
+      if( n>db->lookaside.szMax ){
         db->lookaside.anStat[1]++;
-      }else if( (pBuf = db->lookaside.pFree)==0 ){
-        db->lookaside.anStat[2]++;
       }else{
-        db->lookaside.pFree = pBuf->pNext;
-        db->lookaside.nOut++;
-        db->lookaside.anStat[0]++;
-        if( db->lookaside.nOut>db->lookaside.mxOut ){
-          db->lookaside.mxOut = db->lookaside.nOut;
+        int iClass = 0;
+        LookasideClass *pClass;
+        while( n>(db->lookaside.sz<<iClass) ) iClass++;
+        assert( iClass<LOOKASIDE_NCLASS );
+        pClass = &db->lookaside.aClass[iClass];
+        if( (pBuf = pClass->pFree)==0
+         && db->lookaside.nGrow<db->lookaside.nGrowMax
+         && lookasideGrow(db, iClass)==SQLITE_OK
+        ){
+          pBuf = pClass->pFree;
+        }
+        if( pBuf==0 ){
+          db->lookaside.anStat[2]++;
+          pClass->nMiss++;
+        }else{
+          pClass->pFree = pBuf->pNext;
+          pClass->nHit++;
+          db->lookaside.nOut++;
+          db->lookaside.anStat[0]++;
+          if( db->lookaside.nOut>db->lookaside.mxOut ){
+            db->lookaside.mxOut = db->lookaside.nOut;
+          }
+          return (void*)pBuf;
         }
-        return (void*)pBuf;
       }
     }
   }
@@ -647,27 +738,145 @@ void *sqlite3DbMallocRaw(sqlite3 *db, int n){
   return p;
 }
 
+/*
+** The following variable counts the number of allocations made from
+** parse arenas. It is used by the test scripts.
+*/
+#ifdef SQLITE_TEST
+int sqlite3_arena_alloc_count = 0;
+#endif
+
+/*
+** Parse arenas.
+**
+** While a statement is being prepared, the objects that make up its parse
+** tree (Expr, ExprList, SrcList, Select and IdList objects, and the
+** WhereInfo and WhereClause objects used while generating code) are
+** allocated using sqlite3ArenaMallocRaw() or sqlite3ArenaMallocZero().
+** These take memory from the Arena of the Parse object by advancing a
+** pointer through its current chunk. sqlite3DbFree() does nothing for
+** such allocations. Instead, all arena memory is released at once by
+** sqlite3ArenaEnd() once the statement has been prepared.
+**
+** Each arena allocation is preceded by 8 bytes that hold its size, so
+** that sqlite3DbMallocSize() and sqlite3DbRealloc() work as for any other
+** allocation. Requests for more than ARENA_MAXALLOC bytes are satisfied
+** by sqlite3DbMallocRaw() instead.
+**
+** As with lookaside, arena memory is not used while the schema is being
+** parsed (db->init.busy is set). Objects created then may become part of
+** the schema and so outlive the statement.
+*/
+#define ARENA_MINCHUNK  4096    /* Size of the first chunk of an arena */
+#define ARENA_MAXCHUNK 65536    /* Maximum size of a chunk */
+#define ARENA_MAXALLOC  2048    /* Largest allocation made from an arena */
+
+void *sqlite3ArenaMallocRaw(sqlite3 *db, int n){
+  Arena *p;
+  u8 *pRet;
+  int nByte;
+  if( db==0 || (p = db->pArena)==0 || db->init.busy || n>ARENA_MAXALLOC ){
+    return sqlite3DbMallocRaw(db, n);
+  }
+  assert( sqlite3_mutex_held(db->mutex) );
+  if( db->mallocFailed ){
+    return 0;
+  }
+  nByte = ROUND8(n) + 8;
+  if( (int)(p->pEnd - p->pFree)<nByte ){
+    ArenaChunk *pChunk;
+    int nChunk = ARENA_MINCHUNK;
+    if( p->pChunk ){
+      nChunk = (int)(p->pChunk->pEnd - (u8*)p->pChunk)*2;
+      if( nChunk>ARENA_MAXCHUNK ) nChunk = ARENA_MAXCHUNK;
+    }
+    pChunk = (ArenaChunk*)sqlite3DbMallocRaw(db, nChunk);
+    if( pChunk==0 ){
+      return 0;
+    }
+    pChunk->pNext = p->pChunk;
+    pChunk->pEnd = &((u8*)pChunk)[nChunk];
+    p->pChunk = pChunk;
+    p->pFree = (u8*)&pChunk[1];
+    p->pEnd = pChunk->pEnd;
+    assert( EIGHT_BYTE_ALIGNMENT(p->pFree) );
+  }
+  pRet = &p->pFree[8];
+  p->pFree += nByte;
+  arenaSize(pRet) = ROUND8(n);
+#ifdef SQLITE_TEST
+  sqlite3_arena_alloc_count++;
+#endif
+  return (void*)pRet;
+}
+
+/*
+** Allocate and zero memory from the parse arena of db, if any.
+*/
+void *sqlite3ArenaMallocZero(sqlite3 *db, int n){
+  void *p = sqlite3ArenaMallocRaw(db, n);
+  if( p ){
+    memset(p, 0, n);
+  }
+  return p;
+}
+
+/*
+** Make arena p, which is part of a Parse object, the parse arena of
+** database connection db.
+*/
+void sqlite3ArenaBegin(sqlite3 *db, Arena *p){
+  memset(p, 0, sizeof(*p));
+  p->pOuter = db->pArena;
+  db->pArena = p;
+}
+
+/*
+** Release all memory allocated from arena p and restore the arena of
+** the enclosing statement, if any.
+*/
+void sqlite3ArenaEnd(sqlite3 *db, Arena *p){
+  assert( db->pArena==p );
+  db->pArena = p->pOuter;
+  while( p->pChunk ){
+    ArenaChunk *pNext = p->pChunk->pNext;
+    sqlite3DbFree(db, p->pChunk);
+    p->pChunk = pNext;
+  }
+  p->pFree = p->pEnd = 0;
+}
+
 /*
 ** Resize the block of memory pointed to by p to n bytes. If the
 ** resize fails, set the mallocFailed flag in the connection object.
 */
 void *sqlite3DbRealloc(sqlite3 *db, void *p, int n){
   void *pNew = 0;
+  int iClass;
   assert( db!=0 );
   assert( sqlite3_mutex_held(db->mutex) );
   if( db->mallocFailed==0 ){
     if( p==0 ){
       return sqlite3DbMallocRaw(db, n);
     }
-    if( isLookaside(db, p) ){
-      if( n<=db->lookaside.sz ){
+    if( (iClass = lookasideClass(db, p))>=0 ){
+      int sz = db->lookaside.sz<<iClass;
+      if( n<=sz ){
         return p;
       }
       pNew = sqlite3DbMallocRaw(db, n);
       if( pNew ){
-        memcpy(pNew, p, db->lookaside.sz);
+        memcpy(pNew, p, sz);
         sqlite3DbFree(db, p);
       }
+    }else if( db->pArena && isArena(db, p) ){
+      if( n<=arenaSize(p) ){
+        return p;
+      }
+      pNew = sqlite3ArenaMallocRaw(db, n);
+      if( pNew ){
+        memcpy(pNew, p, arenaSize(p));
+      }
     }else{
       assert( sqlite3MemdebugHasType(p, MEMTYPE_DB) );
       assert( sqlite3MemdebugHasType(p, MEMTYPE_LOOKASIDE|MEMTYPE_HEAP) );
@@ -0,0 +1,444 @@
+/*
+** 2026 October 19
+**
+** The author disclaims copyright to this source code.  In place of
+** a legal notice, here is a blessing:
+**
+**    May you do good and not evil.
+**    May you find forgiveness for yourself and forgive others.
+**    May you share freely, never taking more than you give.
+**
+*************************************************************************
+** This file contains the C functions that implement a memory
+** allocation subsystem for use by SQLite.
+**
+** This version of the memory allocation subsystem is a layer of caches
+** in front of another allocator, the "backing heap". The backing heap is
+** whichever allocator was configured when the caches were enabled using
+** sqlite3_config(SQLITE_CONFIG_MALLOCCACHE) - the system malloc() by
+** default, or the mem5.c or mem3.c allocator working on a fixed memory
+** region if SQLITE_CONFIG_HEAP was used first.
+**
+** This version of the memory allocation subsystem is included
+** in the build only if SQLITE_ENABLE_MEMSYS6 is defined.
+**
+** The algorithm is as follows:
+**
+**   1.  Allocations of up to MEM6_MAXSIZE bytes are rounded up to one of
+**       MEM6_NCLASS size classes. There are four classes between each
+**       pair of powers of two, so that no more than 20% of a block is
+**       wasted. Larger allocations are passed to the backing heap.
+**
+**   2.  There are MEM6_NCACHE caches, each protected by its own mutex.
+**       A cache holds lists of free blocks, one for each size class.
+**       Blocks are allocated from, and freed to, a cache whenever
+**       possible. The backing heap is only used if the cache has no free
+**       block of the required size class, or if the cache already holds
+**       mem6.szCache bytes of free blocks.
+**
+**   3.  Each thread usually uses the same cache. There is no portable
+**       way to identify the calling thread, so the cache is selected by
+**       hashing the address of a variable on the stack of the thread. If
+**       the mutex of that cache is held by another thread, the others are
+**       tried in turn. So that threads do not usually contend for a
+**       mutex, and the backing heap, which is often serialized by a single
+**       mutex, is not used for most allocations.
+**
+**   4.  If the backing heap fails to allocate memory, all caches are
+**       emptied and the allocation is attempted again.
+**
+**   5.  The size class of a block is not stored in the block. It is
+**       recovered from the size of the block reported by the backing
+**       heap. A header would push blocks of a power-of-two size class
+**       just over the power of two, which the mem5.c allocator would then
+**       round up to twice the size. Instead, if the backing heap rounds
+**       the blocks of a size class up to the size of a larger class, that
+**       class is used in its place.
+*/
+#include "sqliteInt.h"
+
+/*
+** This version of the memory allocator is used only when
+** SQLITE_ENABLE_MEMSYS6 is defined.
+*/
+#ifdef SQLITE_ENABLE_MEMSYS6
+
+/*
+** The number of caches. Each cache requires one mutex.
+*/
+#ifndef SQLITE_MEMSYS6_NCACHE
+# define SQLITE_MEMSYS6_NCACHE 16
+#endif
+#define MEM6_NCACHE SQLITE_MEMSYS6_NCACHE
+
+/*
+** The largest allocation served from a size class, and the number of
+** size classes. Class 0 holds blocks of 16 bytes. Each subsequent group
+** of four classes covers the range between two powers of two, from
+** 16 to MEM6_MAXSIZE. Size class MEM6_NCLASS is used for large blocks
+** allocated directly from the backing heap.
+*/
+#define MEM6_MAXSIZE 16384
+#define MEM6_NCLASS  41
+
+/*
+** A free block in a cache. This structure overlays the start of the
+** block.
+*/
+typedef struct Mem6Free Mem6Free;
+struct Mem6Free {
+  Mem6Free *pNext;        /* Next free block of the same size class */
+};
+
+/*
+** A cache of free blocks.
+*/
+typedef struct Mem6Cache Mem6Cache;
+struct Mem6Cache {
+  sqlite3_mutex *mutex;             /* Mutex protecting this cache */
+  int nByte;                        /* Total bytes in free blocks */
+  Mem6Free *apFree[MEM6_NCLASS];    /* Free blocks of each size class */
+};
+
+/*
+** All of the static variables used by this module are collected
+** into a single structure named "mem6".  This is to keep the
+** static variables organized and to reduce namespace pollution
+** when this module is combined with other in the amalgamation.
+*/
+static SQLITE_WSD struct Mem6Global {
+  sqlite3_mem_methods backing;      /* The backing heap */
+  u8 aClass[MEM6_NCLASS];           /* Size class used for each class */
+  int szCache;                      /* Max bytes of free blocks per cache */
+  int isInit;                       /* True once the caches may be used */
+  Mem6Cache aCache[MEM6_NCACHE];    /* The caches */
+} mem6_global;
+
+#define mem6 GLOBAL(struct Mem6Global, mem6_global)
+
+/*
+** The following variable counts the number of allocations requested
+** from the backing heap. It is used by the test scripts to check that
+** the caches are working. It is not thread-safe.
+*/
+#ifdef SQLITE_TEST
+int sqlite3_memsys6_backing_count = 0;
+# define MEM6_BACKING_COUNT sqlite3_memsys6_backing_count++
+#else
+# define MEM6_BACKING_COUNT
+#endif
+
+/*
+** Return the size class for an allocation of nByte bytes, where
+** 0<nByte<=MEM6_MAXSIZE.
+*/
+static int memsys6Class(int nByte){
+  u32 m;                          /* nByte-1 */
+  int e = 4;                      /* Index of the most significant bit of m */
+  assert( nByte>0 && nByte<=MEM6_MAXSIZE );
+  if( nByte<=16 ) return 0;
+  m = (u32)(nByte-1);
+  while( (m>>(e+1))!=0 ) e++;
+  return 1 + (e-4)*4 + (int)(m>>(e-2)) - 4;
+}
+
+/*
+** Return the size in bytes of blocks of size class iClass.
+*/
+static int memsys6ClassSize(int iClass){
+  assert( iClass>=0 && iClass<MEM6_NCLASS );
+  if( iClass==0 ) return 16;
+  iClass--;
+  return (5 + iClass%4) << (2 + iClass/4);
+}
+
+/*
+** Return the size class of block p, allocated by memsys6Malloc(). This is
+** the largest class no larger than the block, or MEM6_NCLASS if the block
+** is larger than MEM6_MAXSIZE bytes.
+*/
+static int memsys6BlockClass(void *p){
+  int sz = mem6.backing.xSize(p);
+  int iClass;
+  assert( sz>=16 );
+  if( sz>MEM6_MAXSIZE ) return MEM6_NCLASS;
+  iClass = memsys6Class(sz);
+  if( memsys6ClassSize(iClass)>sz ) iClass--;
+  return iClass;
+}
+
+/*
+** Obtain the mutex of one of the caches and return a pointer to it. Or,
+** if the caches may not be used, return NULL.
+*/
+static Mem6Cache *memsys6EnterCache(void){
+  char dummy;                     /* Identifies the stack of this thread */
+  u32 h;                          /* Hash of &dummy */
+  int iHome;                      /* Cache tried first */
+  int i;
+
+  if( mem6.isInit==0 ) return 0;
+  h = ((u32)SQLITE_PTR_TO_INT(&dummy)) >> 18;
+  iHome = (int)(((h * 0x9e3779b1) >> 16) % MEM6_NCACHE);
+  for(i=0; i<MEM6_NCACHE; i++){
+    Mem6Cache *pCache = &mem6.aCache[(iHome+i) % MEM6_NCACHE];
+    if( sqlite3_mutex_try(pCache->mutex)==SQLITE_OK ){
+      return pCache;
+    }
+  }
+  sqlite3_mutex_enter(mem6.aCache[iHome].mutex);
+  return &mem6.aCache[iHome];
+}
+
+/*
+** Return all free blocks in all caches to the backing heap.
+*/
+static void memsys6FlushCaches(void){
+  int i, j;
+  for(i=0; i<MEM6_NCACHE; i++){
+    Mem6Cache *pCache = &mem6.aCache[i];
+    sqlite3_mutex_enter(pCache->mutex);
+    for(j=0; j<MEM6_NCLASS; j++){
+      while( pCache->apFree[j] ){
+        Mem6Free *p = pCache->apFree[j];
+        pCache->apFree[j] = p->pNext;
+        mem6.backing.xFree(p);
+      }
+    }
+    pCache->nByte = 0;
+    sqlite3_mutex_leave(pCache->mutex);
+  }
+}
+
+/*
+** Allocate nByte bytes from the backing heap. If this fails, empty the
+** caches and try again.
+*/
+static void *memsys6BackingMalloc(int nByte){
+  void *p;
+  MEM6_BACKING_COUNT;
+  p = mem6.backing.xMalloc(nByte);
+  if( p==0 && mem6.isInit ){
+    memsys6FlushCaches();
+    p = mem6.backing.xMalloc(nByte);
+  }
+  return p;
+}
+
+/*
+** Return the size of an outstanding allocation, in bytes. This only
+** works for chunks that are currently checked out.
+*/
+static int memsys6Size(void *pPrior){
+  if( pPrior==0 ) return 0;
+  return mem6.backing.xSize(pPrior);
+}
+
+/*
+** Allocate nByte bytes of memory.
+*/
+static void *memsys6Malloc(int nByte){
+  void *pRet = 0;
+  if( nByte>MEM6_MAXSIZE ){
+    pRet = memsys6BackingMalloc(nByte);
+  }else{
+    int iClass = mem6.aClass[memsys6Class(nByte)];
+    Mem6Cache *pCache = memsys6EnterCache();
+    if( pCache ){
+      Mem6Free *p = pCache->apFree[iClass];
+      if( p ){
+        pCache->apFree[iClass] = p->pNext;
+        pCache->nByte -= memsys6ClassSize(iClass);
+        pRet = (void*)p;
+      }
+      sqlite3_mutex_leave(pCache->mutex);
+    }
+    if( pRet==0 ){
+      pRet = memsys6BackingMalloc(memsys6ClassSize(iClass));
+    }
+  }
+  return pRet;
+}
+
+/*
+** Free memory.
+*/
+static void memsys6Free(void *pPrior){
+  int iClass;
+  assert( pPrior!=0 );
+  iClass = memsys6BlockClass(pPrior);
+  if( iClass<MEM6_NCLASS ){
+    int sz = memsys6ClassSize(iClass);
+    Mem6Cache *pCache = memsys6EnterCache();
+    if( pCache ){
+      int bCached = 0;
+      if( pCache->nByte+sz<=mem6.szCache ){
+        Mem6Free *p = (Mem6Free*)pPrior;
+        p->pNext = pCache->apFree[iClass];
+        pCache->apFree[iClass] = p;
+        pCache->nByte += sz;
+        bCached = 1;
+      }
+      sqlite3_mutex_leave(pCache->mutex);
+      if( bCached ) return;
+    }
+  }
+  mem6.backing.xFree(pPrior);
+}
+
+/*
+** Change the size of an existing memory allocation.
+**
+** The prior allocation is not freed if the new allocation fails.
+** nByte is always a value obtained from a prior call to memsys6Roundup().
+*/
+static void *memsys6Realloc(void *pPrior, int nByte){
+  int iClass;
+  void *pNew;
+  int nOld;
+
+  assert( pPrior!=0 && nByte>0 );
+  iClass = memsys6BlockClass(pPrior);
+  if( iClass==MEM6_NCLASS && nByte>MEM6_MAXSIZE ){
+    MEM6_BACKING_COUNT;
+    return mem6.backing.xRealloc(pPrior, nByte);
+  }
+  if( iClass<MEM6_NCLASS && nByte<=MEM6_MAXSIZE
+   && mem6.aClass[memsys6Class(nByte)]==iClass
+  ){
+    return pPrior;
+  }
+  pNew = memsys6Malloc(nByte);
+  if( pNew ){
+    nOld = memsys6Size(pPrior);
+    memcpy(pNew, pPrior, nOld<nByte ? nOld : nByte);
+    memsys6Free(pPrior);
+  }
+  return pNew;
+}
+
+/*
+** Round up a request size to the next valid allocation size.
+*/
+static int memsys6Roundup(int n){
+  if( n<=0 ) return n;
+  if( n>MEM6_MAXSIZE ){
+    return mem6.backing.xRoundup(n);
+  }
+  return memsys6ClassSize(mem6.aClass[memsys6Class(n)]);
+}
+
+/*
+** Free the mutexes of the caches.
+*/
+static void memsys6FreeMutexes(void){
+  int i;
+  for(i=0; i<MEM6_NCACHE; i++){
+    sqlite3_mutex_free(mem6.aCache[i].mutex);
+    mem6.aCache[i].mutex = 0;
+  }
+}
+
+/*
+** Initialize the memory allocator.
+**
+** Once the backing heap is initialized, the size class used in place of
+** each class is determined (see memsys6BlockClass()). The mutexes of the
+** caches are then allocated. Depending on the mutex implementation, this
+** may require calls to memsys6Malloc(), which are passed straight through
+** to the backing heap as the caches are not yet in use.
+*/
+static int memsys6Init(void *NotUsed){
+  int rc;
+  int i;
+  UNUSED_PARAMETER(NotUsed);
+
+  assert( mem6.isInit==0 );
+  memset(mem6.aCache, 0, sizeof(mem6.aCache));
+  rc = mem6.backing.xInit(mem6.backing.pAppData);
+  for(i=0; rc==SQLITE_OK && i<MEM6_NCLASS; i++){
+    int sz = mem6.backing.xRoundup(memsys6ClassSize(i));
+    int iClass = i;
+    while( iClass<MEM6_NCLASS-1 && memsys6ClassSize(iClass+1)<=sz ){
+      iClass++;
+    }
+    mem6.aClass[i] = (u8)iClass;
+  }
+  for(i=0; rc==SQLITE_OK && i<MEM6_NCACHE; i++){
+    if( sqlite3GlobalConfig.bCoreMutex ){
+      mem6.aCache[i].mutex = sqlite3MutexAlloc(SQLITE_MUTEX_FAST);
+      if( mem6.aCache[i].mutex==0 ) rc = SQLITE_NOMEM;
+    }
+  }
+  if( rc==SQLITE_OK ){
+    mem6.isInit = 1;
+  }else{
+    memsys6FreeMutexes();
+  }
+  return rc;
+}
+
+/*
+** Deinitialize this module.
+*/
+static void memsys6Shutdown(void *NotUsed){
+  UNUSED_PARAMETER(NotUsed);
+  if( mem6.isInit ){
+    memsys6FlushCaches();
+    mem6.isInit = 0;
+    memsys6FreeMutexes();
+  }
+  if( mem6.backing.xShutdown ){
+    mem6.backing.xShutdown(mem6.backing.pAppData);
+  }
+}
+
+/*
+** This routine is the only routine in this file with external
+** linkage. It returns a pointer to a static sqlite3_mem_methods
+** struct populated with the memsys6 methods.
+*/
+const sqlite3_mem_methods *sqlite3MemGetMemsys6(void){
+  static const sqlite3_mem_methods memsys6Methods = {
+     memsys6Malloc,
+     memsys6Free,
+     memsys6Realloc,
+     memsys6Size,
+     memsys6Roundup,
+     memsys6Init,
+     memsys6Shutdown,
+     0
+  };
+  return &memsys6Methods;
+}
+
+/*
+** Implementation of sqlite3_config(SQLITE_CONFIG_MALLOCCACHE, szCache).
+**
+** If szCache is greater than zero, install the memsys6 methods, using
+** the currently configured allocator as the backing heap. Or, if memsys6
+** is already installed, set the size of the caches only. If szCache is
+** zero or less and memsys6 is installed, restore the backing heap.
+*/
+int sqlite3Memsys6Config(int szCache){
+  const sqlite3_mem_methods *pMethods = sqlite3MemGetMemsys6();
+  int isInstalled = (sqlite3GlobalConfig.m.xMalloc==pMethods->xMalloc);
+
+  if( szCache<=0 ){
+    if( isInstalled ){
+      sqlite3GlobalConfig.m = mem6.backing;
+    }
+  }else{
+    if( !isInstalled ){
+      if( sqlite3GlobalConfig.m.xMalloc==0 ){
+        sqlite3MemSetDefault();
+      }
+      mem6.backing = sqlite3GlobalConfig.m;
+      sqlite3GlobalConfig.m = *pMethods;
+    }
+    mem6.szCache = szCache;
+  }
+  return SQLITE_OK;
+}
+
+#endif /* SQLITE_ENABLE_MEMSYS6 */
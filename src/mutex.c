@@ -137,6 +137,27 @@ void sqlite3_mutex_leave(sqlite3_mutex *p){
   }
 }
 
+#ifndef SQLITE_MUTEX_PTHREADS
+/*
+** Enter and leave the static reader/writer mutex iRw. If bShared is true
+** the mutex is entered in shared mode. Any number of threads may hold a
+** reader/writer mutex in shared mode at the same time, but while one
+** thread holds it in exclusive mode no other thread may hold it at all.
+** A thread may not enter a reader/writer mutex that it already holds.
+**
+** Only the pthreads mutex implementation provides shared access. This
+** fallback serializes all access using SQLITE_MUTEX_STATIC_MASTER.
+*/
+void sqlite3RwMutexEnter(int iRw, int bShared){
+  UNUSED_PARAMETER2(iRw, bShared);
+  sqlite3_mutex_enter(sqlite3MutexAlloc(SQLITE_MUTEX_STATIC_MASTER));
+}
+void sqlite3RwMutexLeave(int iRw){
+  UNUSED_PARAMETER(iRw);
+  sqlite3_mutex_leave(sqlite3MutexAlloc(SQLITE_MUTEX_STATIC_MASTER));
+}
+#endif
+
 #ifndef NDEBUG
 /*
 ** The sqlite3_mutex_held() and sqlite3_mutex_notheld() routine are
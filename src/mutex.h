@@ -68,4 +68,15 @@
 #define sqlite3MutexAlloc(X)      ((sqlite3_mutex*)8)
 #define sqlite3MutexInit()        SQLITE_OK
 #define sqlite3MutexEnd()
+#define sqlite3RwMutexEnter(X,Y)
+#define sqlite3RwMutexLeave(X)
 #endif /* defined(SQLITE_MUTEX_OMIT) */
+
+/*
+** Identifiers for the static reader/writer mutexes passed to
+** sqlite3RwMutexEnter() and sqlite3RwMutexLeave().
+*/
+#define SQLITE_RWMUTEX_STATIC_VFS      0   /* List of registered VFSes */
+#define SQLITE_RWMUTEX_STATIC_AUTOEXT  1   /* Automatic extension list */
+#define SQLITE_RWMUTEX_STATIC_SCHEMA   2   /* Cache of parsed schemas */
+#define SQLITE_RWMUTEX_NSTATIC         3   /* Number of static rw mutexes */
@@ -23,6 +23,7 @@
 #ifdef SQLITE_MUTEX_PTHREADS
 
 #include <pthread.h>
+#include <unistd.h>
 
 /*
 ** The sqlite3_mutex.id, sqlite3_mutex.nRef, and sqlite3_mutex.owner fields
@@ -35,11 +36,45 @@
 # define SQLITE_MUTEX_NREF 0
 #endif
 
+/*
+** The maximum number of times a thread tries to obtain a contended mutex
+** before blocking on it. Spinning is only worthwhile on multi-processor
+** hosts. Set this to zero to always block immediately.
+*/
+#ifndef SQLITE_MUTEX_SPIN
+# define SQLITE_MUTEX_SPIN 100
+#endif
+
+/*
+** The spin limit in effect. This is set by pthreadMutexInit() to either
+** SQLITE_MUTEX_SPIN or, on a single-processor host, zero.
+*/
+static int mutexSpinMax = 0;
+
+/*
+** If this variable is true when the mutex subsystem is initialized, the
+** spin limit is SQLITE_MUTEX_SPIN even on a single-processor host. This
+** allows the test scripts to exercise the spinning code on any host.
+*/
+#ifdef SQLITE_TEST
+int sqlite3_mutex_spin_always = 0;
+#endif
+
+/*
+** Hint to the processor that the calling thread is in a spin loop.
+*/
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+# define mutexSpinPause() __asm__ __volatile__("pause")
+#else
+# define mutexSpinPause()
+#endif
+
 /*
 ** Each recursive mutex is an instance of the following structure.
 */
 struct sqlite3_mutex {
   pthread_mutex_t mutex;     /* Mutex controlling the lock */
+  int nSpin;                 /* Recent number of spins needed to enter */
 #if SQLITE_MUTEX_NREF
   int id;                    /* Mutex type */
   volatile int nRef;         /* Number of entrances */
@@ -48,9 +83,10 @@ struct sqlite3_mutex {
 #endif
 };
 #if SQLITE_MUTEX_NREF
-#define SQLITE3_MUTEX_INITIALIZER { PTHREAD_MUTEX_INITIALIZER, 0, 0, (pthread_t)0, 0 }
+#define SQLITE3_MUTEX_INITIALIZER \
+    { PTHREAD_MUTEX_INITIALIZER, 0, 0, 0, (pthread_t)0, 0 }
 #else
-#define SQLITE3_MUTEX_INITIALIZER { PTHREAD_MUTEX_INITIALIZER }
+#define SQLITE3_MUTEX_INITIALIZER { PTHREAD_MUTEX_INITIALIZER, 0 }
 #endif
 
 /*
@@ -81,9 +117,48 @@ static int pthreadMutexNotheld(sqlite3_mutex *p){
 /*
 ** Initialize and deinitialize the mutex subsystem.
 */
-static int pthreadMutexInit(void){ return SQLITE_OK; }
+static int pthreadMutexInit(void){
+#ifdef _SC_NPROCESSORS_ONLN
+  mutexSpinMax = sysconf(_SC_NPROCESSORS_ONLN)>1 ? SQLITE_MUTEX_SPIN : 0;
+#else
+  mutexSpinMax = SQLITE_MUTEX_SPIN;
+#endif
+#ifdef SQLITE_TEST
+  if( sqlite3_mutex_spin_always ) mutexSpinMax = SQLITE_MUTEX_SPIN;
+#endif
+  return SQLITE_OK;
+}
 static int pthreadMutexEnd(void){ return SQLITE_OK; }
 
+/*
+** Lock the pthreads mutex of p. If the mutex is already held by another
+** thread, spin for a while before blocking in case it is released
+** soon. This avoids the cost of putting the thread to sleep and waking
+** it up again when critical sections are short.
+**
+** The number of attempts made adapts to the contention seen on each
+** mutex. It is about twice the number of attempts that were recently
+** needed to obtain the mutex without blocking, and never more than
+** mutexSpinMax. p->nSpin is only modified while the mutex is held.
+*/
+static void pthreadMutexLock(sqlite3_mutex *p){
+  if( mutexSpinMax==0 ){
+    pthread_mutex_lock(&p->mutex);
+  }else if( pthread_mutex_trylock(&p->mutex)!=0 ){
+    int nMax = p->nSpin*2 + 10;
+    int i;
+    if( nMax>mutexSpinMax ) nMax = mutexSpinMax;
+    for(i=1; i<=nMax; i++){
+      mutexSpinPause();
+      if( pthread_mutex_trylock(&p->mutex)==0 ) break;
+    }
+    if( i>nMax ){
+      pthread_mutex_lock(&p->mutex);
+    }
+    p->nSpin += (i - p->nSpin)/8;
+  }
+}
+
 /*
 ** The sqlite3_mutex_alloc() routine allocates a new
 ** mutex and returns a pointer to it.  If it returns NULL
@@ -224,7 +299,7 @@ static void pthreadMutexEnter(sqlite3_mutex *p){
     if( p->nRef>0 && pthread_equal(p->owner, self) ){
       p->nRef++;
     }else{
-      pthread_mutex_lock(&p->mutex);
+      pthreadMutexLock(p);
       assert( p->nRef==0 );
       p->owner = self;
       p->nRef = 1;
@@ -233,7 +308,7 @@ static void pthreadMutexEnter(sqlite3_mutex *p){
 #else
   /* Use the built-in recursive mutexes if they are available.
   */
-  pthread_mutex_lock(&p->mutex);
+  pthreadMutexLock(p);
 #if SQLITE_MUTEX_NREF
   assert( p->nRef>0 || p->owner==0 );
   p->owner = pthread_self();
@@ -327,6 +402,49 @@ static void pthreadMutexLeave(sqlite3_mutex *p){
 #endif
 }
 
+/*
+** The static reader/writer mutexes. See sqlite3RwMutexEnter().
+*/
+static pthread_rwlock_t aStaticRw[SQLITE_RWMUTEX_NSTATIC] = {
+  PTHREAD_RWLOCK_INITIALIZER,
+  PTHREAD_RWLOCK_INITIALIZER,
+  PTHREAD_RWLOCK_INITIALIZER
+};
+
+/*
+** Enter and leave the static reader/writer mutex iRw. If bShared is true
+** the mutex is entered in shared mode. Any number of threads may hold a
+** reader/writer mutex in shared mode at the same time, but while one
+** thread holds it in exclusive mode no other thread may hold it at all.
+** A thread may not enter a reader/writer mutex that it already holds.
+**
+** If the application has installed its own mutex implementation using
+** SQLITE_CONFIG_MUTEX, SQLite may not use pthreads directly. In that case
+** all access is serialized using SQLITE_MUTEX_STATIC_MASTER instead.
+*/
+void sqlite3RwMutexEnter(int iRw, int bShared){
+  assert( iRw>=0 && iRw<SQLITE_RWMUTEX_NSTATIC );
+  if( sqlite3GlobalConfig.bCoreMutex==0 ){
+    /* No-op */
+  }else if( sqlite3GlobalConfig.mutex.xMutexAlloc!=pthreadMutexAlloc ){
+    sqlite3_mutex_enter(sqlite3MutexAlloc(SQLITE_MUTEX_STATIC_MASTER));
+  }else if( bShared ){
+    pthread_rwlock_rdlock(&aStaticRw[iRw]);
+  }else{
+    pthread_rwlock_wrlock(&aStaticRw[iRw]);
+  }
+}
+void sqlite3RwMutexLeave(int iRw){
+  assert( iRw>=0 && iRw<SQLITE_RWMUTEX_NSTATIC );
+  if( sqlite3GlobalConfig.bCoreMutex==0 ){
+    /* No-op */
+  }else if( sqlite3GlobalConfig.mutex.xMutexAlloc!=pthreadMutexAlloc ){
+    sqlite3_mutex_leave(sqlite3MutexAlloc(SQLITE_MUTEX_STATIC_MASTER));
+  }else{
+    pthread_rwlock_unlock(&aStaticRw[iRw]);
+  }
+}
+
 sqlite3_mutex_methods const *sqlite3DefaultMutex(void){
   static const sqlite3_mutex_methods sMutex = {
     pthreadMutexInit,
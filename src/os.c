@@ -30,6 +30,7 @@
 **     sqlite3OsOpen()
 **     sqlite3OsRead()
 **     sqlite3OsWrite()
+**     sqlite3OsWriteV()
 **     sqlite3OsSync()
 **     sqlite3OsLock()
 **
@@ -68,6 +69,28 @@ int sqlite3OsWrite(sqlite3_file *id, const void *pBuf, int amt, i64 offset){
   DO_OS_MALLOC_TEST(id);
   return id->pMethods->xWrite(id, pBuf, amt, offset);
 }
+int sqlite3OsWriteV(
+  sqlite3_file *id, 
+  int nBuf, 
+  const void **apBuf, 
+  int amt, 
+  i64 offset
+){
+  const sqlite3_io_methods *pMethods = id->pMethods;
+  DO_OS_MALLOC_TEST(id);
+  if( pMethods->iVersion>=3 && pMethods->xWriteV ){
+    return pMethods->xWriteV(id, nBuf, apBuf, amt, offset);
+  }else{
+    /* The VFS does not support vectored writes. Write each buffer using
+    ** a separate call to xWrite(). */
+    int rc = SQLITE_OK;
+    int i;
+    for(i=0; rc==SQLITE_OK && i<nBuf; i++){
+      rc = pMethods->xWrite(id, apBuf[i], amt, offset + (i64)i*amt);
+    }
+    return rc;
+  }
+}
 int sqlite3OsTruncate(sqlite3_file *id, i64 size){
   return id->pMethods->xTruncate(id, size);
 }
@@ -252,30 +275,24 @@ static sqlite3_vfs * SQLITE_WSD vfsList = 0;
 */
 sqlite3_vfs *sqlite3_vfs_find(const char *zVfs){
   sqlite3_vfs *pVfs = 0;
-#if SQLITE_THREADSAFE
-  sqlite3_mutex *mutex;
-#endif
 #ifndef SQLITE_OMIT_AUTOINIT
   int rc = sqlite3_initialize();
   if( rc ) return 0;
 #endif
-#if SQLITE_THREADSAFE
-  mutex = sqlite3MutexAlloc(SQLITE_MUTEX_STATIC_MASTER);
-#endif
-  sqlite3_mutex_enter(mutex);
+  sqlite3RwMutexEnter(SQLITE_RWMUTEX_STATIC_VFS, 1);
   for(pVfs = vfsList; pVfs; pVfs=pVfs->pNext){
     if( zVfs==0 ) break;
     if( strcmp(zVfs, pVfs->zName)==0 ) break;
   }
-  sqlite3_mutex_leave(mutex);
+  sqlite3RwMutexLeave(SQLITE_RWMUTEX_STATIC_VFS);
   return pVfs;
 }
 
 /*
-** Unlink a VFS from the linked list
+** Unlink a VFS from the linked list. The caller must hold the
+** SQLITE_RWMUTEX_STATIC_VFS mutex in exclusive mode.
 */
 static void vfsUnlink(sqlite3_vfs *pVfs){
-  assert( sqlite3_mutex_held(sqlite3MutexAlloc(SQLITE_MUTEX_STATIC_MASTER)) );
   if( pVfs==0 ){
     /* No-op */
   }else if( vfsList==pVfs ){
@@ -297,13 +314,11 @@ static void vfsUnlink(sqlite3_vfs *pVfs){
 ** true.
 */
 int sqlite3_vfs_register(sqlite3_vfs *pVfs, int makeDflt){
-  sqlite3_mutex *mutex = 0;
 #ifndef SQLITE_OMIT_AUTOINIT
   int rc = sqlite3_initialize();
   if( rc ) return rc;
 #endif
-  mutex = sqlite3MutexAlloc(SQLITE_MUTEX_STATIC_MASTER);
-  sqlite3_mutex_enter(mutex);
+  sqlite3RwMutexEnter(SQLITE_RWMUTEX_STATIC_VFS, 0);
   vfsUnlink(pVfs);
   if( makeDflt || vfsList==0 ){
     pVfs->pNext = vfsList;
@@ -313,7 +328,7 @@ int sqlite3_vfs_register(sqlite3_vfs *pVfs, int makeDflt){
     vfsList->pNext = pVfs;
   }
   assert(vfsList);
-  sqlite3_mutex_leave(mutex);
+  sqlite3RwMutexLeave(SQLITE_RWMUTEX_STATIC_VFS);
   return SQLITE_OK;
 }
 
@@ -321,11 +336,8 @@ int sqlite3_vfs_register(sqlite3_vfs *pVfs, int makeDflt){
 ** Unregister a VFS so that it is no longer accessible.
 */
 int sqlite3_vfs_unregister(sqlite3_vfs *pVfs){
-#if SQLITE_THREADSAFE
-  sqlite3_mutex *mutex = sqlite3MutexAlloc(SQLITE_MUTEX_STATIC_MASTER);
-#endif
-  sqlite3_mutex_enter(mutex);
+  sqlite3RwMutexEnter(SQLITE_RWMUTEX_STATIC_VFS, 0);
   vfsUnlink(pVfs);
-  sqlite3_mutex_leave(mutex);
+  sqlite3RwMutexLeave(SQLITE_RWMUTEX_STATIC_VFS);
   return SQLITE_OK;
 }
@@ -237,6 +237,7 @@ int sqlite3OsInit(void);
 int sqlite3OsClose(sqlite3_file*);
 int sqlite3OsRead(sqlite3_file*, void*, int amt, i64 offset);
 int sqlite3OsWrite(sqlite3_file*, const void*, int amt, i64 offset);
+int sqlite3OsWriteV(sqlite3_file*, int, const void**, int amt, i64 offset);
 int sqlite3OsTruncate(sqlite3_file*, i64 size);
 int sqlite3OsSync(sqlite3_file*, int);
 int sqlite3OsFileSize(sqlite3_file*, i64 *pSize);
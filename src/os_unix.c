@@ -123,6 +123,55 @@
 #include <sys/mman.h>
 #endif
 
+/*
+** Define HAVE_PWRITEV to 1 if the pwritev() system call is available, 
+** in which case it is used to write runs of database pages (see 
+** unixWriteV()).
+*/
+#if !defined(HAVE_PWRITEV) && defined(__linux__)
+# define HAVE_PWRITEV 1
+#endif
+#if defined(HAVE_PWRITEV) && HAVE_PWRITEV
+# include <sys/uio.h>
+#endif
+
+/*
+** Define HAVE_SYNC_FILE_RANGE to 1 if the Linux sync_file_range() system
+** call is available. It is used to start writing back a range of a file
+** before it is synced (see SQLITE_FCNTL_WRITEBACK).
+*/
+#if !defined(HAVE_SYNC_FILE_RANGE) && defined(__linux__)
+# define HAVE_SYNC_FILE_RANGE 1
+#endif
+
+/*
+** The "unix-uring" VFS is only available on Linux builds compiled with
+** SQLITE_ENABLE_IO_URING.
+*/
+#if defined(SQLITE_ENABLE_IO_URING) && defined(__linux__)
+# define UNIX_URING 1
+# include <sys/syscall.h>
+# include <sys/mman.h>
+# include <linux/io_uring.h>
+#else
+# define UNIX_URING 0
+#endif
+
+/*
+** Define UNIX_DIRECT_IO to 1 if the O_DIRECT open flag is available. It
+** is set on database files opened with the "direct_io" URI parameter
+** (see unixDirectIoEnable()). Some C libraries only define
+** O_DIRECT for _GNU_SOURCE builds, so use their internal name for it.
+*/
+#if !defined(O_DIRECT) && defined(__O_DIRECT)
+# define O_DIRECT __O_DIRECT
+#endif
+#if defined(O_DIRECT) && !defined(SQLITE_OMIT_DIRECT_IO)
+# define UNIX_DIRECT_IO 1
+#else
+# define UNIX_DIRECT_IO 0
+#endif
+
 #if SQLITE_ENABLE_LOCKING_STYLE
 # include <sys/ioctl.h>
 # if OS_VXWORKS
@@ -203,6 +252,7 @@ struct UnixUnusedFd {
 ** The unixFile structure is subclass of sqlite3_file specific to the unix
 ** VFS implementations.
 */
+typedef struct UringQueue UringQueue;
 typedef struct unixFile unixFile;
 struct unixFile {
   sqlite3_io_methods const *pMethod;  /* Always the first entry */
@@ -216,6 +266,11 @@ struct unixFile {
   const char *zPath;                  /* Name of the file */
   unixShm *pShm;                      /* Shared memory segment information */
   int szChunk;                        /* Configured by FCNTL_CHUNK_SIZE */
+  int szDirect;                       /* I/O alignment for O_DIRECT, or 0 */
+#if UNIX_URING
+  UringQueue *pUring;                 /* Queue of batched writes */
+  unsigned char bBatch;               /* True between BEGIN_BATCH and END */
+#endif
 #if SQLITE_ENABLE_LOCKING_STYLE
   int openFlags;                      /* The flags specified at open() */
 #endif
@@ -407,6 +462,29 @@ static struct unix_syscall {
   { "openDirectory",    (sqlite3_syscall_ptr)openDirectory,      0 },
 #define osOpenDirectory ((int(*)(const char*,int*))aSyscall[17].pCurrent)
 
+#if defined(HAVE_PWRITEV) && HAVE_PWRITEV
+  { "pwritev",      (sqlite3_syscall_ptr)pwritev,          0 },
+#else
+  { "pwritev",      (sqlite3_syscall_ptr)0,                0 },
+#endif
+#define osPwritev   ((ssize_t(*)(int,const struct iovec*,int,off_t))\
+                    aSyscall[18].pCurrent)
+
+#if defined(POSIX_FADV_WILLNEED)
+  { "posix_fadvise", (sqlite3_syscall_ptr)posix_fadvise,   0 },
+#else
+  { "posix_fadvise", (sqlite3_syscall_ptr)0,               0 },
+#endif
+#define osPosixFadvise ((int(*)(int,off_t,off_t,int))aSyscall[19].pCurrent)
+
+#if defined(HAVE_SYNC_FILE_RANGE) && HAVE_SYNC_FILE_RANGE
+  { "sync_file_range", (sqlite3_syscall_ptr)sync_file_range, 0 },
+#else
+  { "sync_file_range", (sqlite3_syscall_ptr)0,               0 },
+#endif
+#define osSyncFileRange ((int(*)(int,off_t,off_t,unsigned int))\
+                        aSyscall[20].pCurrent)
+
 }; /* End of the overrideable system calls */
 
 /*
@@ -2942,6 +3020,28 @@ static int nfsUnlock(sqlite3_file *id, int eFileLock){
 ** are gather together into this division.
 */
 
+#if UNIX_DIRECT_IO
+/*
+** True if a read or write of cnt bytes at offset between file pFile and
+** buffer pBuf cannot be passed to the operating system as is, because
+** the file uses O_DIRECT and the address of the buffer, the offset or the
+** size is not a multiple of the required alignment.
+*/
+#define unixDirectUnaligned(pFile, pBuf, cnt, offset) ((pFile)->szDirect && \
+  ((SQLITE_PTR_TO_INT(pBuf) | (int)(offset) | (cnt)) & ((pFile)->szDirect-1)))
+
+static int unixDirectIo(unixFile*, int, void*, int, i64);
+#endif
+
+#ifdef SQLITE_TEST
+/*
+** Count the reads and writes on O_DIRECT files that go through the
+** temporary aligned buffer of unixDirectIo(). This is used to test that
+** page reads and writes use the page buffers directly.
+*/
+int sqlite3_unix_directio_copy_count = 0;
+#endif
+
 /*
 ** Seek to the offset passed as the second argument, then read cnt 
 ** bytes into pBuf. Return the number of bytes actually read.
@@ -2959,6 +3059,11 @@ static int seekAndRead(unixFile *id, sqlite3_int64 offset, void *pBuf, int cnt){
   int got;
 #if (!defined(USE_PREAD) && !defined(USE_PREAD64))
   i64 newOffset;
+#endif
+#if UNIX_DIRECT_IO
+  if( unixDirectUnaligned(id, pBuf, cnt, offset) ){
+    return unixDirectIo(id, 0, pBuf, cnt, offset);
+  }
 #endif
   TIMER_START;
 #if defined(USE_PREAD)
@@ -3037,6 +3142,11 @@ static int seekAndWrite(unixFile *id, i64 offset, const void *pBuf, int cnt){
   int got;
 #if (!defined(USE_PREAD) && !defined(USE_PREAD64))
   i64 newOffset;
+#endif
+#if UNIX_DIRECT_IO
+  if( unixDirectUnaligned(id, pBuf, cnt, offset) ){
+    return unixDirectIo(id, 1, (void*)pBuf, cnt, offset);
+  }
 #endif
   TIMER_START;
 #if defined(USE_PREAD)
@@ -3067,6 +3177,136 @@ static int seekAndWrite(unixFile *id, i64 offset, const void *pBuf, int cnt){
   return got;
 }
 
+#if UNIX_DIRECT_IO
+/*
+** This function is used by seekAndRead() and seekAndWrite() for reads and
+** writes on an O_DIRECT file that are not suitably aligned, such as the
+** read of the 100-byte database header. Page buffers are aligned by the page cache (see
+** SQLITE_FCNTL_BUFFER_ALIGN), so most page I/O does not come here. It
+** reads or writes (if bWrite is true) cnt bytes at offset of file pFile
+** via a temporary aligned buffer that covers all of the blocks touched by
+** the request.
+**
+** A write that covers only part of the first or last block first reads
+** the blocks, so that the bytes outside of the request are written back
+** unchanged. If this extends the file past the end of the request, it is
+** truncated again afterwards. A write of whole blocks from an unaligned
+** buffer does not need to read anything.
+**
+** The return value is the number of bytes read or written, or -1 if an
+** error occurs, as for seekAndRead() and seekAndWrite().
+*/
+static int unixDirectIo(
+  unixFile *pFile,                /* O_DIRECT file to read or write */
+  int bWrite,                     /* True to write, false to read */
+  void *pBuf,                     /* Buffer to read into or write from */
+  int cnt,                        /* Bytes to read or write */
+  i64 offset                      /* Offset in file */
+){
+  const int sz = pFile->szDirect;
+  i64 iFirst = offset & ~(i64)(sz-1);
+  int nByte = (int)(((offset+cnt+sz-1) & ~(i64)(sz-1)) - iFirst);
+  int iOff = (int)(offset - iFirst);
+  u8 *aAlloc;                     /* Allocation containing aBuf */
+  u8 *aBuf;                       /* Aligned buffer of nByte bytes */
+  int got;                        /* Bytes read into aBuf */
+  int rc;                         /* Return value */
+
+  assert( sz>=512 && (sz&(sz-1))==0 );
+#ifdef SQLITE_TEST
+  sqlite3_unix_directio_copy_count++;
+#endif
+  aAlloc = (u8*)sqlite3_malloc(nByte+sz);
+  if( aAlloc==0 ){
+    pFile->lastErrno = ENOMEM;
+    return -1;
+  }
+  aBuf = &aAlloc[(sz - (SQLITE_PTR_TO_INT(aAlloc) & (sz-1))) & (sz-1)];
+
+  if( bWrite && iOff==0 && cnt==nByte ){
+    got = nByte;
+  }else{
+    got = seekAndRead(pFile, iFirst, aBuf, nByte);
+  }
+  if( got<0 ){
+    rc = -1;
+  }else if( bWrite==0 ){
+    rc = got - iOff;
+    if( rc<0 ) rc = 0;
+    if( rc>cnt ) rc = cnt;
+    memcpy(pBuf, &aBuf[iOff], rc);
+  }else{
+    int wrote;
+    memset(&aBuf[got], 0, nByte-got);
+    memcpy(&aBuf[iOff], pBuf, cnt);
+    wrote = seekAndWrite(pFile, iFirst, aBuf, nByte);
+    if( wrote<0 ){
+      rc = -1;
+    }else{
+      rc = wrote - iOff;
+      if( rc<0 ) rc = 0;
+      if( rc>cnt ) rc = cnt;
+    }
+    if( wrote==nByte && got<nByte ){
+      /* The file used to end within the blocks written. Remove the zero
+      ** bytes written past the new end of the file to fill the last block. */
+      int iEnd = (got>iOff+cnt ? got : iOff+cnt);
+      if( iEnd<nByte && robust_ftruncate(pFile->h, iFirst+iEnd) ){
+        pFile->lastErrno = errno;
+        rc = -1;
+      }
+    }
+  }
+
+  sqlite3_free(aAlloc);
+  return rc;
+}
+
+/*
+** If the database file pFile was opened with the URI parameter
+** "direct_io" set to true, set the O_DIRECT flag on its file descriptor,
+** so that the content of the file is cached by SQLite only and not also by
+** the operating system. If bReused is true, the file descriptor has been
+** reused from an earlier connection that may have set the flag, so make
+** sure it is clear if it is not wanted.
+**
+** If the file-system does not support O_DIRECT, the file is used without
+** it.
+**
+** The flag is never set on WAL files. WAL frames consist of a 24-byte
+** header followed by a page, so no frame is aligned to a block, and each
+** append would need a read-modify-write of the blocks at either end of
+** it. The WAL is also written sequentially and read back soon after by
+** checkpoints, both of which the operating system cache handles well.
+*/
+static void unixDirectIoEnable(unixFile *pFile, const char *zPath, int bReused){
+  const char *zDirect = sqlite3_uri_parameter(zPath, "direct_io");
+  int bDirect = (zDirect && sqlite3GetBoolean(zDirect));
+  int flags;
+
+  pFile->szDirect = 0;
+  if( bDirect==0 && bReused==0 ) return;
+  flags = osFcntl(pFile->h, F_GETFL);
+  if( flags<0 ) return;
+  if( bDirect ){
+    struct stat buf;
+    if( osFstat(pFile->h, &buf) || osFcntl(pFile->h, F_SETFL, flags|O_DIRECT) ){
+      return;
+    }
+    /* Align I/O to the file-system block size, which is a multiple of the
+    ** logical block size of the device. */
+    pFile->szDirect = 4096;
+    if( buf.st_blksize>=512 && buf.st_blksize<=65536
+     && (buf.st_blksize & (buf.st_blksize-1))==0
+    ){
+      pFile->szDirect = (int)buf.st_blksize;
+    }
+  }else if( flags & O_DIRECT ){
+    osFcntl(pFile->h, F_SETFL, flags & ~O_DIRECT);
+  }
+}
+#endif /* UNIX_DIRECT_IO */
+
 
 /*
 ** Write data from a buffer into a file.  Return SQLITE_OK on success
@@ -3135,6 +3375,78 @@ static int unixWrite(
   return SQLITE_OK;
 }
 
+/*
+** Write the nBuf buffers in apBuf[], each amt bytes in size, to the file
+** one after another, starting at offset. This is the same as nBuf calls
+** to unixWrite(), except that a single pwritev() is used where possible.
+** If pwritev() fails or writes less than all of the data, the remainder
+** is written by unixWrite(), which also takes care of reporting errors.
+*/
+static int unixWriteV(
+  sqlite3_file *id, 
+  int nBuf,
+  const void **apBuf, 
+  int amt,
+  sqlite3_int64 offset 
+){
+  int rc = SQLITE_OK;
+#if defined(HAVE_PWRITEV) && HAVE_PWRITEV
+  unixFile *pFile = (unixFile*)id;
+  struct iovec aIov[64];          /* Buffers to pass to pwritev() */
+  int nIov;                       /* Number of valid entries in aIov[] */
+  i64 wrote;                      /* Bytes written by pwritev() */
+  int i;
+
+  assert( amt>0 );
+  SimulateIOError( return SQLITE_IOERR_WRITE );
+  SimulateDiskfullError( return SQLITE_FULL );
+
+#ifndef NDEBUG
+  /* Let unixWrite() make its checks on writes to the database file */
+  if( pFile->inNormalWrite && offset<=24 ){
+    rc = unixWrite(id, apBuf[0], amt, offset);
+    apBuf++;
+    nBuf--;
+    offset += amt;
+  }
+#endif
+
+  /* An O_DIRECT file is written one page at a time, as pwritev() would 
+  ** require each of the buffers to be aligned.  */
+  while( rc==SQLITE_OK && nBuf>1 && pFile->szDirect==0 ){
+    nIov = nBuf<ArraySize(aIov) ? nBuf : ArraySize(aIov);
+    for(i=0; i<nIov; i++){
+      aIov[i].iov_base = (void*)apBuf[i];
+      aIov[i].iov_len = amt;
+    }
+    TIMER_START;
+    do{ 
+      wrote = osPwritev(pFile->h, aIov, nIov, offset); 
+    }while( wrote<0 && errno==EINTR );
+    TIMER_END;
+    OSTRACE(("WRITEV  %-3d %5d %7lld %llu\n", 
+             pFile->h, (int)wrote, offset, TIMER_ELAPSED));
+    if( wrote<0 ) wrote = 0;
+    i = (int)(wrote/amt);
+    if( i<nIov ){
+      /* A short write. Write the rest of buffer i using unixWrite(). */
+      int nDone = (int)(wrote % amt);
+      rc = unixWrite(id, &((u8*)apBuf[i])[nDone], amt-nDone, offset+wrote);
+      i++;
+    }
+    apBuf += i;
+    nBuf -= i;
+    offset += (i64)i*amt;
+  }
+#endif
+  for(; rc==SQLITE_OK && nBuf>0; nBuf--){
+    rc = unixWrite(id, apBuf[0], amt, offset);
+    apBuf++;
+    offset += amt;
+  }
+  return rc;
+}
+
 #ifdef SQLITE_TEST
 /*
 ** Count the number of fullsyncs and normal syncs.  This is used to test
@@ -3149,8 +3461,14 @@ int sqlite3_fullsync_count = 0;
 ** Others do no.  To be safe, we will stick with the (slightly slower)
 ** fsync(). If you know that your system does support fdatasync() correctly,
 ** then simply compile with -Dfdatasync=fdatasync
+**
+** Linux is an exception. Its fdatasync() also writes the inode if the
+** file size has changed (see the comments above full_fsync()). Only the
+** other inode attributes, such as the mtime, are left unsynced, so
+** fdatasync() is used there unless SQLITE_DISABLE_FDATASYNC is defined.
 */
-#if !defined(fdatasync)
+#if !defined(fdatasync) \
+ && (!defined(__linux__) || defined(SQLITE_DISABLE_FDATASYNC))
 # define fdatasync fsync
 #endif
 
@@ -3515,6 +3833,27 @@ static int unixFileControl(sqlite3_file *id, int op, void *pArg){
       SimulateIOErrorBenign(0);
       return rc;
     }
+#if defined(HAVE_SYNC_FILE_RANGE) && HAVE_SYNC_FILE_RANGE
+    case SQLITE_FCNTL_WRITEBACK: {
+      i64 *aRange = (i64*)pArg;
+      osSyncFileRange(pFile->h, aRange[0], aRange[1], SYNC_FILE_RANGE_WRITE);
+      return SQLITE_OK;
+    }
+#endif
+#if UNIX_DIRECT_IO
+    case SQLITE_FCNTL_BUFFER_ALIGN: {
+      if( pFile->szDirect==0 ) return SQLITE_NOTFOUND;
+      *(int*)pArg = pFile->szDirect;
+      return SQLITE_OK;
+    }
+#endif
+#if defined(POSIX_FADV_WILLNEED)
+    case SQLITE_FCNTL_PREFETCH: {
+      i64 *aRange = (i64*)pArg;
+      osPosixFadvise(pFile->h, aRange[0], aRange[1], POSIX_FADV_WILLNEED);
+      return SQLITE_OK;
+    }
+#endif
     case SQLITE_FCNTL_PERSIST_WAL: {
       int bPersist = *(int*)pArg;
       if( bPersist<0 ){
@@ -4223,6 +4562,460 @@ static int unixShmUnmap(
 # define unixShmUnmap   0
 #endif /* #ifndef SQLITE_OMIT_WAL */
 
+#ifdef SQLITE_TEST
+/*
+** If this variable is set to a value greater than zero, uringFlush()
+** submits at most that many writes to the kernel per io_uring_enter()
+** call. This is used to test the handling of a kernel that accepts only
+** part of a batch.
+*/
+int sqlite3_uring_max_submit = 0;
+#endif
+
+#if UNIX_URING
+/*
+******************************* io_uring ************************************
+**
+** The "unix-uring" VFS is identical to "unix", except that the writes
+** made to a file between an SQLITE_FCNTL_BEGIN_BATCH and the following
+** SQLITE_FCNTL_END_BATCH file-control are not made one at a time. They
+** are copied into a queue and submitted to the kernel together through
+** an io_uring, so that writing N scattered pages costs one system call
+** instead of N. The END_BATCH file-control does not return until all
+** of the writes have completed, and returns the first error, if any.
+** The pager uses this for the dirty pages written by a commit or cache
+** spill, and the WAL code for the pages copied by a checkpoint.
+**
+** Reads that overlap a queued write, and calls that depend on the file
+** size or on the writes being on disk (xTruncate, xSync, xFileSize,
+** xUnlock and xClose), wait for the queue to drain first. Outside of 
+** a batch, and if an io_uring cannot be set up, every call is passed
+** straight through to the "unix" methods.
+**
+** Each unixFile has its own queue. This is safe as a unixFile is never
+** used by more than one thread at a time.
+*/
+
+/*
+** Maximum number of writes queued before they are submitted.
+*/
+#ifndef SQLITE_URING_QUEUE_DEPTH
+# define SQLITE_URING_QUEUE_DEPTH 64
+#endif
+
+/*
+** An io_uring and the writes queued on it. The aSlot[] entries hold
+** private copies of the data written, as the caller may reuse its 
+** buffer as soon as xWrite() returns.
+*/
+struct UringQueue {
+  int fd;                         /* io_uring file descriptor */
+  void *pSqRing;                  /* Mapping of submission queue ring */
+  void *pCqRing;                  /* Mapping of completion queue ring */
+  struct io_uring_sqe *aSqe;      /* Mapping of submission queue entries */
+  size_t szSqRing;                /* Size of pSqRing mapping in bytes */
+  size_t szCqRing;                /* Size of pCqRing mapping in bytes */
+  size_t szSqe;                   /* Size of aSqe mapping in bytes */
+  unsigned *pSqTail;              /* Submission queue tail */
+  unsigned *pSqMask;              /* Submission queue index mask */
+  unsigned *aSqArray;             /* Submission queue index array */
+  unsigned *pCqHead;              /* Completion queue head */
+  unsigned *pCqTail;              /* Completion queue tail */
+  unsigned *pCqMask;              /* Completion queue index mask */
+  struct io_uring_cqe *aCqe;      /* Completion queue entries */
+  int nQueued;                    /* Number of aSlot[] entries in use */
+  int nSubmit;                    /* Queued writes not yet submitted */
+  struct UringSlot {
+    char *aBuf;                   /* Copy of the data to write */
+    int nAlloc;                   /* Allocated size of aBuf[] */
+    int amt;                      /* Number of bytes to write */
+    i64 iOff;                     /* Offset to write to */
+  } aSlot[SQLITE_URING_QUEUE_DEPTH];
+};
+
+/*
+** Free a queue allocated by uringQueueOpen(), including the io_uring.
+*/
+static void uringQueueClose(unixFile *pFile){
+  UringQueue *p = pFile->pUring;
+  if( p ){
+    int i;
+    if( p->aSqe ) munmap(p->aSqe, p->szSqe);
+    if( p->pCqRing ) munmap(p->pCqRing, p->szCqRing);
+    if( p->pSqRing ) munmap(p->pSqRing, p->szSqRing);
+    if( p->fd>=0 ) robust_close(pFile, p->fd, __LINE__);
+    for(i=0; i<SQLITE_URING_QUEUE_DEPTH; i++){
+      sqlite3_free(p->aSlot[i].aBuf);
+    }
+    sqlite3_free(p);
+    pFile->pUring = 0;
+  }
+}
+
+/*
+** Return true if the io_uring opened as file descriptor fd supports
+** IORING_OP_WRITE. That opcode, and IORING_REGISTER_PROBE, were added 
+** to Linux 5.6. Earlier kernels with io_uring support fail the probe.
+*/
+static int uringSupportsWrite(int fd){
+  struct io_uring_probe *pProbe;
+  u64 aProbe[(sizeof(struct io_uring_probe) 
+            + (IORING_OP_WRITE+1)*sizeof(struct io_uring_probe_op) + 7)/8];
+
+  memset(aProbe, 0, sizeof(aProbe));
+  pProbe = (struct io_uring_probe*)aProbe;
+  if( syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, 
+              pProbe, IORING_OP_WRITE+1)<0 
+  ){
+    return 0;
+  }
+  return pProbe->last_op>=IORING_OP_WRITE
+      && (pProbe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED)!=0;
+}
+
+/*
+** Set up an io_uring for file pFile, if this has not already been done.
+** Return SQLITE_OK if successful, or SQLITE_NOMEM or SQLITE_IOERR if 
+** not. The kernel may not support io_uring, or may not support the
+** IORING_OP_WRITE operation, so an error here is not fatal. The caller 
+** falls back to plain pwrite() calls instead.
+*/
+static int uringQueueOpen(unixFile *pFile){
+  struct io_uring_params params;
+  UringQueue *p;
+  u8 *aSq, *aCq;
+
+  if( pFile->pUring ) return SQLITE_OK;
+  sqlite3BeginBenignMalloc();
+  p = (UringQueue*)sqlite3_malloc(sizeof(UringQueue));
+  sqlite3EndBenignMalloc();
+  if( p==0 ) return SQLITE_NOMEM;
+  memset(p, 0, sizeof(UringQueue));
+  pFile->pUring = p;
+
+  memset(&params, 0, sizeof(params));
+  p->fd = (int)syscall(
+      __NR_io_uring_setup, SQLITE_URING_QUEUE_DEPTH, &params
+  );
+  if( p->fd<0 ) goto uring_open_failed;
+  if( !uringSupportsWrite(p->fd) ) goto uring_open_failed;
+
+  p->szSqRing = params.sq_off.array + params.sq_entries*sizeof(unsigned);
+  p->szCqRing = params.cq_off.cqes 
+              + params.cq_entries*sizeof(struct io_uring_cqe);
+  p->szSqe = params.sq_entries*sizeof(struct io_uring_sqe);
+  p->pSqRing = mmap(0, p->szSqRing, PROT_READ|PROT_WRITE, 
+                    MAP_SHARED|MAP_POPULATE, p->fd, IORING_OFF_SQ_RING);
+  if( p->pSqRing==MAP_FAILED ){ p->pSqRing = 0; goto uring_open_failed; }
+  p->pCqRing = mmap(0, p->szCqRing, PROT_READ|PROT_WRITE, 
+                    MAP_SHARED|MAP_POPULATE, p->fd, IORING_OFF_CQ_RING);
+  if( p->pCqRing==MAP_FAILED ){ p->pCqRing = 0; goto uring_open_failed; }
+  p->aSqe = (struct io_uring_sqe*)mmap(0, p->szSqe, PROT_READ|PROT_WRITE,
+                    MAP_SHARED|MAP_POPULATE, p->fd, IORING_OFF_SQES);
+  if( p->aSqe==MAP_FAILED ){ p->aSqe = 0; goto uring_open_failed; }
+
+  aSq = (u8*)p->pSqRing;
+  aCq = (u8*)p->pCqRing;
+  p->pSqTail = (unsigned*)&aSq[params.sq_off.tail];
+  p->pSqMask = (unsigned*)&aSq[params.sq_off.ring_mask];
+  p->aSqArray = (unsigned*)&aSq[params.sq_off.array];
+  p->pCqHead = (unsigned*)&aCq[params.cq_off.head];
+  p->pCqTail = (unsigned*)&aCq[params.cq_off.tail];
+  p->pCqMask = (unsigned*)&aCq[params.cq_off.ring_mask];
+  p->aCqe = (struct io_uring_cqe*)&aCq[params.cq_off.cqes];
+  return SQLITE_OK;
+
+ uring_open_failed:
+  pFile->lastErrno = errno;
+  uringQueueClose(pFile);
+  return SQLITE_IOERR;
+}
+
+/*
+** Wait for nWait writes that have been submitted to the kernel to 
+** complete, and discard their results. This is called after 
+** io_uring_enter() has failed, so that the aSlot[] buffers the writes
+** read from are not freed while they are in progress. If the kernel
+** will not wait for the completions, poll the completion queue for them.
+*/
+static void uringDrain(UringQueue *p, int nWait){
+  while( nWait>0 ){
+    unsigned iHead = *p->pCqHead;
+    unsigned iTail = __atomic_load_n(p->pCqTail, __ATOMIC_ACQUIRE);
+    if( iHead!=iTail ){
+      nWait -= (int)(iTail - iHead);
+      __atomic_store_n(p->pCqHead, iTail, __ATOMIC_RELEASE);
+    }else if( syscall(__NR_io_uring_enter, p->fd, 0, nWait, 
+                      IORING_ENTER_GETEVENTS, 0, 0)<0 && errno!=EINTR
+    ){
+      usleep(100);
+    }
+  }
+}
+
+/*
+** Submit all queued writes to the kernel and wait for them to complete.
+** Return SQLITE_OK if they were all successful, or an error code 
+** otherwise. Either way, the queue is empty when this function returns.
+**
+** The kernel may accept only some of the writes submitted to it at once.
+** In that case the others are submitted once it has accepted the first.
+** This function never waits for more completions than there are writes
+** in flight, as it would block forever if it did.
+**
+** As in unixWrite(), a write that cannot be completed because the disk
+** is full is reported as SQLITE_FULL. A short write is retried using
+** unixWrite().
+*/
+static int uringFlush(unixFile *pFile){
+  UringQueue *p = pFile->pUring;
+  int rc = SQLITE_OK;
+  int nDone = 0;
+
+  if( p==0 || p->nQueued==0 ) return SQLITE_OK;
+  while( nDone<p->nQueued ){
+    unsigned iHead;
+    unsigned iTail;
+    int nFlight;
+    int res;
+
+    /* Submit the writes not yet accepted by the kernel. */
+    if( p->nSubmit>0 ){
+      int nSubmit = p->nSubmit;
+#ifdef SQLITE_TEST
+      if( sqlite3_uring_max_submit>0 && nSubmit>sqlite3_uring_max_submit ){
+        nSubmit = sqlite3_uring_max_submit;
+      }
+#endif
+      res = (int)syscall(__NR_io_uring_enter, p->fd, nSubmit, 0, 0, 0, 0);
+      if( res<0 ){
+        if( errno==EINTR ) continue;
+        pFile->lastErrno = errno;
+        rc = SQLITE_IOERR_WRITE;
+        break;
+      }
+      p->nSubmit -= res;
+    }
+
+    /* If no completions are ready, wait for the writes in flight. */
+    nFlight = p->nQueued - p->nSubmit - nDone;
+    iHead = *p->pCqHead;
+    iTail = __atomic_load_n(p->pCqTail, __ATOMIC_ACQUIRE);
+    if( iHead==iTail ){
+      if( nFlight==0 ){
+        /* The kernel accepted none of the writes, and none are pending. */
+        pFile->lastErrno = EAGAIN;
+        rc = SQLITE_IOERR_WRITE;
+        break;
+      }
+      res = (int)syscall(__NR_io_uring_enter, p->fd, 0, nFlight, 
+                         IORING_ENTER_GETEVENTS, 0, 0);
+      if( res<0 ){
+        if( errno==EINTR ) continue;
+        pFile->lastErrno = errno;
+        rc = SQLITE_IOERR_WRITE;
+        break;
+      }
+      iTail = __atomic_load_n(p->pCqTail, __ATOMIC_ACQUIRE);
+    }
+
+    /* Reap completions. */
+    while( iHead!=iTail ){
+      struct io_uring_cqe *pCqe = &p->aCqe[iHead & *p->pCqMask];
+      struct UringSlot *pSlot = &p->aSlot[pCqe->user_data];
+      if( pCqe->res<0 ){
+        if( rc==SQLITE_OK ){
+          pFile->lastErrno = -pCqe->res;
+          rc = (-pCqe->res==ENOSPC) ? SQLITE_FULL : SQLITE_IOERR_WRITE;
+        }
+      }else if( pCqe->res<pSlot->amt && rc==SQLITE_OK ){
+        rc = unixWrite((sqlite3_file*)pFile, &pSlot->aBuf[pCqe->res],
+            pSlot->amt - pCqe->res, pSlot->iOff + pCqe->res
+        );
+      }
+      iHead++;
+      nDone++;
+    }
+    __atomic_store_n(p->pCqHead, iHead, __ATOMIC_RELEASE);
+  }
+
+  if( nDone<p->nQueued ){
+    /* io_uring_enter() failed. The writes already submitted may still be
+    ** in progress, and they reference the aSlot[] buffers. Wait for them
+    ** before freeing the queue, and use plain writes from now on. */
+    uringDrain(p, p->nQueued - p->nSubmit - nDone);
+    uringQueueClose(pFile);
+  }else{
+    p->nQueued = 0;
+    p->nSubmit = 0;
+  }
+  return rc;
+}
+
+/*
+** Return true if the nByte bytes starting at iOff overlap a queued write.
+*/
+static int uringOverlap(unixFile *pFile, i64 iOff, int nByte){
+  UringQueue *p = pFile->pUring;
+  int i;
+  if( p ){
+    for(i=0; i<p->nQueued; i++){
+      struct UringSlot *pSlot = &p->aSlot[i];
+      if( iOff<pSlot->iOff+pSlot->amt && pSlot->iOff<iOff+nByte ) return 1;
+    }
+  }
+  return 0;
+}
+
+/*
+** Add a write of the nBuf buffers in apBuf[], each amt bytes in size, to
+** the queue. The caller has already made sure that the queue is not full
+** and that the write does not overlap a queued one.
+*/
+static int uringQueueWrite(
+  unixFile *pFile, 
+  int nBuf,
+  const void **apBuf, 
+  int amt, 
+  i64 offset
+){
+  UringQueue *p = pFile->pUring;
+  struct UringSlot *pSlot = &p->aSlot[p->nQueued];
+  struct io_uring_sqe *pSqe;
+  int nByte = nBuf*amt;
+  unsigned iTail;
+  unsigned iIdx;
+  int i;
+
+  if( pSlot->nAlloc<nByte ){
+    char *aNew = (char*)sqlite3_realloc(pSlot->aBuf, nByte);
+    if( aNew==0 ) return SQLITE_NOMEM;
+    pSlot->aBuf = aNew;
+    pSlot->nAlloc = nByte;
+  }
+  for(i=0; i<nBuf; i++){
+    memcpy(&pSlot->aBuf[i*amt], apBuf[i], amt);
+  }
+  pSlot->amt = nByte;
+  pSlot->iOff = offset;
+
+  iTail = *p->pSqTail;
+  iIdx = iTail & *p->pSqMask;
+  pSqe = &p->aSqe[iIdx];
+  memset(pSqe, 0, sizeof(*pSqe));
+  pSqe->opcode = IORING_OP_WRITE;
+  pSqe->fd = pFile->h;
+  pSqe->addr = (u64)(unsigned long)pSlot->aBuf;
+  pSqe->len = nByte;
+  pSqe->off = offset;
+  pSqe->user_data = p->nQueued;
+  p->aSqArray[iIdx] = iIdx;
+  __atomic_store_n(p->pSqTail, iTail+1, __ATOMIC_RELEASE);
+
+  p->nQueued++;
+  p->nSubmit++;
+  OSTRACE(("QUEUE   %-3d %5d %7lld\n", pFile->h, nByte, offset));
+  return SQLITE_OK;
+}
+
+/*
+** The xRead, xWrite, xWriteV, xTruncate, xSync, xFileSize, xUnlock, 
+** xClose and xFileControl methods of the "unix-uring" VFS.
+*/
+static int uringRead(sqlite3_file *id, void *pBuf, int amt, i64 offset){
+  unixFile *pFile = (unixFile*)id;
+  if( uringOverlap(pFile, offset, amt) ){
+    int rc = uringFlush(pFile);
+    if( rc!=SQLITE_OK ) return rc;
+  }
+  return unixRead(id, pBuf, amt, offset);
+}
+static int uringWriteV(
+  sqlite3_file *id, 
+  int nBuf, 
+  const void **apBuf, 
+  int amt, 
+  i64 offset
+){
+  unixFile *pFile = (unixFile*)id;
+  int rc = SQLITE_OK;
+  if( pFile->bBatch==0 || pFile->pUring==0 ){
+    return unixWriteV(id, nBuf, apBuf, amt, offset);
+  }
+  if( pFile->pUring->nQueued>=SQLITE_URING_QUEUE_DEPTH 
+   || uringOverlap(pFile, offset, nBuf*amt)
+#ifndef NDEBUG
+   || (pFile->inNormalWrite && offset<=24)
+#endif
+  ){
+    rc = uringFlush(pFile);
+    if( rc!=SQLITE_OK ) return rc;
+  }
+#ifndef NDEBUG
+  if( pFile->inNormalWrite && offset<=24 ){
+    /* Let unixWrite() check the transaction counter */
+    return unixWriteV(id, nBuf, apBuf, amt, offset);
+  }
+#endif
+  if( pFile->pUring==0 ){
+    return unixWriteV(id, nBuf, apBuf, amt, offset);
+  }
+  SimulateIOError( return SQLITE_IOERR_WRITE );
+  SimulateDiskfullError( return SQLITE_FULL );
+  return uringQueueWrite(pFile, nBuf, apBuf, amt, offset);
+}
+static int uringWrite(sqlite3_file *id, const void *pBuf, int amt, i64 offset){
+  return uringWriteV(id, 1, &pBuf, amt, offset);
+}
+static int uringTruncate(sqlite3_file *id, i64 nByte){
+  int rc = uringFlush((unixFile*)id);
+  if( rc==SQLITE_OK ) rc = unixTruncate(id, nByte);
+  return rc;
+}
+static int uringSync(sqlite3_file *id, int flags){
+  int rc = uringFlush((unixFile*)id);
+  if( rc==SQLITE_OK ) rc = unixSync(id, flags);
+  return rc;
+}
+static int uringFileSize(sqlite3_file *id, i64 *pSize){
+  int rc = uringFlush((unixFile*)id);
+  if( rc==SQLITE_OK ) rc = unixFileSize(id, pSize);
+  return rc;
+}
+static int uringUnlock(sqlite3_file *id, int eFileLock){
+  unixFile *pFile = (unixFile*)id;
+  int rc = uringFlush(pFile);
+  int rc2 = unixUnlock(id, eFileLock);
+  pFile->bBatch = 0;
+  return rc==SQLITE_OK ? rc2 : rc;
+}
+static int uringClose(sqlite3_file *id){
+  unixFile *pFile = (unixFile*)id;
+  uringFlush(pFile);
+  uringQueueClose(pFile);
+  return unixClose(id);
+}
+static int uringFileControl(sqlite3_file *id, int op, void *pArg){
+  unixFile *pFile = (unixFile*)id;
+  switch( op ){
+    case SQLITE_FCNTL_BEGIN_BATCH: {
+      /* The queue copies writes into buffers that are not aligned as
+      ** O_DIRECT requires, so writes to such files are not batched. */
+      if( pFile->szDirect || uringQueueOpen(pFile)!=SQLITE_OK ){
+        return SQLITE_NOTFOUND;
+      }
+      pFile->bBatch = 1;
+      return SQLITE_OK;
+    }
+    case SQLITE_FCNTL_END_BATCH: {
+      pFile->bBatch = 0;
+      return uringFlush(pFile);
+    }
+  }
+  return unixFileControl(id, op, pArg);
+}
+#endif /* UNIX_URING */
+
 /*
 ** Here ends the implementation of all sqlite3_file methods.
 **
@@ -4281,7 +5074,8 @@ static const sqlite3_io_methods METHOD = {                                   \
    unixShmMap,                 /* xShmMap */                                 \
    unixShmLock,                /* xShmLock */                                \
    unixShmBarrier,             /* xShmBarrier */                             \
-   unixShmUnmap                /* xShmUnmap */                               \
+   unixShmUnmap,               /* xShmUnmap */                               \
+   unixWriteV                  /* xWriteV */                                 \
 };                                                                           \
 static const sqlite3_io_methods *FINDER##Impl(const char *z, unixFile *p){   \
   UNUSED_PARAMETER(z); UNUSED_PARAMETER(p);                                  \
@@ -4298,7 +5092,7 @@ static const sqlite3_io_methods *(*const FINDER)(const char*,unixFile *p)    \
 IOMETHODS(
   posixIoFinder,            /* Finder function name */
   posixIoMethods,           /* sqlite3_io_methods object name */
-  2,                        /* shared memory is enabled */
+  3,                        /* shared memory and xWriteV are enabled */
   unixClose,                /* xClose method */
   unixLock,                 /* xLock method */
   unixUnlock,               /* xUnlock method */
@@ -4397,6 +5191,39 @@ IOMETHODS(
 )
 #endif
 
+#if UNIX_URING
+/*
+** The methods used by the "unix-uring" VFS. POSIX advisory locks and
+** shared memory, with batched writes submitted through an io_uring.
+*/
+static const sqlite3_io_methods uringIoMethods = {
+   3,                          /* iVersion */
+   uringClose,                 /* xClose */
+   uringRead,                  /* xRead */
+   uringWrite,                 /* xWrite */
+   uringTruncate,              /* xTruncate */
+   uringSync,                  /* xSync */
+   uringFileSize,              /* xFileSize */
+   unixLock,                   /* xLock */
+   uringUnlock,                /* xUnlock */
+   unixCheckReservedLock,      /* xCheckReservedLock */
+   uringFileControl,           /* xFileControl */
+   unixSectorSize,             /* xSectorSize */
+   unixDeviceCharacteristics,  /* xDeviceCapabilities */
+   unixShmMap,                 /* xShmMap */
+   unixShmLock,                /* xShmLock */
+   unixShmBarrier,             /* xShmBarrier */
+   unixShmUnmap,               /* xShmUnmap */
+   uringWriteV                 /* xWriteV */
+};
+static const sqlite3_io_methods *uringIoFinderImpl(const char *z, unixFile *p){
+  UNUSED_PARAMETER(z); UNUSED_PARAMETER(p);
+  return &uringIoMethods;
+}
+static const sqlite3_io_methods *(*const uringIoFinder)(const char*,unixFile*)
+    = uringIoFinderImpl;
+#endif /* UNIX_URING */
+
 #if defined(__APPLE__) && SQLITE_ENABLE_LOCKING_STYLE
 /* 
 ** This "finder" function attempts to determine the best locking strategy 
@@ -4585,6 +5412,9 @@ static int fillInUnixFile(
   }
 
   if( pLockingStyle == &posixIoMethods
+#if UNIX_URING
+    || pLockingStyle == &uringIoMethods
+#endif
 #if defined(__APPLE__) && SQLITE_ENABLE_LOCKING_STYLE
     || pLockingStyle == &nfsIoMethods
 #endif
@@ -4939,6 +5769,7 @@ static int unixOpen(
   int eType = flags&0xFFFFFF00;  /* Type of file to open */
   int noLock;                    /* True to omit locking primitives */
   int rc = SQLITE_OK;            /* Function Return Code */
+  int bReused = 0;               /* True if fd is reused from pUnused */
 
   int isExclusive  = (flags & SQLITE_OPEN_EXCLUSIVE);
   int isDelete     = (flags & SQLITE_OPEN_DELETEONCLOSE);
@@ -5001,6 +5832,7 @@ static int unixOpen(
     pUnused = findReusableFd(zName, flags);
     if( pUnused ){
       fd = pUnused->fd;
+      bReused = 1;
     }else{
       pUnused = sqlite3_malloc(sizeof(*pUnused));
       if( !pUnused ){
@@ -5142,6 +5974,11 @@ static int unixOpen(
   
   rc = fillInUnixFile(pVfs, fd, syncDir, pFile, zPath, noLock,
                       isDelete, isReadonly);
+#if UNIX_DIRECT_IO
+  if( rc==SQLITE_OK && eType==SQLITE_OPEN_MAIN_DB ){
+    unixDirectIoEnable(p, zPath, bReused);
+  }
+#endif
 open_finished:
   if( rc!=SQLITE_OK ){
     sqlite3_free(p->pUnused);
@@ -6728,6 +7565,9 @@ int sqlite3_os_init(void){
     UNIXVFS("unix-none",     nolockIoFinder ),
     UNIXVFS("unix-dotfile",  dotlockIoFinder ),
     UNIXVFS("unix-excl",     posixIoFinder ),
+#if UNIX_URING
+    UNIXVFS("unix-uring",    uringIoFinder ),
+#endif
 #if OS_VXWORKS
     UNIXVFS("unix-namedsem", semIoFinder ),
 #endif
@@ -6747,7 +7587,7 @@ int sqlite3_os_init(void){
 
   /* Double-check that the aSyscall[] array has been constructed
   ** correctly.  See ticket [bb3a86e890c8e96ab] */
-  assert( ArraySize(aSyscall)==18 );
+  assert( ArraySize(aSyscall)==21 );
 
   /* Register all VFSes defined in the aVfs[] array */
   for(i=0; i<(sizeof(aVfs)/sizeof(sqlite3_vfs)); i++){
@@ -537,6 +537,22 @@ struct PagerSavepoint {
 **   the database page-size in order to prevent a journal sync from happening 
 **   in between the journalling of two pages on the same sector. 
 **
+** bConcurrent, pAllRead
+**
+**   bConcurrent is set when a BEGIN CONCURRENT transaction is opened on a
+**   WAL database. Such a transaction does not take the WAL write lock 
+**   until it is ready to commit, and so must not write to the log before 
+**   then. pagerStress() does not spill the cache while it is set.
+**
+**   pAllRead records the page number of each page read by the 
+**   transaction. When it commits, sqlite3WalLockForCommit() uses it to 
+**   check that none of those pages has been modified by another 
+**   connection. If memory cannot be allocated to record a page number,
+**   pAllRead is freed and set to NULL. The transaction may then only 
+**   commit if no other connection has written to the log.
+**
+**   Both are cleared when the transaction ends.
+**
 ** subjInMemory
 **
 **   This is a boolean variable. If true, then any required sub-journal
@@ -620,6 +636,7 @@ struct Pager {
   u8 tempFile;                /* zFilename is a temporary file */
   u8 readOnly;                /* True for a read-only database */
   u8 memDb;                   /* True to inhibit all file I/O */
+  u8 noPrefetch;              /* VFS does not support FCNTL_PREFETCH */
 
   /**************************************************************************
   ** The following block contains those class members that change during
@@ -637,6 +654,7 @@ struct Pager {
   u8 doNotSpill;              /* Do not spill the cache when non-zero */
   u8 doNotSyncSpill;          /* Do not do a spill that requires jrnl sync */
   u8 subjInMemory;            /* True to use in-memory sub-journals */
+  u8 bConcurrent;             /* True for a BEGIN CONCURRENT transaction */
   Pgno dbSize;                /* Number of pages in the database */
   Pgno dbOrigSize;            /* dbSize before the current transaction */
   Pgno dbFileSize;            /* Number of pages in the database file */
@@ -646,6 +664,7 @@ struct Pager {
   u32 cksumInit;              /* Quasi-random value added to every checksum */
   u32 nSubRec;                /* Number of records written to sub-journal */
   Bitvec *pInJournal;         /* One bit for each page in the database file */
+  Bitvec *pAllRead;           /* Pages read by a BEGIN CONCURRENT txn */
   sqlite3_file *fd;           /* File descriptor for database */
   sqlite3_file *jfd;          /* File descriptor for main journal */
   sqlite3_file *sjfd;         /* File descriptor for sub-journal */
@@ -686,6 +705,8 @@ struct Pager {
 #ifndef SQLITE_OMIT_WAL
   Wal *pWal;                  /* Write-ahead log used by "journal_mode=wal" */
   char *zWal;                 /* File name for write-ahead log */
+  int szWalChunk;             /* Chunk size for the write-ahead log */
+  sqlite3_snapshot *pSnapshot;  /* Open next read transaction on this */
 #endif
 };
 
@@ -698,6 +719,8 @@ struct Pager {
 int sqlite3_pager_readdb_count = 0;    /* Number of full pages read from DB */
 int sqlite3_pager_writedb_count = 0;   /* Number of full pages written to DB */
 int sqlite3_pager_writej_count = 0;    /* Number of pages written to journal */
+int sqlite3_pager_writev_count = 0;    /* Number of sqlite3OsWriteV() calls */
+int sqlite3_pager_prefetch_count = 0;  /* Pages passed to FCNTL_PREFETCH */
 # define PAGER_INCR(v)  v++
 #else
 # define PAGER_INCR(v)
@@ -787,6 +810,7 @@ static int pagerUseWal(Pager *pPager){
 # define pagerUseWal(x) 0
 # define pagerRollbackWal(x) 0
 # define pagerWalFrames(v,w,x,y,z) 0
+# define pagerLockForCommit(z) SQLITE_OK
 # define pagerOpenWalIfPresent(z) SQLITE_OK
 # define pagerBeginReadTransaction(z) SQLITE_OK
 #endif
@@ -1705,6 +1729,16 @@ static int addToSavepointBitvecs(Pager *pPager, Pgno pgno){
   return rc;
 }
 
+/*
+** End the BEGIN CONCURRENT transaction, if any, open on pager pPager.
+** Free the set of pages read by the transaction.
+*/
+static void pagerEndConcurrent(Pager *pPager){
+  sqlite3BitvecDestroy(pPager->pAllRead);
+  pPager->pAllRead = 0;
+  pPager->bConcurrent = 0;
+}
+
 /*
 ** This function is a no-op if the pager is in exclusive mode and not
 ** in the ERROR state. Otherwise, it switches the pager to PAGER_OPEN
@@ -1732,6 +1766,7 @@ static void pager_unlock(Pager *pPager){
   sqlite3BitvecDestroy(pPager->pInJournal);
   pPager->pInJournal = 0;
   releaseAllSavepoints(pPager);
+  pagerEndConcurrent(pPager);
 
   if( pagerUseWal(pPager) ){
     assert( !isOpen(pPager->jfd) );
@@ -1957,6 +1992,7 @@ static int pager_end_transaction(Pager *pPager, int hasMaster){
   sqlite3BitvecDestroy(pPager->pInJournal);
   pPager->pInJournal = 0;
   pPager->nRec = 0;
+  pagerEndConcurrent(pPager);
   sqlite3PcacheCleanAll(pPager->pPCache);
   sqlite3PcacheTruncate(pPager->pPCache, pPager->dbSize);
 
@@ -2943,6 +2979,26 @@ static int pagerRollbackWal(Pager *pPager){
   return rc;
 }
 
+/*
+** This function is called when a BEGIN CONCURRENT transaction on a WAL
+** database is about to be committed. It obtains the WAL write lock,
+** invoking the busy-handler while another connection holds it, and 
+** checks that none of the pages read by the transaction have been
+** modified since it began. If they have, SQLITE_BUSY_SNAPSHOT is
+** returned. Stale copies of pages modified by other connections are
+** discarded from the cache.
+*/
+static int pagerLockForCommit(Pager *pPager){
+  int rc;
+  if( pPager->bConcurrent==0 ) return SQLITE_OK;
+  do {
+    rc = sqlite3WalLockForCommit(
+        pPager->pWal, pPager->pAllRead, pagerUndoCallback, (void *)pPager
+    );
+  }while( rc==SQLITE_BUSY && pPager->xBusyHandler(pPager->pBusyHandlerArg) );
+  return rc;
+}
+
 /*
 ** This function is a wrapper around sqlite3WalFrames(). As well as logging
 ** the contents of the list of pages headed by pList (connected by pDirty),
@@ -3028,7 +3084,9 @@ static int pagerBeginReadTransaction(Pager *pPager){
   */
   sqlite3WalEndReadTransaction(pPager->pWal);
 
+  sqlite3WalSnapshotOpen(pPager->pWal, pPager->pSnapshot);
   rc = sqlite3WalBeginReadTransaction(pPager->pWal, &changed);
+  sqlite3WalSnapshotOpen(pPager->pWal, 0);
   if( rc!=SQLITE_OK || changed ){
     pager_reset(pPager);
   }
@@ -3950,6 +4008,67 @@ static int syncJournal(Pager *pPager, int newHdr){
   return SQLITE_OK;
 }
 
+/*
+** The maximum number of pages written to the database file by a single
+** call to sqlite3OsWriteV().
+*/
+#ifndef PAGER_MAX_WRITEV
+# define PAGER_MAX_WRITEV 64
+#endif
+
+/*
+** Write the nPg pages in apPg[] to the database file. The pages must have
+** consecutive page numbers, in ascending order. aData[i] is the data to
+** write for page apPg[i]. This is the same as apPg[i]->pData unless 
+** there is a codec.
+**
+** The pages are written using a single call to sqlite3OsWriteV(). After
+** this, Pager.dbFileVers, Pager.dbFileSize and any backups are updated 
+** to account for the pages written.
+*/
+static int pager_write_run(
+  Pager *pPager,                  /* Pager object */
+  PgHdr **apPg,                   /* Pages to write */
+  const void **aData,             /* Data to write for each page */
+  int nPg                         /* Number of entries in apPg[] and aData[] */
+){
+  i64 offset = (apPg[0]->pgno-1)*(i64)pPager->pageSize;  /* Offset to write */
+  int rc;                         /* Return code */
+  int i;                          /* Iterator variable */
+
+  assert( nPg>0 && nPg<=PAGER_MAX_WRITEV );
+  rc = sqlite3OsWriteV(pPager->fd, nPg, aData, pPager->pageSize, offset);
+  PAGER_INCR(sqlite3_pager_writev_count);
+
+  for(i=0; i<nPg; i++){
+    PgHdr *pPg = apPg[i];
+    Pgno pgno = pPg->pgno;
+    assert( i==0 || pgno==apPg[i-1]->pgno+1 );
+
+    /* If page 1 was just written, update Pager.dbFileVers to match
+    ** the value now stored in the database file. If writing this 
+    ** page caused the database file to grow, update dbFileSize. 
+    */
+    if( pgno==1 ){
+      memcpy(&pPager->dbFileVers, &((u8*)aData[i])[24], 
+             sizeof(pPager->dbFileVers));
+    }
+    if( pgno>pPager->dbFileSize ){
+      pPager->dbFileSize = pgno;
+    }
+
+    /* Update any backup objects copying the contents of this pager. */
+    sqlite3BackupUpdate(pPager->pBackup, pgno, (u8*)pPg->pData);
+
+    PAGERTRACE(("STORE %d page %d hash(%08x)\n",
+                 PAGERID(pPager), pgno, pager_pagehash(pPg)));
+    IOTRACE(("PGOUT %p %d\n", pPager, pgno));
+    PAGER_INCR(sqlite3_pager_writedb_count);
+    PAGER_INCR(pPager->nWrite);
+  }
+  return rc;
+}
+
 /*
 ** The argument is the first in a linked list of dirty pages connected
 ** by the PgHdr.pDirty pointer. This function writes each one of the
@@ -3967,8 +4086,10 @@ static int syncJournal(Pager *pPager, int newHdr){
 ** written out.
 **
 ** Once the lock has been upgraded and, if necessary, the file opened,
-** the pages are written out to the database file in list order. Writing
-** a page is skipped if it meets either of the following criteria:
+** the pages are written out to the database file in list order. Runs
+** of pages with consecutive page numbers are written using a single
+** call to sqlite3OsWriteV() (see pager_write_run()). Writing a page is
+** skipped if it meets either of the following criteria:
 **
 **   * The page number is greater than Pager.dbSize, or
 **   * The PGHDR_DONT_WRITE flag is set on the page.
@@ -3984,6 +4105,10 @@ static int syncJournal(Pager *pPager, int newHdr){
 */
 static int pager_write_pagelist(Pager *pPager, PgHdr *pList){
   int rc = SQLITE_OK;                  /* Return code */
+  int bBatch = 0;                      /* True if writes are batched */
+  PgHdr *apRun[PAGER_MAX_WRITEV];      /* Run of pages not yet written */
+  const void *aData[PAGER_MAX_WRITEV]; /* Data to write for apRun[] pages */
+  int nRun = 0;                        /* Number of pages in apRun[] */
 
   /* This function is only called for rollback pagers in WRITER_DBMOD state. */
   assert( !pagerUseWal(pPager) );
@@ -4009,6 +4134,14 @@ static int pager_write_pagelist(Pager *pPager, PgHdr *pList){
     pPager->dbHintSize = pPager->dbSize;
   }
 
+  /* If there is more than one page to write, allow the VFS to batch the
+  ** writes (see SQLITE_FCNTL_BEGIN_BATCH). 
+  */
+  if( rc==SQLITE_OK && pList && pList->pDirty ){
+    bBatch = SQLITE_OK==
+        sqlite3OsFileControl(pPager->fd, SQLITE_FCNTL_BEGIN_BATCH, 0);
+  }
+
   while( rc==SQLITE_OK && pList ){
     Pgno pgno = pList->pgno;
 
@@ -4021,44 +4154,51 @@ static int pager_write_pagelist(Pager *pPager, PgHdr *pList){
     ** set (set by sqlite3PagerDontWrite()).
     */
     if( pgno<=pPager->dbSize && 0==(pList->flags&PGHDR_DONT_WRITE) ){
-      i64 offset = (pgno-1)*(i64)pPager->pageSize;   /* Offset to write */
       char *pData;                                   /* Data to write */    
 
       assert( (pList->flags&PGHDR_NEED_SYNC)==0 );
       if( pList->pgno==1 ) pager_write_changecounter(pList);
 
-      /* Encode the database */
-      CODEC2(pPager, pList->pData, pgno, 6, return SQLITE_NOMEM, pData);
-
-      /* Write out the page data. */
-      rc = sqlite3OsWrite(pPager->fd, pData, pPager->pageSize, offset);
-
-      /* If page 1 was just written, update Pager.dbFileVers to match
-      ** the value now stored in the database file. If writing this 
-      ** page caused the database file to grow, update dbFileSize. 
-      */
-      if( pgno==1 ){
-        memcpy(&pPager->dbFileVers, &pData[24], sizeof(pPager->dbFileVers));
-      }
-      if( pgno>pPager->dbFileSize ){
-        pPager->dbFileSize = pgno;
+      /* If this page does not directly follow the last page of the 
+      ** current run, or if the run is full, write the run out. */
+      if( nRun>0 
+       && (apRun[nRun-1]->pgno+1!=pgno || nRun==PAGER_MAX_WRITEV) 
+      ){
+        rc = pager_write_run(pPager, apRun, aData, nRun);
+        nRun = 0;
+        if( rc!=SQLITE_OK ) break;
       }
 
-      /* Update any backup objects copying the contents of this pager. */
-      sqlite3BackupUpdate(pPager->pBackup, pgno, (u8*)pList->pData);
+      /* Encode the database. On failure, fall through to the END_BATCH
+      ** file-control below. */
+      CODEC2(pPager, pList->pData, pgno, 6, rc=SQLITE_NOMEM, pData);
+      if( rc!=SQLITE_OK ) break;
 
-      PAGERTRACE(("STORE %d page %d hash(%08x)\n",
-                   PAGERID(pPager), pgno, pager_pagehash(pList)));
-      IOTRACE(("PGOUT %p %d\n", pPager, pgno));
-      PAGER_INCR(sqlite3_pager_writedb_count);
-      PAGER_INCR(pPager->nWrite);
+      /* Add the page to the run. If there is a codec, pData may be 
+      ** overwritten when the next page is encoded, so write it now. */
+      apRun[nRun] = pList;
+      aData[nRun] = pData;
+      nRun++;
+#ifdef SQLITE_HAS_CODEC
+      if( pPager->xCodec ){
+        rc = pager_write_run(pPager, apRun, aData, nRun);
+        nRun = 0;
+      }
+#endif
     }else{
       PAGERTRACE(("NOSTORE %d page %d\n", PAGERID(pPager), pgno));
     }
     pager_set_pagehash(pList);
     pList = pList->pDirty;
   }
+  if( rc==SQLITE_OK && nRun>0 ){
+    rc = pager_write_run(pPager, apRun, aData, nRun);
+  }
 
+  if( bBatch ){
+    int rc2 = sqlite3OsFileControl(pPager->fd, SQLITE_FCNTL_END_BATCH, 0);
+    if( rc==SQLITE_OK ) rc = rc2;
+  }
   return rc;
 }
 
@@ -4165,7 +4305,9 @@ static int pagerStress(void *p, PgHdr *pPg){
   ** pages belonging to the same sector.
   **
   ** The doNotSpill flag inhibits all cache spilling regardless of whether
-  ** or not a sync is required.  This is set during a rollback.
+  ** or not a sync is required.  This is set during a rollback. Spilling
+  ** is also inhibited during a BEGIN CONCURRENT transaction, which may
+  ** not write to the WAL until it commits.
   **
   ** Spilling is also prohibited when in an error state since that could
   ** lead to database corruption.   In the current implementaton it 
@@ -4175,7 +4317,7 @@ static int pagerStress(void *p, PgHdr *pPg){
   ** test for the error state as a safeguard against future changes.
   */
   if( NEVER(pPager->errCode) ) return SQLITE_OK;
-  if( pPager->doNotSpill ) return SQLITE_OK;
+  if( pPager->doNotSpill || pPager->bConcurrent ) return SQLITE_OK;
   if( pPager->doNotSyncSpill && (pPg->flags & PGHDR_NEED_SYNC)!=0 ){
     return SQLITE_OK;
   }
@@ -4302,6 +4444,7 @@ int sqlite3PagerOpen(
   u32 szPageDflt = SQLITE_DEFAULT_PAGE_SIZE;  /* Default page size */
   const char *zUri = 0;    /* URI args to copy */
   int nUri = 0;            /* Number of bytes of URI args at *zUri */
+  int szAlign = 0;         /* Required alignment of page buffers */
 
   /* Figure out how much space is required for each journal file-handle
   ** (there are two of them, the main journal and the sub-journal). This
@@ -4371,8 +4514,12 @@ int sqlite3PagerOpen(
   **     Database file handle            (pVfs->szOsFile bytes)
   **     Sub-journal file handle         (journalFileSize bytes)
   **     Main journal file handle        (journalFileSize bytes)
-  **     Database file name              (nPathname+1 bytes)
+  **     Database file name              (nPathname+1+nUri bytes)
   **     Journal file name               (nPathname+8+1 bytes)
+  **     WAL file name                   (nPathname+4+1+nUri bytes)
+  **
+  ** The URI parameters (if any) follow both the database and WAL file
+  ** names, so that the VFS may use sqlite3_uri_parameter() on either.
   */
   pPtr = (u8 *)sqlite3MallocZero(
     ROUND8(sizeof(*pPager)) +      /* Pager structure */
@@ -4382,7 +4529,7 @@ int sqlite3PagerOpen(
     nPathname + 1 + nUri +         /* zFilename */
     nPathname + 8 + 1              /* zJournal */
 #ifndef SQLITE_OMIT_WAL
-    + nPathname + 4 + 1              /* zWal */
+    + nPathname + 4 + 1 + nUri       /* zWal */
 #endif
   );
   assert( EIGHT_BYTE_ALIGNMENT(SQLITE_INT_TO_PTR(journalFileSize)) );
@@ -4412,6 +4559,9 @@ int sqlite3PagerOpen(
     memcpy(pPager->zWal, zPathname, nPathname);
     memcpy(&pPager->zWal[nPathname], "-wal", 4);
     sqlite3FileSuffix3(pPager->zFilename, pPager->zWal);
+    /* Copy the URI parameters after the suffix is shortened (if it is), so
+    ** that they immediately follow the nul-terminator of the WAL name. */
+    memcpy(&pPager->zWal[sqlite3Strlen30(pPager->zWal)+1], zUri, nUri);
 #endif
     sqlite3_free(zPathname);
   }
@@ -4426,6 +4576,19 @@ int sqlite3PagerOpen(
     assert( !memDb );
     readOnly = (fout&SQLITE_OPEN_READONLY);
 
+    /* If the VFS wants page buffers aligned in memory (for example because
+    ** the file was opened with O_DIRECT), find out the alignment so that
+    ** the page cache can be configured to match. */
+    if( rc==SQLITE_OK ){
+      int rc2 = sqlite3OsFileControl(pPager->fd, SQLITE_FCNTL_BUFFER_ALIGN,
+                                     (void *)&szAlign);
+      if( rc2!=SQLITE_OK || szAlign<0 || szAlign>65536
+       || (szAlign&(szAlign-1))!=0
+      ){
+        szAlign = 0;
+      }
+    }
+
     /* If the file was successfully opened for read/write access,
     ** choose a default page size in case we have to create the
     ** database file. The default page size is the maximum of:
@@ -4498,6 +4661,7 @@ int sqlite3PagerOpen(
   nExtra = ROUND8(nExtra);
   sqlite3PcacheOpen(szPageDflt, nExtra, !memDb,
                     !memDb?pagerStress:0, (void *)pPager, pPager->pPCache);
+  sqlite3PcacheSetAlign(pPager->pPCache, szAlign);
 
   PAGERTRACE(("OPEN %d %s\n", FILEHANDLEID(pPager->fd), pPager->zFilename));
   IOTRACE(("OPEN %p %s\n", pPager, pPager->zFilename))
@@ -4887,6 +5051,12 @@ int sqlite3PagerSharedLock(Pager *pPager){
     assert( rc==SQLITE_OK );
     rc = pagerBeginReadTransaction(pPager);
   }
+#ifndef SQLITE_OMIT_WAL
+  else if( pPager->pSnapshot && rc==SQLITE_OK ){
+    /* A snapshot may only be opened on a database in WAL mode. */
+    rc = SQLITE_ERROR;
+  }
+#endif
 
   if( pPager->eState==PAGER_OPEN && rc==SQLITE_OK ){
     rc = pagerPagecount(pPager, &pPager->dbSize);
@@ -4917,6 +5087,18 @@ static void pagerUnlockIfUnused(Pager *pPager){
   }
 }
 
+/*
+** Add page pgno to the set of pages read by the current BEGIN CONCURRENT
+** transaction. If a malloc fails, discard the set (see the comments above
+** Pager.pAllRead).
+*/
+static void pagerRecordRead(Pager *pPager, Pgno pgno){
+  if( pgno<=PAGER_MAX_PGNO && sqlite3BitvecSet(pPager->pAllRead, pgno) ){
+    sqlite3BitvecDestroy(pPager->pAllRead);
+    pPager->pAllRead = 0;
+  }
+}
+
 /*
 ** Acquire a reference to page number pgno in pager pPager (a page
 ** reference has type DbPage*). If the requested reference is 
@@ -4982,6 +5164,9 @@ int sqlite3PagerAcquire(
   if( pgno==0 ){
     return SQLITE_CORRUPT_BKPT;
   }
+  if( pPager->pAllRead ){
+    pagerRecordRead(pPager, pgno);
+  }
 
   /* If the pager is in the error state, return an error immediately. 
   ** Otherwise, request the page from the PCache layer. */
@@ -5086,10 +5271,104 @@ DbPage *sqlite3PagerLookup(Pager *pPager, Pgno pgno){
   assert( pgno!=0 );
   assert( pPager->pPCache!=0 );
   assert( pPager->eState>=PAGER_READER && pPager->eState!=PAGER_ERROR );
+  if( pPager->pAllRead ){
+    pagerRecordRead(pPager, pgno);
+  }
   sqlite3PcacheFetch(pPager->pPCache, pgno, 0, &pPg);
   return pPg;
 }
 
+/*
+** Return true if page pgno may be read directly from the database file
+** into a buffer supplied by the caller, bypassing the page cache. This
+** is used by the b-tree layer to read large overflow chains without
+** copying them through, and evicting other pages from, the cache.
+**
+** A direct read is only allowed if the content of the database file is
+** known to be the same as that of the page: the pager must be holding a
+** read transaction (not a write transaction, so that there are no dirty 
+** pages that have not been written to disk), must not be using a WAL 
+** file (which might contain a newer version of the page) or a codec, and
+** the page must exist in the file. And a direct read is only worthwhile
+** if the page is not already in the cache.
+*/
+int sqlite3PagerDirectReadOk(Pager *pPager, Pgno pgno){
+  PgHdr *pPg = 0;
+  assert( pgno!=0 );
+  if( pPager->eState!=PAGER_READER
+   || pPager->fd->pMethods==0
+   || pagerUseWal(pPager)
+   || pgno>pPager->dbSize
+#ifdef SQLITE_HAS_CODEC
+   || pPager->xCodec!=0
+#endif
+  ){
+    return 0;
+  }
+  sqlite3PcacheFetch(pPager->pPCache, pgno, 0, &pPg);
+  if( pPg ){
+    sqlite3PcacheRelease(pPg);
+    return 0;
+  }
+  return 1;
+}
+
+/*
+** Tell the VFS that the pages in array aPgno[] are likely to be read
+** soon, so that it may start reading them from disk before they are
+** requested. Pages that are already in the cache are skipped, and runs 
+** of consecutive page numbers are passed to the VFS as a single range.
+** This is a hint only and it does not fail.
+**
+** If the VFS does not support the SQLITE_FCNTL_PREFETCH file-control, no
+** further hints are sent to it by this pager.
+*/
+void sqlite3PagerPrefetch(Pager *pPager, int nPgno, Pgno *aPgno){
+  Pgno iRun = 0;                  /* First page of current run */
+  int nRun = 0;                   /* Number of pages in current run */
+  int i;
+
+  if( pPager->noPrefetch || !isOpen(pPager->fd)
+   || pPager->eState<PAGER_READER || pPager->eState==PAGER_ERROR
+  ){
+    return;
+  }
+  for(i=0; i<=nPgno && pPager->noPrefetch==0; i++){
+    Pgno pgno = (i<nPgno ? aPgno[i] : 0);
+    if( pgno>pPager->dbSize ){
+      pgno = 0;
+    }else if( pgno ){
+      PgHdr *pPg = 0;
+      sqlite3PcacheFetch(pPager->pPCache, pgno, 0, &pPg);
+      if( pPg ){
+        sqlite3PcacheRelease(pPg);
+        pgno = 0;
+      }
+    }
+    if( nRun>0 && pgno==iRun+nRun ){
+      nRun++;
+      continue;
+    }
+    if( nRun>0 ){
+      i64 aRange[2];
+      int rc;
+      aRange[0] = (i64)(iRun-1) * pPager->pageSize;
+      aRange[1] = (i64)nRun * pPager->pageSize;
+      rc = sqlite3OsFileControl(pPager->fd, SQLITE_FCNTL_PREFETCH, aRange);
+      if( rc==SQLITE_NOTFOUND ){
+        pPager->noPrefetch = 1;
+      }
+#ifdef SQLITE_TEST
+      else{
+        sqlite3_pager_prefetch_count += nRun;
+      }
+#endif
+    }
+    iRun = pgno;
+    nRun = (pgno ? 1 : 0);
+  }
+}
+
 /*
 ** Release a page reference.
 **
@@ -5237,8 +5516,13 @@ int sqlite3PagerBegin(Pager *pPager, int exFlag, int subjInMemory){
       ** PAGER_RESERVED state. Otherwise, return an error code to the caller.
       ** The busy-handler is not invoked if another connection already
       ** holds the write-lock. If possible, the upper layer will call it.
+      **
+      ** A BEGIN CONCURRENT transaction does not take the write lock until
+      ** it is ready to commit (see pagerLockForCommit()).
       */
-      rc = sqlite3WalBeginWriteTransaction(pPager->pWal);
+      if( pPager->bConcurrent==0 ){
+        rc = sqlite3WalBeginWriteTransaction(pPager->pWal);
+      }
     }else{
       /* Obtain a RESERVED lock on the database file. If the exFlag parameter
       ** is true, then immediately upgrade this to an EXCLUSIVE lock. The
@@ -5277,6 +5561,62 @@ int sqlite3PagerBegin(Pager *pPager, int exFlag, int subjInMemory){
   return rc;
 }
 
+/*
+** This function is called by the b-tree layer each time it opens a new
+** read snapshot, before any page other than page 1 has been read from it.
+** Parameter bConcurrent is true if the connection is in a BEGIN 
+** CONCURRENT transaction.
+**
+** If bConcurrent is true and the pager has a read transaction open on 
+** a WAL database (not in locking_mode=EXCLUSIVE), then start recording 
+** the pages read, and make the next call to sqlite3PagerBegin() defer 
+** taking the write lock until commit. If bConcurrent is false, cancel
+** any such earlier request.
+*/
+void sqlite3PagerSetConcurrent(Pager *pPager, int bConcurrent){
+  if( pPager->eState!=PAGER_READER ) return;
+  if( bConcurrent==0 ){
+    pagerEndConcurrent(pPager);
+  }else if( pPager->bConcurrent==0 
+         && pagerUseWal(pPager) && !pPager->exclusiveMode 
+  ){
+    pPager->bConcurrent = 1;
+    pPager->pAllRead = sqlite3BitvecCreate(PAGER_MAX_PGNO);
+
+    /* Page 1 was read when the read transaction was opened.  */
+    if( pPager->pAllRead ){
+      pagerRecordRead(pPager, 1);
+    }
+  }
+}
+
+/*
+** Obtain the WAL write lock for the BEGIN CONCURRENT transaction open on
+** pager pPager, and check that it does not conflict with transactions
+** committed by other connections (see pagerLockForCommit()). This is a
+** no-op if there is no such transaction or if the lock is already held.
+**
+** When a transaction writes to more than one database, this is called 
+** for each of them before any is committed. Otherwise a conflict found
+** in one database could be reported after the changes to another had
+** already been committed.
+*/
+int sqlite3PagerLockForCommit(Pager *pPager){
+  return pagerLockForCommit(pPager);
+}
+
+/*
+** Release the WAL write lock obtained by sqlite3PagerLockForCommit(), if
+** any. The BEGIN CONCURRENT transaction remains open. Its snapshot is the
+** one checked for conflicts when the lock was obtained, so a later call
+** to sqlite3PagerLockForCommit() only checks more recent transactions.
+*/
+void sqlite3PagerUnlockForCommit(Pager *pPager){
+  if( pPager->bConcurrent && pagerUseWal(pPager) ){
+    sqlite3WalEndWriteTransaction(pPager->pWal);
+  }
+}
+
 /*
 ** Mark a single data page as writeable. The page is written into the 
 ** main journal or sub-journal as required. If the page is written into
@@ -5555,6 +5895,18 @@ void sqlite3PagerDontWrite(PgHdr *pPg){
   }
 }
 
+/*
+** Provide a hint to the pager that page pPg is unlikely to be used again
+** soon. For example because it is an overflow page of a very large blob
+** that has just been read or written. The page is discarded from the 
+** page cache as soon as it is both clean and unreferenced, instead of 
+** displacing pages that are more likely to be reused.
+*/
+void sqlite3PagerReuseUnlikely(DbPage *pPg){
+  assert( pPg->pgno!=1 );
+  pPg->flags |= PGHDR_REUSE_UNLIKELY;
+}
+
 /*
 ** This routine is called to increment the value of the database file 
 ** change-counter, stored as a 4-byte big-endian integer starting at 
@@ -5749,6 +6101,10 @@ int sqlite3PagerCommitPhaseOne(
     if( pagerUseWal(pPager) ){
       PgHdr *pList = sqlite3PcacheDirtyList(pPager->pPCache);
       PgHdr *pPageOne = 0;
+      rc = pagerLockForCommit(pPager);
+      if( rc!=SQLITE_OK ){
+        return rc;
+      }
       if( pList==0 ){
         /* Must have at least one page for the WAL commit flag.
         ** Ticket [2d1a5c67dfc2363e44f29d9bbd57f] 2011-05-18 */
@@ -6625,6 +6981,18 @@ i64 sqlite3PagerJournalSizeLimit(Pager *pPager, i64 iLimit){
   return pPager->journalSizeLimit;
 }
 
+#ifndef SQLITE_OMIT_WAL
+/*
+** Set the chunk size used to allocate the write-ahead log file. This is
+** the chunk size configured for the database file with the
+** SQLITE_FCNTL_CHUNK_SIZE file-control.
+*/
+void sqlite3PagerWalChunkSize(Pager *pPager, int szChunk){
+  pPager->szWalChunk = szChunk;
+  sqlite3WalChunkSize(pPager->pWal, szChunk);
+}
+#endif
+
 /*
 ** Return a pointer to the pPager->pBackup variable. The backup module
 ** in backup.c maintains the content of this variable. This module
@@ -6715,6 +7083,9 @@ static int pagerOpenWal(Pager *pPager){
         pPager->fd, pPager->zWal, pPager->exclusiveMode,
         pPager->journalSizeLimit, &pPager->pWal
     );
+    if( rc==SQLITE_OK && pPager->szWalChunk ){
+      sqlite3WalChunkSize(pPager->pWal, pPager->szWalChunk);
+    }
   }
 
   return rc;
@@ -6811,6 +7182,30 @@ int sqlite3PagerCloseWal(Pager *pPager){
   return rc;
 }
 
+/*
+** If a read transaction is open on a WAL database, set *ppSnapshot to
+** point to a new snapshot object for it (see sqlite3_snapshot_get()). 
+** Otherwise, return SQLITE_ERROR.
+*/
+int sqlite3PagerSnapshotGet(Pager *pPager, sqlite3_snapshot **ppSnapshot){
+  int rc = SQLITE_ERROR;
+  *ppSnapshot = 0;
+  if( pagerUseWal(pPager) && pPager->eState>=PAGER_READER ){
+    rc = sqlite3WalSnapshotGet(pPager->pWal, ppSnapshot);
+  }
+  return rc;
+}
+
+/*
+** Arrange for the next read transaction to be opened on snapshot 
+** pSnapshot, or on the current state of the database if pSnapshot is 
+** NULL. If the database is not in WAL mode when the read transaction is
+** opened, sqlite3PagerSharedLock() fails with SQLITE_ERROR.
+*/
+void sqlite3PagerSnapshotOpen(Pager *pPager, sqlite3_snapshot *pSnapshot){
+  pPager->pSnapshot = pSnapshot;
+}
+
 #ifdef SQLITE_HAS_CODEC
 /*
 ** This function is called by the wal module when writing page content
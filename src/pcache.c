@@ -23,6 +23,7 @@ struct PCache {
   int nMax;                           /* Configured cache size */
   int szPage;                         /* Size of every page in this cache */
   int szExtra;                        /* Size of extra space for each page */
+  int szAlign;                        /* Alignment of PgHdr.pData, or 0 */
   int bPurgeable;                     /* True if pages are on backing store */
   int (*xStress)(void*,PgHdr*);       /* Call to try make a page clean */
   void *pStress;                      /* Argument to xStress */
@@ -124,14 +125,18 @@ static void pcacheAddToDirtyList(PgHdr *pPage){
 /*
 ** Wrapper around the pluggable caches xUnpin method. If the cache is
 ** being used for an in-memory database, this function is a no-op.
+**
+** If the PGHDR_REUSE_UNLIKELY flag is set on the page, the cache is 
+** told to discard it instead of adding it to its LRU list.
 */
 static void pcacheUnpin(PgHdr *p){
   PCache *pCache = p->pCache;
   if( pCache->bPurgeable ){
+    int reuseUnlikely = (p->flags&PGHDR_REUSE_UNLIKELY)!=0;
     if( p->pgno==1 ){
       pCache->pPage1 = 0;
     }
-    sqlite3GlobalConfig.pcache.xUnpin(pCache->pCache, p, 0);
+    sqlite3GlobalConfig.pcache.xUnpin(pCache->pCache, p, reuseUnlikely);
   }
 }
 
@@ -198,6 +203,36 @@ void sqlite3PcacheSetPageSize(PCache *pCache, int szPage){
   pCache->szPage = szPage;
 }
 
+/*
+** Arrange for the PgHdr.pData buffer of every page in the cache to be
+** allocated at an address that is a multiple of szAlign bytes, which must
+** be a power of two, or zero for the default alignment. Each page
+** allocation grows by szAlign bytes, within which the buffer is aligned.
+** The caller must ensure that there are no outstanding page references
+** when this function is called.
+*/
+void sqlite3PcacheSetAlign(PCache *pCache, int szAlign){
+  assert( szAlign>=0 && (szAlign&(szAlign-1))==0 );
+  if( szAlign<=8 ) szAlign = 0;
+  if( szAlign!=pCache->szAlign ){
+    sqlite3PcacheSetPageSize(pCache, pCache->szPage);
+    pCache->szAlign = szAlign;
+  }
+}
+
+/*
+** Return the first address at or after &pPage[1] that is suitably 
+** aligned for the PgHdr.pData buffer of pPage.
+*/
+static void *pcachePageData(PCache *pCache, PgHdr *pPage){
+  u8 *pData = (u8 *)&pPage[1];
+  if( pCache->szAlign ){
+    int szAlign = pCache->szAlign;
+    pData += (szAlign - (SQLITE_PTR_TO_INT(pData) & (szAlign-1))) & (szAlign-1);
+  }
+  return (void *)pData;
+}
+
 /*
 ** Try to obtain a page from the cache.
 */
@@ -220,7 +255,7 @@ int sqlite3PcacheFetch(
   if( !pCache->pCache && createFlag ){
     sqlite3_pcache *p;
     int nByte;
-    nByte = pCache->szPage + pCache->szExtra + sizeof(PgHdr);
+    nByte = pCache->szPage + pCache->szExtra + sizeof(PgHdr) + pCache->szAlign;
     p = sqlite3GlobalConfig.pcache.xCreate(nByte, pCache->bPurgeable);
     if( !p ){
       return SQLITE_NOMEM;
@@ -272,7 +307,7 @@ int sqlite3PcacheFetch(
   if( pPage ){
     if( !pPage->pData ){
       memset(pPage, 0, sizeof(PgHdr));
-      pPage->pData = (void *)&pPage[1];
+      pPage->pData = pcachePageData(pCache, pPage);
       pPage->pExtra = (void*)&((char *)pPage->pData)[pCache->szPage];
       memset(pPage->pExtra, 0, pCache->szExtra);
       pPage->pCache = pCache;
@@ -280,8 +315,8 @@ int sqlite3PcacheFetch(
     }
     assert( pPage->pCache==pCache );
     assert( pPage->pgno==pgno );
-    assert( pPage->pData==(void *)&pPage[1] );
-    assert( pPage->pExtra==(void *)&((char *)&pPage[1])[pCache->szPage] );
+    assert( pPage->pData==pcachePageData(pCache, pPage) );
+    assert( pPage->pExtra==(void *)&((char *)pPage->pData)[pCache->szPage] );
 
     if( 0==pPage->nRef ){
       pCache->nRef++;
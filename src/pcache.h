@@ -77,6 +77,9 @@ void sqlite3PcacheOpen(
 /* Modify the page-size after the cache has been created. */
 void sqlite3PcacheSetPageSize(PCache *, int);
 
+/* Set the memory alignment of page buffers (for O_DIRECT files). */
+void sqlite3PcacheSetAlign(PCache *, int);
+
 /* Return the size in bytes of a PCache object.  Used to preallocate
 ** storage space.
 */
@@ -1115,6 +1115,7 @@ void sqlite3Pragma(
       ** for all tables and indices in the database.
       */
       assert( sqlite3SchemaMutexHeld(db, iDb, 0) );
+      sqlite3LazyParseAll(db, i);
       pTbls = &db->aDb[i].pSchema->tblHash;
       for(x=sqliteHashFirst(pTbls); x; x=sqliteHashNext(x)){
         Table *pTab = sqliteHashData(x);
@@ -37,6 +37,282 @@ static void corruptSchema(
   pData->rc = db->mallocFailed ? SQLITE_NOMEM : SQLITE_CORRUPT_BKPT;
 }
 
+/*
+** Return true if the CREATE TABLE statement zSql contains the keyword
+** REFERENCES, and so might define a foreign key.
+*/
+static int lazyHasForeignKey(const char *zSql){
+  const unsigned char *z = (const unsigned char*)zSql;
+  int tokenType;
+  while( *z ){
+    z += sqlite3GetToken(z, &tokenType);
+    if( tokenType==TK_REFERENCES ) return 1;
+  }
+  return 0;
+}
+
+/*
+** Map the name of the object described by pRow to LazyTable p in the
+** Schema.lazyHash table, unless it is already mapped to p.
+*/
+static void lazyInsert(sqlite3 *db, Schema *pSchema, LazyRow *pRow,
+                       LazyTable *p){
+  int nName = sqlite3Strlen30(pRow->zName);
+  if( sqlite3HashFind(&pSchema->lazyHash, pRow->zName, nName)==0
+   && sqlite3HashInsert(&pSchema->lazyHash, pRow->zName, nName, p)==p
+  ){
+    db->mallocFailed = 1;
+  }
+}
+
+/*
+** Add LazyTable p to the Schema.pLazy list and add the names of its
+** objects to Schema.lazyHash.
+*/
+static void lazyLink(sqlite3 *db, Schema *pSchema, LazyTable *p){
+  LazyRow *pRow;
+  p->pPrev = 0;
+  p->pNext = pSchema->pLazy;
+  if( p->pNext ) p->pNext->pPrev = p;
+  pSchema->pLazy = p;
+  for(pRow=p->pRow; pRow; pRow=pRow->pNext){
+    lazyInsert(db, pSchema, pRow, p);
+  }
+}
+
+/*
+** Remove LazyTable p from the Schema.pLazy list and remove the names of
+** its objects from Schema.lazyHash.
+*/
+static void lazyUnlink(Schema *pSchema, LazyTable *p){
+  LazyRow *pRow;
+  for(pRow=p->pRow; pRow; pRow=pRow->pNext){
+    int nName = sqlite3Strlen30(pRow->zName);
+    if( sqlite3HashFind(&pSchema->lazyHash, pRow->zName, nName)==p ){
+      sqlite3HashInsert(&pSchema->lazyHash, pRow->zName, nName, 0);
+    }
+  }
+  if( p->pPrev ){
+    p->pPrev->pNext = p->pNext;
+  }else{
+    pSchema->pLazy = p->pNext;
+  }
+  if( p->pNext ) p->pNext->pPrev = p->pPrev;
+  p->pNext = p->pPrev = 0;
+}
+
+/*
+** Free LazyTable p and the rows attached to it. If db->pnBytesFreed is
+** set, the memory is only counted, not freed.
+*/
+void sqlite3LazyDelete(sqlite3 *db, LazyTable *p){
+  LazyRow *pRow;
+  LazyRow *pNext;
+  for(pRow=p->pRow; pRow; pRow=pNext){
+    pNext = pRow->pNext;
+    sqlite3DbFree(db, pRow);
+  }
+  for(pRow=p->pStat; pRow; pRow=pNext){
+    pNext = pRow->pNext;
+    sqlite3DbFree(db, pRow);
+  }
+  sqlite3DbFree(db, p);
+}
+
+/*
+** Parse the CREATE statements saved in LazyTable p, which belongs to
+** database iDb, and then free p.
+**
+** If an error occurs, any objects that were created are removed from
+** the schema again and p is put back, so that a table is never seen
+** without all of its indexes and triggers. An error other than
+** SQLITE_NOMEM means that the schema is corrupt. It is written to the
+** error log, and the table cannot be used.
+*/
+static int lazyParse(sqlite3 *db, int iDb, LazyTable *p){
+  Schema *pSchema = db->aDb[iDb].pSchema;
+  struct sqlite3InitInfo saveInit = db->init;
+  int commit_internal = !(db->flags&SQLITE_InternChanges);
+  char *zErrMsg = 0;
+  InitData initData;
+  LazyRow *pRow;
+  int nName = sqlite3Strlen30(p->zName);
+#ifndef SQLITE_OMIT_AUTHORIZATION
+  int (*xAuth)(void*,int,const char*,const char*,const char*,const char*);
+  xAuth = db->xAuth;
+  db->xAuth = 0;
+#endif
+
+  assert( iDb!=1 );
+  assert( sqlite3SchemaMutexHeld(db, iDb, 0) );
+  lazyUnlink(pSchema, p);
+  initData.db = db;
+  initData.iDb = iDb;
+  initData.rc = SQLITE_OK;
+  initData.pzErrMsg = &zErrMsg;
+  initData.bLazy = 0;
+  db->init.busy = 1;
+  for(pRow=p->pRow; pRow && initData.rc==SQLITE_OK; pRow=pRow->pNext){
+    char zRoot[20];
+    char *azArg[3];
+    sqlite3_snprintf(sizeof(zRoot), zRoot, "%d", pRow->iRoot);
+    azArg[0] = pRow->zName;
+    azArg[1] = zRoot;
+    azArg[2] = pRow->zSql;
+    sqlite3InitCallback(&initData, 3, azArg, 0);
+  }
+  db->init = saveInit;
+#ifndef SQLITE_OMIT_AUTHORIZATION
+  db->xAuth = xAuth;
+#endif
+
+  if( initData.rc==SQLITE_OK && !db->mallocFailed ){
+#ifndef SQLITE_OMIT_ANALYZE
+    Table *pTab = sqlite3HashFind(&pSchema->tblHash, p->zName, nName);
+    for(pRow=p->pStat; pTab && pRow; pRow=pRow->pNext){
+      Index *pIdx = 0;
+      if( pRow->zName ){
+        pIdx = sqlite3HashFind(&pSchema->idxHash, pRow->zName,
+                               sqlite3Strlen30(pRow->zName));
+      }
+      sqlite3DecodeStat1(pTab, pIdx, pRow->zSql);
+    }
+#endif
+    sqlite3LazyDelete(db, p);
+  }else{
+    for(pRow=p->pRow; pRow; pRow=pRow->pNext){
+      Trigger *pTrig = sqlite3HashFind(&pSchema->trigHash, pRow->zName,
+                                       sqlite3Strlen30(pRow->zName));
+      if( pTrig && pTrig->pTabSchema==pSchema
+       && sqlite3StrICmp(pTrig->table, p->zName)==0
+      ){
+        sqlite3UnlinkAndDeleteTrigger(db, iDb, pRow->zName);
+      }
+    }
+    if( sqlite3HashFind(&pSchema->tblHash, p->zName, nName) ){
+      sqlite3UnlinkAndDeleteTable(db, iDb, p->zName);
+    }
+    lazyLink(db, pSchema, p);
+    if( initData.rc==SQLITE_OK ) initData.rc = SQLITE_NOMEM;
+    if( initData.rc!=SQLITE_NOMEM ){
+      sqlite3_log(initData.rc, "%s", zErrMsg);
+    }
+  }
+  sqlite3DbFree(db, zErrMsg);
+  if( commit_internal ){
+    sqlite3CommitInternalChanges(db);
+  }
+  return initData.rc;
+}
+
+/*
+** If the object named zName in database iDb belongs to a table whose
+** CREATE statements have not been parsed yet, parse them now.
+*/
+void sqlite3LazyParse(sqlite3 *db, int iDb, const char *zName){
+  Schema *pSchema = db->aDb[iDb].pSchema;
+  if( pSchema->pLazy ){
+    LazyTable *p;
+    p = sqlite3HashFind(&pSchema->lazyHash, zName, sqlite3Strlen30(zName));
+    if( p ) lazyParse(db, iDb, p);
+  }
+}
+
+/*
+** Parse all unparsed tables in database iDb. This is done before the
+** tables of a database are iterated through, for example by ANALYZE or
+** PRAGMA integrity_check. Stop at the first error.
+*/
+void sqlite3LazyParseAll(sqlite3 *db, int iDb){
+  Schema *pSchema = db->aDb[iDb].pSchema;
+  while( pSchema->pLazy && lazyParse(db, iDb, pSchema->pLazy)==SQLITE_OK );
+}
+
+/*
+** This is called by sqlite3InitCallback() for each row of sqlite_master
+** while a schema is loaded with lazy parsing enabled. argv[3] is the
+** tbl_name column. If the row is for a table or view that can be parsed
+** later, or for an index or trigger attached to such a table, save it
+** and return 1. Otherwise, return 0 to have the row parsed now.
+*/
+static int lazyDefer(InitData *pData, char **argv){
+  sqlite3 *db = pData->db;
+  Schema *pSchema = db->aDb[pData->iDb].pSchema;
+  const char *zName = argv[0];
+  const char *zSql = argv[2];
+  const char *zTab = argv[3];
+  LazyTable *p;
+  LazyTable *pOther;
+  LazyRow *pRow;
+  int iRoot;
+  int nName;
+  int nSql;
+
+  if( zName==0 || zTab==0 || sqlite3GetInt32(argv[1], &iRoot)==0 ){
+    return 0;
+  }
+  p = sqlite3HashFind(&pSchema->lazyHash, zTab, sqlite3Strlen30(zTab));
+  if( p==0 || sqlite3StrICmp(p->zName, zTab) ){
+    /* Only a table or a view starts a new LazyTable. Tables that might
+    ** define foreign keys, and internal tables such as sqlite_sequence,
+    ** are always parsed now. */
+    if( zSql==0 || sqlite3StrICmp(zName, zTab)
+     || sqlite3StrNICmp(zName, "sqlite_", 7)==0
+     || (sqlite3StrNICmp(zSql, "CREATE TABLE ", 13)
+         && sqlite3StrNICmp(zSql, "CREATE VIEW ", 12))
+     || lazyHasForeignKey(zSql)
+    ){
+      return 0;
+    }
+    p = 0;
+  }
+
+  /* If an object of another unparsed table has the same name, parse both
+  ** tables and this row now, as Schema.lazyHash can only map the name to
+  ** one of them. */
+  nName = sqlite3Strlen30(zName);
+  pOther = sqlite3HashFind(&pSchema->lazyHash, zName, nName);
+  if( pOther && pOther!=p ){
+    lazyParse(db, pData->iDb, pOther);
+    if( p ) lazyParse(db, pData->iDb, p);
+    return 0;
+  }
+
+  nSql = zSql ? sqlite3Strlen30(zSql)+1 : 0;
+  pRow = (LazyRow*)sqlite3DbMallocRaw(0, sizeof(LazyRow) + nName+1 + nSql);
+  if( pRow==0 ){
+    db->mallocFailed = 1;
+    return 1;
+  }
+  pRow->zName = (char*)&pRow[1];
+  memcpy(pRow->zName, zName, nName+1);
+  if( zSql ){
+    pRow->zSql = &pRow->zName[nName+1];
+    memcpy(pRow->zSql, zSql, nSql);
+  }else{
+    pRow->zSql = 0;
+  }
+  pRow->iRoot = iRoot;
+  pRow->pNext = 0;
+
+  if( p ){
+    p->pLast->pNext = pRow;
+    p->pLast = pRow;
+    lazyInsert(db, pSchema, pRow, p);
+  }else{
+    p = (LazyTable*)sqlite3DbMallocZero(0, sizeof(LazyTable));
+    if( p==0 ){
+      sqlite3DbFree(0, pRow);
+      db->mallocFailed = 1;
+      return 1;
+    }
+    p->zName = pRow->zName;
+    p->pRow = p->pLast = pRow;
+    lazyLink(db, pSchema, p);
+  }
+  return 1;
+}
+
 /*
 ** This is the callback routine for the code that initializes the
 ** database.  See sqlite3Init() below for additional information.
@@ -47,6 +323,7 @@ static void corruptSchema(
 **     argv[0] = name of thing being created
 **     argv[1] = root page number for table or index. 0 for trigger or view.
 **     argv[2] = SQL text for the CREATE statement.
+**     argv[3] = name of the table the thing belongs to (lazy parsing only)
 **
 */
 int sqlite3InitCallback(void *pInit, int argc, char **argv, char **NotUsed){
@@ -54,7 +331,7 @@ int sqlite3InitCallback(void *pInit, int argc, char **argv, char **NotUsed){
   sqlite3 *db = pData->db;
   int iDb = pData->iDb;
 
-  assert( argc==3 );
+  assert( argc==3 || (argc==4 && pData->bLazy) );
   UNUSED_PARAMETER2(NotUsed, argc);
   assert( sqlite3_mutex_held(db->mutex) );
   DbClearProperty(db, iDb, DB_Empty);
@@ -67,6 +344,12 @@ int sqlite3InitCallback(void *pInit, int argc, char **argv, char **NotUsed){
   if( argv==0 ) return 0;   /* Might happen if EMPTY_RESULT_CALLBACKS are on */
   if( argv[1]==0 ){
     corruptSchema(pData, argv[0], 0);
+  }else if( pData->bLazy && lazyDefer(pData, argv) ){
+    /* The row is parsed when the table it belongs to is first used */
+    if( db->mallocFailed ){
+      corruptSchema(pData, argv[0], 0);
+      return 1;
+    }
   }else if( argv[2] && argv[2][0] ){
     /* Call the parser to process a CREATE TABLE, INDEX or VIEW.
     ** But because db->init.busy is set to 1, no VDBE code is generated
@@ -195,6 +478,7 @@ static int sqlite3InitOne(sqlite3 *db, int iDb, char **pzErrMsg){
   initData.iDb = iDb;
   initData.rc = SQLITE_OK;
   initData.pzErrMsg = pzErrMsg;
+  initData.bLazy = 0;
   sqlite3InitCallback(&initData, 3, (char **)azArg, 0);
   if( initData.rc ){
     rc = initData.rc;
@@ -314,16 +598,25 @@ static int sqlite3InitOne(sqlite3 *db, int iDb, char **pzErrMsg){
   assert( db->init.busy );
   {
     char *zSql;
+
+    /* With lazy parsing, the tbl_name column is also read so that the
+    ** rows for indexes and triggers can be saved along with the table
+    ** they belong to. Lazy parsing is not used for the TEMP database, as
+    ** the tables that its triggers belong to may be in other databases,
+    ** nor if the schema cache is in use, as it requires a full schema. */
+    initData.bLazy = sqlite3GlobalConfig.bLazySchema && iDb!=1
+                  && sqlite3GlobalConfig.nSchemaCache<=0
+                  && (db->flags & SQLITE_RecoveryMode)==0;
     zSql = sqlite3MPrintf(db, 
-        "SELECT name, rootpage, sql FROM '%q'.%s ORDER BY rowid",
-        db->aDb[iDb].zName, zMasterName);
+        "SELECT name, rootpage, sql%s FROM '%q'.%s ORDER BY rowid",
+        initData.bLazy ? ", tbl_name" : "", db->aDb[iDb].zName, zMasterName);
 #ifndef SQLITE_OMIT_AUTHORIZATION
     {
       int (*xAuth)(void*,int,const char*,const char*,const char*,const char*);
       xAuth = db->xAuth;
       db->xAuth = 0;
 #endif
-      rc = sqlite3_exec(db, zSql, sqlite3InitCallback, &initData, 0);
+      rc = sqlite3SchemaCacheLoad(&initData, zSql);
 #ifndef SQLITE_OMIT_AUTHORIZATION
       db->xAuth = xAuth;
     }
@@ -538,6 +831,7 @@ static int sqlite3Prepare(
     rc = SQLITE_NOMEM;
     goto end_prepare;
   }
+  sqlite3ArenaBegin(db, &pParse->sArena);
   pParse->pReprepare = pReprepare;
   assert( ppStmt && *ppStmt==0 );
   assert( !db->mallocFailed );
@@ -673,6 +967,7 @@ static int sqlite3Prepare(
 
 end_prepare:
 
+  if( pParse ) sqlite3ArenaEnd(db, &pParse->sArena);
   sqlite3StackFree(db, pParse);
   rc = sqlite3ApiExit(db, rc);
   assert( (rc&db->errMask)==rc );
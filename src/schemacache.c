@@ -0,0 +1,861 @@
+/*
+** 2026 October 19
+**
+** The author disclaims copyright to this source code.  In place of
+** a legal notice, here is a blessing:
+**
+**    May you do good and not evil.
+**    May you find forgiveness for yourself and forgive others.
+**    May you share freely, never taking more than you give.
+**
+*************************************************************************
+**
+** This file contains the process-wide cache of parsed database schemas
+** enabled by sqlite3_config(SQLITE_CONFIG_SCHEMACACHE, N).
+**
+** Loading a schema normally requires parsing the CREATE statement of
+** every table, index, view and trigger in the sqlite_master table. When
+** the cache is enabled, a copy of each schema parsed is stored as a
+** "template", along with an image of the sqlite_master rows it was built
+** from. The next time any connection in the process loads the schema of
+** the same database file, it reads the sqlite_master rows, which is cheap,
+** and if they match the image exactly makes a deep copy of the template
+** instead of parsing the SQL again.
+**
+** Schema objects are not shared between connections directly. The schema
+** of a connection is modified as it is used (column affinity strings and
+** foreign key action triggers are cached in it, and views have their
+** columns filled in), and those modifications would need to be serialized
+** across all connections using the schema. Copying a template is much
+** faster than parsing and leaves each connection with a private schema,
+** just as if it had been parsed.
+*/
+#include "sqliteInt.h"
+
+/*
+** The following variable counts the number of times a schema was loaded
+** by copying a template. It is used by the test scripts.
+*/
+#ifdef SQLITE_TEST
+int sqlite3_schemacache_hit_count = 0;
+#endif
+
+typedef struct SchemaTemplate SchemaTemplate;
+typedef struct SchemaImage SchemaImage;
+typedef struct SchemaCopy SchemaCopy;
+
+/*
+** Each cached schema is stored in an instance of the following structure.
+**
+** Expressions in the template may not point to collation sequences that
+** belong to the connection the template was created by. Instead, each
+** Expr.pColl points to one of the apColl[] objects, which are used only
+** to store a collation sequence name.
+*/
+struct SchemaTemplate {
+  char *zFilename;          /* Full path of the database file */
+  char *zDb;                /* Name of the database ("main", "aux" etc.) */
+  u8 enc;                   /* Text encoding of the database */
+  u8 file_format;           /* Schema format of the database */
+  int nImage;               /* Size of zImage[] in bytes */
+  char *zImage;             /* Image of sqlite_master, see SchemaImage */
+  Schema *pSchema;          /* The cached schema objects */
+  int nColl;                /* Number of entries in apColl[] */
+  CollSeq **apColl;         /* Collation sequence names used by pSchema */
+  SchemaTemplate *pNext;    /* Next template in the cache */
+};
+
+/*
+** The image of a sqlite_master table is the sequence of name, rootpage
+** and sql values read from it in rowid order. Each value is stored as a
+** single 'n' byte if it is NULL, or as a 't' byte followed by the text
+** and a nul-terminator. An instance of the following structure is used
+** to accumulate an image.
+*/
+struct SchemaImage {
+  sqlite3 *db;              /* Database connection */
+  char *z;                  /* Image accumulated so far */
+  int n;                    /* Bytes of z[] in use */
+  int nAlloc;               /* Bytes allocated at z[] */
+  int nRow;                 /* Number of rows in image */
+};
+
+/*
+** Context used while copying a schema, from a connection to a new template
+** or from a template to a connection.
+*/
+struct SchemaCopy {
+  sqlite3 *db;              /* Allocate memory using this connection */
+  Schema *pFrom;            /* Schema to copy */
+  Schema *pTo;              /* Schema to copy objects into */
+  SchemaTemplate *pTmpl;    /* Template being created, or NULL */
+  char *zDfltColl;          /* Name of the default collation sequence */
+  Table *pTabFrom;          /* Table whose CHECK expression is being copied */
+  Table *pTabTo;            /* The copy of pTabFrom */
+};
+
+/*
+** The cache itself. All fields are protected by the
+** SQLITE_RWMUTEX_STATIC_SCHEMA mutex.
+*/
+static SQLITE_WSD struct SchemaCacheGlobal {
+  int nTmpl;                /* Number of templates in the pTmpl list */
+  SchemaTemplate *pTmpl;    /* List of templates. Most recent first */
+} schemaCache = { 0, 0 };
+#define schemaCache GLOBAL(struct SchemaCacheGlobal, schemaCache)
+
+/*
+** Free a template and all the objects it contains.
+*/
+static void schemaTemplateFree(SchemaTemplate *p){
+  int i;
+  if( p->pSchema ){
+    sqlite3SchemaClear(p->pSchema);
+    sqlite3DbFree(0, p->pSchema);
+  }
+  for(i=0; i<p->nColl; i++){
+    sqlite3DbFree(0, p->apColl[i]);
+  }
+  sqlite3DbFree(0, p->apColl);
+  sqlite3DbFree(0, p->zImage);
+  sqlite3DbFree(0, p->zDb);
+  sqlite3DbFree(0, p->zFilename);
+  sqlite3DbFree(0, p);
+}
+
+/*
+** This is the sqlite3_exec() callback used to read an image of the
+** sqlite_master table.
+*/
+static int schemaImageCallback(void *pArg, int nCol, char **azVal, char **NotUsed){
+  SchemaImage *p = (SchemaImage*)pArg;
+  int i;
+  UNUSED_PARAMETER(NotUsed);
+  if( azVal==0 ) return 0;
+  for(i=0; i<nCol; i++){
+    int n = azVal[i] ? sqlite3Strlen30(azVal[i])+2 : 1;
+    if( p->n+n>p->nAlloc ){
+      int nNew = p->nAlloc*2 + n + 1024;
+      p->z = sqlite3DbReallocOrFree(p->db, p->z, nNew);
+      if( p->z==0 ) return 1;
+      p->nAlloc = nNew;
+    }
+    if( azVal[i] ){
+      p->z[p->n] = 't';
+      memcpy(&p->z[p->n+1], azVal[i], n-1);
+    }else{
+      p->z[p->n] = 'n';
+    }
+    p->n += n;
+  }
+  p->nRow++;
+  return 0;
+}
+
+/*
+** Read the next row from image z[] into azVal[0..2]. Return a pointer to
+** the byte following the row.
+*/
+static const char *schemaImageRow(const char *z, const char **azVal){
+  int i;
+  for(i=0; i<3; i++){
+    if( *(z++)=='n' ){
+      azVal[i] = 0;
+    }else{
+      azVal[i] = z;
+      z += sqlite3Strlen30(z) + 1;
+    }
+  }
+  return z;
+}
+
+/*
+** Return the collation sequence to use in place of pColl in the copy of
+** a schema.
+**
+** When creating a template, this is a collation sequence object owned by
+** the template that holds only the name. Otherwise, it is the collation
+** sequence of the same name from the connection, created if it does not
+** already exist, as it would have been had the schema been parsed.
+*/
+static CollSeq *schemaCopyColl(SchemaCopy *p, CollSeq *pColl){
+  sqlite3 *db = p->db;
+  SchemaTemplate *pTmpl = p->pTmpl;
+  CollSeq *pNew;
+  CollSeq **apNew;
+  int i, n;
+
+  if( pTmpl==0 ){
+    return sqlite3FindCollSeq(db, ENC(db), pColl->zName, 1);
+  }
+  for(i=0; i<pTmpl->nColl; i++){
+    if( strcmp(pTmpl->apColl[i]->zName, pColl->zName)==0 ){
+      return pTmpl->apColl[i];
+    }
+  }
+  apNew = sqlite3DbRealloc(db, pTmpl->apColl, (i+1)*sizeof(CollSeq*));
+  if( apNew==0 ) return 0;
+  pTmpl->apColl = apNew;
+  n = sqlite3Strlen30(pColl->zName) + 1;
+  pNew = (CollSeq*)sqlite3DbMallocZero(db, sizeof(CollSeq)+n);
+  if( pNew==0 ) return 0;
+  pNew->zName = (char*)&pNew[1];
+  memcpy(pNew->zName, pColl->zName, n);
+  pTmpl->apColl[pTmpl->nColl++] = pNew;
+  return pNew;
+}
+
+/*
+** The following routines fix up a newly duplicated expression, expression
+** list or SELECT statement, so that it refers to the collation sequences
+** and table of the copy of the schema instead of those of the original.
+** Duplicates are always made with flags==0, so every Expr is full size.
+*/
+static void schemaCopyFixSelect(SchemaCopy*, Select*);
+static void schemaCopyFixExpr(SchemaCopy *p, Expr *pExpr){
+  if( pExpr==0 ) return;
+  assert( !ExprHasAnyProperty(pExpr, EP_Reduced|EP_TokenOnly) );
+  if( pExpr->pColl ){
+    pExpr->pColl = schemaCopyColl(p, pExpr->pColl);
+  }
+  if( pExpr->pTab ){
+    assert( pExpr->pTab==p->pTabFrom );
+    pExpr->pTab = p->pTabTo;
+  }
+  schemaCopyFixExpr(p, pExpr->pLeft);
+  schemaCopyFixExpr(p, pExpr->pRight);
+  if( ExprHasProperty(pExpr, EP_xIsSelect) ){
+    schemaCopyFixSelect(p, pExpr->x.pSelect);
+  }else if( pExpr->x.pList ){
+    int i;
+    for(i=0; i<pExpr->x.pList->nExpr; i++){
+      schemaCopyFixExpr(p, pExpr->x.pList->a[i].pExpr);
+    }
+  }
+}
+static void schemaCopyFixList(SchemaCopy *p, ExprList *pList){
+  int i;
+  if( pList==0 ) return;
+  for(i=0; i<pList->nExpr; i++){
+    schemaCopyFixExpr(p, pList->a[i].pExpr);
+  }
+}
+static void schemaCopyFixSelect(SchemaCopy *p, Select *pSelect){
+  for(; pSelect; pSelect=pSelect->pPrior){
+    schemaCopyFixList(p, pSelect->pEList);
+    if( pSelect->pSrc ){
+      int i;
+      for(i=0; i<pSelect->pSrc->nSrc; i++){
+        schemaCopyFixSelect(p, pSelect->pSrc->a[i].pSelect);
+        schemaCopyFixExpr(p, pSelect->pSrc->a[i].pOn);
+      }
+    }
+    schemaCopyFixExpr(p, pSelect->pWhere);
+    schemaCopyFixList(p, pSelect->pGroupBy);
+    schemaCopyFixExpr(p, pSelect->pHaving);
+    schemaCopyFixList(p, pSelect->pOrderBy);
+    schemaCopyFixExpr(p, pSelect->pLimit);
+    schemaCopyFixExpr(p, pSelect->pOffset);
+  }
+}
+
+/*
+** Duplicate an expression, expression list or SELECT for a schema copy.
+*/
+static Expr *schemaCopyExpr(SchemaCopy *p, Expr *pExpr){
+  Expr *pNew = sqlite3ExprDup(p->db, pExpr, 0);
+  schemaCopyFixExpr(p, pNew);
+  return pNew;
+}
+static ExprList *schemaCopyList(SchemaCopy *p, ExprList *pList){
+  ExprList *pNew = sqlite3ExprListDup(p->db, pList, 0);
+  schemaCopyFixList(p, pNew);
+  return pNew;
+}
+static Select *schemaCopySelect(SchemaCopy *p, Select *pSelect){
+  Select *pNew = sqlite3SelectDup(p->db, pSelect, 0);
+  schemaCopyFixSelect(p, pNew);
+  return pNew;
+}
+
+/*
+** Some schema objects are stored in a single allocation, with the arrays
+** and strings they point to following the structure itself. Copy such
+** an object using a single allocation. The SCHEMA_RELOC() macro returns
+** the pointer within the copy corresponding to a pointer within the
+** original.
+*/
+static void *schemaCopyBlock(SchemaCopy *p, void *pOld){
+  int nByte = sqlite3DbMallocSize(0, pOld);
+  void *pNew = sqlite3DbMallocRaw(p->db, nByte);
+  if( pNew ) memcpy(pNew, pOld, nByte);
+  return pNew;
+}
+#define SCHEMA_RELOC(T, pNew, pOld, ptr) \
+  ((T)&((u8*)(pNew))[(u8*)(ptr) - (u8*)(pOld)])
+#define SCHEMA_IN_BLOCK(pOld, ptr) \
+  ((u8*)(ptr)>=(u8*)(pOld) && (u8*)(ptr)<(u8*)(pOld)+sqlite3DbMallocSize(0,pOld))
+
+/*
+** Make a copy of index pFrom, a member of pTabFrom->pIndex, for table
+** pTab, the copy of pTabFrom.
+*/
+static Index *schemaCopyIndex(
+  SchemaCopy *p,
+  Index *pFrom,
+  Table *pTabFrom,
+  Table *pTab
+){
+  Index *pIdx;
+  int i;
+
+  pIdx = (Index*)schemaCopyBlock(p, pFrom);
+  if( pIdx==0 ) return 0;
+  pIdx->zName = SCHEMA_RELOC(char*, pIdx, pFrom, pFrom->zName);
+  pIdx->aiColumn = SCHEMA_RELOC(int*, pIdx, pFrom, pFrom->aiColumn);
+  pIdx->aiRowEst = SCHEMA_RELOC(unsigned*, pIdx, pFrom, pFrom->aiRowEst);
+  pIdx->aSortOrder = SCHEMA_RELOC(u8*, pIdx, pFrom, pFrom->aSortOrder);
+  pIdx->azColl = SCHEMA_RELOC(char**, pIdx, pFrom, pFrom->azColl);
+  for(i=0; i<pIdx->nColumn; i++){
+    char *zColl = pFrom->azColl[i];
+    int iCol = pIdx->aiColumn[i];
+    if( SCHEMA_IN_BLOCK(pFrom, zColl) ){
+      /* A collation sequence specified as part of CREATE INDEX */
+      pIdx->azColl[i] = SCHEMA_RELOC(char*, pIdx, pFrom, zColl);
+    }else if( zColl==pTabFrom->aCol[iCol].zColl ){
+      /* The collation sequence of the indexed column */
+      pIdx->azColl[i] = pTab->aCol[iCol].zColl;
+    }else{
+      /* The default collation sequence */
+      assert( sqlite3StrICmp(zColl, p->zDfltColl)==0 );
+      pIdx->azColl[i] = p->zDfltColl;
+    }
+  }
+  pIdx->pTable = pTab;
+  pIdx->zColAff = 0;
+  pIdx->pNext = 0;
+  pIdx->pSchema = p->pTo;
+  pIdx->aSample = 0;
+  return pIdx;
+}
+
+#ifndef SQLITE_OMIT_FOREIGN_KEY
+/*
+** Make a copy of foreign key pFrom for table pTab. The copy is not linked
+** into the Schema.fkeyHash table.
+*/
+static FKey *schemaCopyFKey(SchemaCopy *p, FKey *pFrom, Table *pTab){
+  FKey *pFKey;
+  int i;
+
+  pFKey = (FKey*)schemaCopyBlock(p, pFrom);
+  if( pFKey==0 ) return 0;
+  pFKey->pFrom = pTab;
+  pFKey->pNextFrom = 0;
+  pFKey->zTo = SCHEMA_RELOC(char*, pFKey, pFrom, pFrom->zTo);
+  pFKey->pNextTo = 0;
+  pFKey->pPrevTo = 0;
+  pFKey->apTrigger[0] = 0;
+  pFKey->apTrigger[1] = 0;
+  for(i=0; i<pFKey->nCol; i++){
+    if( pFrom->aCol[i].zCol ){
+      pFKey->aCol[i].zCol = SCHEMA_RELOC(char*, pFKey, pFrom, pFrom->aCol[i].zCol);
+    }
+  }
+  return pFKey;
+}
+#endif
+
+/*
+** Make a copy of table pFrom, along with its indexes and foreign keys.
+** The indexes are added to the idxHash table of the new schema. The
+** table itself is not added to any hash table.
+**
+** If a malloc fails, the copy returned may be incomplete, but it can
+** always be freed by sqlite3DeleteTable().
+*/
+static Table *schemaCopyTable(SchemaCopy *p, Table *pFrom){
+  sqlite3 *db = p->db;
+  Table *pTab;
+  int i;
+
+  pTab = (Table*)sqlite3DbMallocRaw(db, sizeof(Table));
+  if( pTab==0 ) return 0;
+  memcpy(pTab, pFrom, sizeof(Table));
+  pTab->aCol = 0;
+  pTab->pIndex = 0;
+  pTab->pSelect = 0;
+  pTab->nRef = 1;
+  pTab->pFKey = 0;
+  pTab->zColAff = 0;
+#ifndef SQLITE_OMIT_CHECK
+  pTab->pCheck = 0;
+#endif
+#ifndef SQLITE_OMIT_VIRTUALTABLE
+  pTab->pVTable = 0;
+  pTab->nModuleArg = 0;
+  pTab->azModuleArg = 0;
+#endif
+  pTab->pTrigger = 0;
+  pTab->pSchema = p->pTo;
+  pTab->pNextZombie = 0;
+  pTab->zName = sqlite3DbStrDup(db, pFrom->zName);
+
+  if( pFrom->pSelect ){
+    /* The columns of a view are determined the first time it is used */
+    pTab->nCol = 0;
+    pTab->pSelect = schemaCopySelect(p, pFrom->pSelect);
+  }else if( pFrom->nCol>0 ){
+    /* Columns are allocated in groups of 8 by sqlite3AddColumn() */
+    int nAlloc = ((pFrom->nCol+7)/8)*8;
+    pTab->aCol = (Column*)sqlite3DbMallocZero(db, nAlloc*sizeof(Column));
+    if( pTab->aCol==0 ){
+      pTab->nCol = 0;
+      return pTab;
+    }
+    for(i=0; i<pFrom->nCol; i++){
+      Column *pCol = &pTab->aCol[i];
+      memcpy(pCol, &pFrom->aCol[i], sizeof(Column));
+      pCol->zName = sqlite3DbStrDup(db, pCol->zName);
+      pCol->pDflt = schemaCopyExpr(p, pCol->pDflt);
+      pCol->zDflt = sqlite3DbStrDup(db, pCol->zDflt);
+      pCol->zType = sqlite3DbStrDup(db, pCol->zType);
+      pCol->zColl = sqlite3DbStrDup(db, pCol->zColl);
+    }
+  }
+
+#ifndef SQLITE_OMIT_CHECK
+  p->pTabFrom = pFrom;
+  p->pTabTo = pTab;
+  pTab->pCheck = schemaCopyExpr(p, pFrom->pCheck);
+  p->pTabFrom = p->pTabTo = 0;
+#endif
+
+#ifndef SQLITE_OMIT_VIRTUALTABLE
+  if( pFrom->azModuleArg ){
+    pTab->azModuleArg = (char**)sqlite3DbMallocZero(db,
+        sizeof(char*)*(pFrom->nModuleArg+1)
+    );
+    if( pTab->azModuleArg ){
+      for(i=0; i<pFrom->nModuleArg; i++){
+        pTab->azModuleArg[i] = sqlite3DbStrDup(db, pFrom->azModuleArg[i]);
+      }
+      pTab->nModuleArg = pFrom->nModuleArg;
+    }
+  }
+#endif
+
+  if( !db->mallocFailed ){
+    Index *pFromIdx;
+    Index **ppIdx = &pTab->pIndex;
+    for(pFromIdx=pFrom->pIndex; pFromIdx; pFromIdx=pFromIdx->pNext){
+      Index *pIdx = schemaCopyIndex(p, pFromIdx, pFrom, pTab);
+      if( pIdx==0 ) break;
+      if( sqlite3HashInsert(&p->pTo->idxHash, pIdx->zName,
+                            sqlite3Strlen30(pIdx->zName), pIdx) ){
+        db->mallocFailed = 1;
+        sqlite3DbFree(db, pIdx);
+        break;
+      }
+      *ppIdx = pIdx;
+      ppIdx = &pIdx->pNext;
+    }
+  }
+
+#ifndef SQLITE_OMIT_FOREIGN_KEY
+  if( !db->mallocFailed ){
+    FKey *pFromFKey;
+    FKey **ppFKey = &pTab->pFKey;
+    for(pFromFKey=pFrom->pFKey; pFromFKey; pFromFKey=pFromFKey->pNextFrom){
+      FKey *pFKey = schemaCopyFKey(p, pFromFKey, pTab);
+      if( pFKey==0 ) break;
+      *ppFKey = pFKey;
+      ppFKey = &pFKey->pNextFrom;
+    }
+  }
+#endif
+
+  return pTab;
+}
+
+#ifndef SQLITE_OMIT_TRIGGER
+/*
+** Make a copy of trigger pFrom. If a malloc fails, the copy returned may
+** be incomplete, but it can always be freed by sqlite3DeleteTrigger().
+*/
+static Trigger *schemaCopyTrigger(SchemaCopy *p, Trigger *pFrom){
+  sqlite3 *db = p->db;
+  Trigger *pTrig;
+  TriggerStep *pFromStep;
+  TriggerStep *pLast = 0;
+
+  assert( pFrom->pSchema==p->pFrom && pFrom->pTabSchema==p->pFrom );
+  pTrig = (Trigger*)sqlite3DbMallocRaw(db, sizeof(Trigger));
+  if( pTrig==0 ) return 0;
+  memcpy(pTrig, pFrom, sizeof(Trigger));
+  pTrig->zName = sqlite3DbStrDup(db, pFrom->zName);
+  pTrig->table = sqlite3DbStrDup(db, pFrom->table);
+  pTrig->pWhen = schemaCopyExpr(p, pFrom->pWhen);
+  pTrig->pColumns = sqlite3IdListDup(db, pFrom->pColumns);
+  pTrig->pSchema = p->pTo;
+  pTrig->pTabSchema = p->pTo;
+  pTrig->step_list = 0;
+  pTrig->pNext = 0;
+
+  for(pFromStep=pFrom->step_list; pFromStep; pFromStep=pFromStep->pNext){
+    TriggerStep *pStep = (TriggerStep*)schemaCopyBlock(p, pFromStep);
+    if( pStep==0 ) break;
+    if( pFromStep->target.z ){
+      pStep->target.z = SCHEMA_RELOC(char*, pStep, pFromStep, pFromStep->target.z);
+    }
+    pStep->pTrig = pTrig;
+    pStep->pSelect = schemaCopySelect(p, pFromStep->pSelect);
+    pStep->pWhere = schemaCopyExpr(p, pFromStep->pWhere);
+    pStep->pExprList = schemaCopyList(p, pFromStep->pExprList);
+    pStep->pIdList = sqlite3IdListDup(db, pFromStep->pIdList);
+    pStep->pNext = 0;
+    pStep->pLast = 0;
+    if( pLast ){
+      pLast->pNext = pStep;
+    }else{
+      pTrig->step_list = pStep;
+    }
+    pLast = pStep;
+  }
+  if( pTrig->step_list ){
+    pTrig->step_list->pLast = pLast;
+  }
+  return pTrig;
+}
+#endif
+
+/*
+** Copy the tables, indexes, triggers and foreign keys of schema
+** p->pFrom into p->pTo. Tables are added to p->pTo in the order in which
+** they appear in sqlite_master image zImage, which is the order in which
+** they would be added if the schema were parsed. The sqlite_master table
+** itself is not copied.
+**
+** If a malloc fails, db->mallocFailed is set. Schema p->pTo may be left
+** partially populated, but it can always be cleared by
+** sqlite3SchemaClear().
+*/
+static void schemaCopy(SchemaCopy *p, const char *zImage, int nImage){
+  sqlite3 *db = p->db;
+  Schema *pFrom = p->pFrom;
+  Schema *pTo = p->pTo;
+  HashElem *pElem;
+  const char *z;
+  int iPass;
+
+  /* Copy the tables. The first pass copies them in the order they are
+  ** named in sqlite_master. The second catches any table with a name
+  ** that does not match its sqlite_master entry. */
+  for(iPass=0; iPass<2 && !db->mallocFailed; iPass++){
+    z = zImage;
+    pElem = sqliteHashFirst(&pFrom->tblHash);
+    while( !db->mallocFailed ){
+      Table *pFromTab;
+      Table *pTab;
+      int n;
+      if( iPass==0 ){
+        const char *azVal[3];
+        if( z>=&zImage[nImage] ) break;
+        z = schemaImageRow(z, azVal);
+        if( azVal[0]==0 ) continue;
+        n = sqlite3Strlen30(azVal[0]);
+        pFromTab = sqlite3HashFind(&pFrom->tblHash, azVal[0], n);
+        if( pFromTab==0 ) continue;
+      }else{
+        if( pElem==0 ) break;
+        pFromTab = (Table*)sqliteHashData(pElem);
+        pElem = sqliteHashNext(pElem);
+        n = sqlite3Strlen30(pFromTab->zName);
+      }
+      if( sqlite3StrICmp(pFromTab->zName, MASTER_NAME)==0
+       || sqlite3HashFind(&pTo->tblHash, pFromTab->zName, n)
+      ){
+        continue;
+      }
+      pTab = schemaCopyTable(p, pFromTab);
+      if( pTab==0 ) break;
+      if( db->mallocFailed
+       || sqlite3HashInsert(&pTo->tblHash, pTab->zName, n, pTab)
+      ){
+        db->mallocFailed = 1;
+        sqlite3DeleteTable(db, pTab);
+        break;
+      }
+    }
+  }
+  if( pFrom->pSeqTab && !db->mallocFailed ){
+    const char *zSeq = pFrom->pSeqTab->zName;
+    pTo->pSeqTab = sqlite3HashFind(&pTo->tblHash, zSeq, sqlite3Strlen30(zSeq));
+  }
+
+#ifndef SQLITE_OMIT_TRIGGER
+  /* Copy the triggers. Then attach them to their tables, in the same order
+  ** as they are attached to the originals. */
+  for(pElem=sqliteHashFirst(&pFrom->trigHash);
+      pElem && !db->mallocFailed;
+      pElem=sqliteHashNext(pElem)
+  ){
+    Trigger *pTrig = schemaCopyTrigger(p, (Trigger*)sqliteHashData(pElem));
+    if( pTrig==0 ) break;
+    if( db->mallocFailed || sqlite3HashInsert(&pTo->trigHash, pTrig->zName,
+                              sqlite3Strlen30(pTrig->zName), pTrig) ){
+      db->mallocFailed = 1;
+      sqlite3DeleteTrigger(db, pTrig);
+      break;
+    }
+  }
+  for(pElem=sqliteHashFirst(&pTo->tblHash);
+      pElem && !db->mallocFailed;
+      pElem=sqliteHashNext(pElem)
+  ){
+    Table *pTab = (Table*)sqliteHashData(pElem);
+    Table *pFromTab;
+    Trigger *pFromTrig;
+    Trigger **ppTrig = &pTab->pTrigger;
+    pFromTab = sqlite3HashFind(&pFrom->tblHash, pTab->zName,
+                               sqlite3Strlen30(pTab->zName));
+    if( pFromTab==0 ) continue;
+    for(pFromTrig=pFromTab->pTrigger; pFromTrig; pFromTrig=pFromTrig->pNext){
+      Trigger *pTrig = sqlite3HashFind(&pTo->trigHash, pFromTrig->zName,
+                                       sqlite3Strlen30(pFromTrig->zName));
+      assert( pTrig!=0 );
+      *ppTrig = pTrig;
+      ppTrig = &pTrig->pNext;
+    }
+  }
+#endif
+
+#ifndef SQLITE_OMIT_FOREIGN_KEY
+  /* Link the foreign keys into fkeyHash. Each entry of fkeyHash is a list
+  ** of all foreign keys that refer to a single parent table. Build the
+  ** same lists as in the original. */
+  for(pElem=sqliteHashFirst(&pFrom->fkeyHash);
+      pElem && !db->mallocFailed;
+      pElem=sqliteHashNext(pElem)
+  ){
+    FKey *pFromFKey;
+    FKey *pHead = 0;
+    FKey *pPrev = 0;
+    for(pFromFKey=(FKey*)sqliteHashData(pElem);
+        pFromFKey;
+        pFromFKey=pFromFKey->pNextTo
+    ){
+      Table *pFromTab = pFromFKey->pFrom;
+      Table *pTab;
+      FKey *pIter;
+      FKey *pFKey;
+      pTab = sqlite3HashFind(&pTo->tblHash, pFromTab->zName,
+                             sqlite3Strlen30(pFromTab->zName));
+      assert( pTab!=0 );
+      for(pIter=pFromTab->pFKey, pFKey=pTab->pFKey;
+          pIter!=pFromFKey;
+          pIter=pIter->pNextFrom, pFKey=pFKey->pNextFrom
+      );
+      assert( pFKey!=0 );
+      pFKey->pPrevTo = pPrev;
+      if( pPrev ){
+        pPrev->pNextTo = pFKey;
+      }else{
+        pHead = pFKey;
+      }
+      pPrev = pFKey;
+    }
+    if( pHead && sqlite3HashInsert(&pTo->fkeyHash, pHead->zTo,
+                                   sqlite3Strlen30(pHead->zTo), pHead) ){
+      db->mallocFailed = 1;
+    }
+  }
+#endif
+}
+
+/*
+** Store a copy of the schema of database iDb, which was just parsed from
+** the sqlite_master image in p, in the cache. Errors are ignored, as the
+** cache is only an optimization.
+*/
+static void schemaCacheInsert(sqlite3 *db, int iDb, SchemaImage *p){
+  Db *pDb = &db->aDb[iDb];
+  SchemaTemplate *pTmpl;
+  SchemaTemplate *pFree = 0;
+  SchemaTemplate **pp;
+  int nMax = sqlite3GlobalConfig.nSchemaCache;
+  int i;
+
+  sqlite3BeginBenignMalloc();
+  pTmpl = (SchemaTemplate*)sqlite3DbMallocZero(db, sizeof(SchemaTemplate));
+  if( pTmpl ){
+    SchemaCopy sCopy;
+    pTmpl->zFilename = sqlite3DbStrDup(db, sqlite3BtreeGetFilename(pDb->pBt));
+    pTmpl->zDb = sqlite3DbStrDup(db, pDb->zName);
+    pTmpl->enc = pDb->pSchema->enc;
+    pTmpl->file_format = pDb->pSchema->file_format;
+    pTmpl->pSchema = sqlite3SchemaGet(db, 0);
+    if( !db->mallocFailed ){
+      memset(&sCopy, 0, sizeof(sCopy));
+      sCopy.db = db;
+      sCopy.pFrom = pDb->pSchema;
+      sCopy.pTo = pTmpl->pSchema;
+      sCopy.pTmpl = pTmpl;
+      sCopy.zDfltColl = "BINARY";
+      schemaCopy(&sCopy, p->z, p->n);
+    }
+    if( db->mallocFailed ){
+      db->mallocFailed = 0;
+      schemaTemplateFree(pTmpl);
+      pTmpl = 0;
+    }else{
+      pTmpl->zImage = p->z;
+      pTmpl->nImage = p->n;
+      p->z = 0;
+    }
+  }
+  sqlite3EndBenignMalloc();
+  if( pTmpl==0 ) return;
+
+  /* Add the new template to the start of the list. Remove any existing
+  ** template for the same database, and the oldest templates if there
+  ** are now more than the configured maximum. */
+  sqlite3RwMutexEnter(SQLITE_RWMUTEX_STATIC_SCHEMA, 0);
+  pTmpl->pNext = schemaCache.pTmpl;
+  schemaCache.pTmpl = pTmpl;
+  schemaCache.nTmpl++;
+  for(pp=&pTmpl->pNext, i=1; *pp; ){
+    SchemaTemplate *pIter = *pp;
+    if( i>=nMax || (strcmp(pIter->zFilename, pTmpl->zFilename)==0
+                    && strcmp(pIter->zDb, pTmpl->zDb)==0) ){
+      *pp = pIter->pNext;
+      pIter->pNext = pFree;
+      pFree = pIter;
+      schemaCache.nTmpl--;
+    }else{
+      pp = &pIter->pNext;
+      i++;
+    }
+  }
+  sqlite3RwMutexLeave(SQLITE_RWMUTEX_STATIC_SCHEMA);
+
+  while( pFree ){
+    pTmpl = pFree->pNext;
+    schemaTemplateFree(pFree);
+    pFree = pTmpl;
+  }
+}
+
+/*
+** This routine is called by sqlite3InitOne() to read the schema of
+** database iDb from its sqlite_master table, with zSql the query that
+** reads the name, rootpage and sql columns. It is equivalent to:
+**
+**     sqlite3_exec(db, zSql, sqlite3InitCallback, pData, 0);
+**
+** If the schema cache is enabled, the sqlite_master rows are read into an
+** image first. If a template built from an identical image is cached for
+** the same database file, the schema is copied from it. Otherwise, the
+** rows are passed to sqlite3InitCallback() and, if the schema is parsed
+** successfully, a copy of it is added to the cache.
+*/
+int sqlite3SchemaCacheLoad(InitData *pData, const char *zSql){
+  sqlite3 *db = pData->db;
+  int iDb = pData->iDb;
+  Db *pDb = &db->aDb[iDb];
+  const char *zFilename;
+  SchemaImage sImage;
+  SchemaTemplate *pTmpl;
+  int rc;
+  u8 enableLookaside;
+
+  if( sqlite3GlobalConfig.nSchemaCache<=0
+   || iDb==1
+   || (db->flags & SQLITE_RecoveryMode)!=0
+   || (zFilename = sqlite3BtreeGetFilename(pDb->pBt))==0
+   || zFilename[0]==0
+  ){
+    return sqlite3_exec(db, zSql, sqlite3InitCallback, pData, 0);
+  }
+
+  /* Objects allocated below may become part of a template that outlives
+  ** this connection, so they must not use lookaside memory. */
+  enableLookaside = db->lookaside.bEnabled;
+  db->lookaside.bEnabled = 0;
+
+  memset(&sImage, 0, sizeof(sImage));
+  sImage.db = db;
+  rc = sqlite3_exec(db, zSql, schemaImageCallback, &sImage, 0);
+  if( rc!=SQLITE_OK || sImage.nRow==0 ){
+    /* Either there was an error reading the schema or it is empty. An
+    ** error is returned as is, as the statement that failed may have
+    ** rolled back the read transaction. An empty schema is not worth
+    ** caching. */
+    sqlite3DbFree(db, sImage.z);
+    db->lookaside.bEnabled = enableLookaside;
+    return rc;
+  }
+
+  sqlite3RwMutexEnter(SQLITE_RWMUTEX_STATIC_SCHEMA, 1);
+  for(pTmpl=schemaCache.pTmpl; pTmpl; pTmpl=pTmpl->pNext){
+    if( pTmpl->nImage==sImage.n
+     && pTmpl->enc==pDb->pSchema->enc
+     && pTmpl->file_format==pDb->pSchema->file_format
+     && strcmp(pTmpl->zFilename, zFilename)==0
+     && strcmp(pTmpl->zDb, pDb->zName)==0
+     && memcmp(pTmpl->zImage, sImage.z, sImage.n)==0
+    ){
+      SchemaCopy sCopy;
+      memset(&sCopy, 0, sizeof(sCopy));
+      sCopy.db = db;
+      sCopy.pFrom = pTmpl->pSchema;
+      sCopy.pTo = pDb->pSchema;
+      sCopy.zDfltColl = db->pDfltColl->zName;
+      schemaCopy(&sCopy, sImage.z, sImage.n);
+      break;
+    }
+  }
+  sqlite3RwMutexLeave(SQLITE_RWMUTEX_STATIC_SCHEMA);
+
+  if( pTmpl ){
+#ifdef SQLITE_TEST
+    sqlite3_schemacache_hit_count++;
+#endif
+    DbClearProperty(db, iDb, DB_Empty);
+    rc = db->mallocFailed ? SQLITE_NOMEM : SQLITE_OK;
+  }else{
+    const char *z = sImage.z;
+    while( z<&sImage.z[sImage.n] ){
+      const char *azVal[3];
+      z = schemaImageRow(z, azVal);
+      if( sqlite3InitCallback(pData, 3, (char**)azVal, 0) ){
+        rc = SQLITE_ABORT;
+        break;
+      }
+    }
+    if( rc==SQLITE_OK && pData->rc==SQLITE_OK && !db->mallocFailed ){
+      schemaCacheInsert(db, iDb, &sImage);
+    }
+  }
+
+  sqlite3DbFree(db, sImage.z);
+  db->lookaside.bEnabled = enableLookaside;
+  return rc;
+}
+
+/*
+** Free all templates in the cache. This is called by sqlite3_shutdown().
+*/
+void sqlite3SchemaCacheReset(void){
+  SchemaTemplate *p;
+  SchemaTemplate *pNext;
+  sqlite3RwMutexEnter(SQLITE_RWMUTEX_STATIC_SCHEMA, 0);
+  p = schemaCache.pTmpl;
+  schemaCache.pTmpl = 0;
+  schemaCache.nTmpl = 0;
+  sqlite3RwMutexLeave(SQLITE_RWMUTEX_STATIC_SCHEMA);
+  for(; p; p=pNext){
+    pNext = p->pNext;
+    schemaTemplateFree(p);
+  }
+}
@@ -62,7 +62,7 @@ Select *sqlite3SelectNew(
   Select *pNew;
   Select standin;
   sqlite3 *db = pParse->db;
-  pNew = sqlite3DbMallocZero(db, sizeof(*pNew) );
+  pNew = sqlite3ArenaMallocZero(db, sizeof(*pNew) );
   assert( db->mallocFailed || !pOffset || pLimit ); /* OFFSET implies LIMIT */
   if( pNew==0 ){
     pNew = &standin;
@@ -410,12 +410,19 @@ static int sqliteProcessJoin(Parse *pParse, Select *p){
 /*
 ** Insert code into "v" that will push the record on the top of the
 ** stack into the sorter.
+**
+** If regEList is not zero, then the values of the result set of pSelect
+** for the current row are stored in registers regEList and following.
+** ORDER BY terms that repeat a deterministic function call from the
+** result set use the value already computed instead of calling the
+** function again.
 */
 static void pushOntoSorter(
   Parse *pParse,         /* Parser context */
   ExprList *pOrderBy,    /* The ORDER BY clause */
   Select *pSelect,       /* The whole SELECT statement */
-  int regData            /* Register holding data to be sorted */
+  int regData,           /* Register holding data to be sorted */
+  int regEList           /* Registers holding the result set, or 0 */
 ){
   Vdbe *v = pParse->pVdbe;
   int nExpr = pOrderBy->nExpr;
@@ -423,6 +430,13 @@ static void pushOntoSorter(
   int regRecord = sqlite3GetTempReg(pParse);
   int op;
   sqlite3ExprCacheClear(pParse);
+  if( regEList ){
+    ExprList *pEList = pSelect->pEList;
+    int i;
+    for(i=0; i<pEList->nExpr; i++){
+      sqlite3ExprCacheStoreExpr(pParse, pEList->a[i].pExpr, regEList+i);
+    }
+  }
   sqlite3ExprCodeExprList(pParse, pOrderBy, regBase, 0);
   sqlite3VdbeAddOp2(v, OP_Sequence, pOrderBy->iECursor, regBase+nExpr);
   sqlite3ExprCodeMove(pParse, regData, regBase+nExpr+1, 1);
@@ -547,6 +561,7 @@ static void selectInnerLoop(
   int i;
   int hasDistinct;        /* True if the DISTINCT keyword is present */
   int regResult;              /* Start of memory holding result set */
+  int regEList = 0;           /* regResult, if computed from pEList */
   int eDest = pDest->eDest;   /* How to dispose of results */
   int iParm = pDest->iParm;   /* First argument to disposal method */
   int nResultCol;             /* Number of result columns */
@@ -584,6 +599,7 @@ static void selectInnerLoop(
     */
     sqlite3ExprCacheClear(pParse);
     sqlite3ExprCodeExprList(pParse, pEList, regResult, eDest==SRT_Output);
+    regEList = regResult;
   }
   nColumn = nResultCol;
 
@@ -633,7 +649,7 @@ static void selectInnerLoop(
       testcase( eDest==SRT_EphemTab );
       sqlite3VdbeAddOp3(v, OP_MakeRecord, regResult, nColumn, r1);
       if( pOrderBy ){
-        pushOntoSorter(pParse, pOrderBy, p, r1);
+        pushOntoSorter(pParse, pOrderBy, p, r1, regEList);
       }else{
         int r2 = sqlite3GetTempReg(pParse);
         sqlite3VdbeAddOp2(v, OP_NewRowid, iParm, r2);
@@ -658,7 +674,7 @@ static void selectInnerLoop(
         ** ORDER BY in this case since the order of entries in the set
         ** does not matter.  But there might be a LIMIT clause, in which
         ** case the order does matter */
-        pushOntoSorter(pParse, pOrderBy, p, regResult);
+        pushOntoSorter(pParse, pOrderBy, p, regResult, regEList);
       }else{
         int r1 = sqlite3GetTempReg(pParse);
         sqlite3VdbeAddOp4(v, OP_MakeRecord, regResult, 1, r1, &p->affinity, 1);
@@ -684,7 +700,7 @@ static void selectInnerLoop(
     case SRT_Mem: {
       assert( nColumn==1 );
       if( pOrderBy ){
-        pushOntoSorter(pParse, pOrderBy, p, regResult);
+        pushOntoSorter(pParse, pOrderBy, p, regResult, regEList);
       }else{
         sqlite3ExprCodeMove(pParse, regResult, iParm, 1);
         /* The LIMIT clause will jump out of the loop for us */
@@ -704,7 +720,7 @@ static void selectInnerLoop(
       if( pOrderBy ){
         int r1 = sqlite3GetTempReg(pParse);
         sqlite3VdbeAddOp3(v, OP_MakeRecord, regResult, nColumn, r1);
-        pushOntoSorter(pParse, pOrderBy, p, r1);
+        pushOntoSorter(pParse, pOrderBy, p, r1, regEList);
         sqlite3ReleaseTempReg(pParse, r1);
       }else if( eDest==SRT_Coroutine ){
         sqlite3VdbeAddOp1(v, OP_Yield, pDest->iParm);
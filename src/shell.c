@@ -1036,6 +1036,12 @@ static int display_stats(
     iHiwtr = iCur = -1;
     sqlite3_db_status(db, SQLITE_DBSTATUS_STMT_USED, &iCur, &iHiwtr, bReset);
     fprintf(pArg->out, "Statement Heap/Lookaside Usage:      %d bytes\n", iCur); 
+    iHiwtr = iCur = -1;
+    sqlite3_db_status(db, SQLITE_DBSTATUS_SEEK_LOCAL, &iCur, &iHiwtr, bReset);
+    fprintf(pArg->out, "B-Tree Seeks Starting Locally:       %d\n", iCur); 
+    iHiwtr = iCur = -1;
+    sqlite3_db_status(db, SQLITE_DBSTATUS_SEEK_ROOT, &iCur, &iHiwtr, bReset);
+    fprintf(pArg->out, "B-Tree Seeks Starting At Root:       %d\n", iCur); 
   }
 
   if( pArg && pArg->out && db && pArg->pStmt ){
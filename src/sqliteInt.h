@@ -364,6 +364,16 @@
 # define SQLITE_DEFAULT_RECURSIVE_TRIGGERS 0
 #endif
 
+/*
+** The maximum number of bytes of additional lookaside memory that a
+** database connection may allocate on demand. Zero means the lookaside
+** buffer never grows. This can be changed at run-time using
+** sqlite3_db_config(SQLITE_DBCONFIG_LOOKASIDE_GROWTH).
+*/
+#ifndef SQLITE_DEFAULT_LOOKASIDE_GROWTH
+# define SQLITE_DEFAULT_LOOKASIDE_GROWTH 0
+#endif
+
 /*
 ** Provide a default value for SQLITE_TEMP_STORE in case it is not specified
 ** on the command-line
@@ -601,6 +611,8 @@ struct BusyHandler {
 ** Forward references to structures
 */
 typedef struct AggInfo AggInfo;
+typedef struct Arena Arena;
+typedef struct ArenaChunk ArenaChunk;
 typedef struct AuthContext AuthContext;
 typedef struct AutoincInfo AutoincInfo;
 typedef struct Bitvec Bitvec;
@@ -620,7 +632,11 @@ typedef struct Index Index;
 typedef struct IndexSample IndexSample;
 typedef struct KeyClass KeyClass;
 typedef struct KeyInfo KeyInfo;
+typedef struct LazyRow LazyRow;
+typedef struct LazyTable LazyTable;
 typedef struct Lookaside Lookaside;
+typedef struct LookasideChunk LookasideChunk;
+typedef struct LookasideClass LookasideClass;
 typedef struct LookasideSlot LookasideSlot;
 typedef struct Module Module;
 typedef struct NameContext NameContext;
@@ -697,6 +713,8 @@ struct Schema {
   Hash idxHash;        /* All (named) indices indexed by name */
   Hash trigHash;       /* All triggers indexed by name */
   Hash fkeyHash;       /* All foreign keys by referenced table name */
+  Hash lazyHash;       /* Unparsed tables by the names of their objects */
+  LazyTable *pLazy;    /* List of all unparsed tables */
   Table *pSeqTab;      /* The sqlite_sequence table used by AUTOINCREMENT */
   u8 file_format;      /* Schema format version for this file */
   u8 enc;              /* Text encoding used by this database */
@@ -727,6 +745,38 @@ struct Schema {
 #define DB_UnresetViews    0x0002  /* Some views have defined column names */
 #define DB_Empty           0x0004  /* The file is empty (length 0 bytes) */
 
+/*
+** If the schema is loaded with SQLITE_CONFIG_LAZYSCHEMA enabled, the
+** CREATE statements for most tables and views are not parsed when the
+** schema is loaded. Instead, the sqlite_master rows for the table and
+** for the indexes and triggers attached to it are saved in a LazyTable
+** object, and parsed when one of those objects is first looked up by
+** name. Tables that have foreign keys are always parsed up front, so
+** that the Schema.fkeyHash table is complete.
+**
+** Each LazyTable is on the Schema.pLazy list. Schema.lazyHash maps
+** the name of each object whose CREATE statement has not yet been
+** parsed to the LazyTable that the object belongs to.
+**
+** The sqlite_stat1 rows for an unparsed table are saved on the
+** LazyTable.pStat list. For these LazyRow.zName is the name of the
+** index, or NULL, and LazyRow.zSql is the "stat" column.
+*/
+struct LazyRow {
+  char *zName;         /* Name of the table, index or trigger */
+  char *zSql;          /* CREATE statement. NULL for automatic indexes */
+  int iRoot;           /* Root page number */
+  LazyRow *pNext;      /* Next row for the same table */
+};
+struct LazyTable {
+  char *zName;         /* Name of the table or view */
+  LazyRow *pRow;       /* sqlite_master rows, in rowid order */
+  LazyRow *pLast;      /* Last entry on the pRow list */
+  LazyRow *pStat;      /* sqlite_stat1 rows */
+  LazyTable *pNext;    /* Next entry on the Schema.pLazy list */
+  LazyTable *pPrev;    /* Previous entry on the Schema.pLazy list */
+};
+
 /*
 ** The number of different kinds of things that can be limited
 ** using the sqlite3_limit() interface.
@@ -752,22 +802,65 @@ struct Schema {
 ** is shared by multiple database connections.  Therefore, while parsing
 ** schema information, the Lookaside.bEnabled flag is cleared so that
 ** lookaside allocations are not used to construct the schema objects.
-*/
+**
+** Buffers belong to one of LOOKASIDE_NCLASS size classes. The buffers
+** of class i are (sz<<i) bytes in size. The initial buffer configured by
+** SQLITE_DBCONFIG_LOOKASIDE, between pStart and pEnd, holds buffers of
+** class 0 only. If nGrowMax is greater than zero, then when the list of
+** available buffers for a class is empty, a LookasideChunk containing
+** more buffers of that class is allocated, until a total of nGrowMax
+** bytes have been allocated this way. Chunks are not freed until the
+** lookaside configuration is changed or the connection is closed.
+*/
+#define LOOKASIDE_NCLASS 3
+struct LookasideClass {
+  LookasideSlot *pFree;   /* List of available buffers of this class */
+  int nSlot;              /* Total number of buffers of this class */
+  int nHit;               /* Allocations satisfied from this class */
+  int nMiss;              /* Allocations missed because the class was full */
+};
 struct Lookaside {
-  u16 sz;                 /* Size of each buffer in bytes */
+  u16 sz;                 /* Size of each buffer of class 0 in bytes */
   u8 bEnabled;            /* False to disable new lookaside allocations */
   u8 bMalloced;           /* True if pStart obtained from sqlite3_malloc() */
   int nOut;               /* Number of buffers currently checked out */
   int mxOut;              /* Highwater mark for nOut */
   int anStat[3];          /* 0: hits.  1: size misses.  2: full misses */
-  LookasideSlot *pFree;   /* List of available buffers */
+  int szMax;              /* Size of the largest buffer that may be used */
+  int nGrow;              /* Bytes of memory used by LookasideChunks */
+  int nGrowMax;           /* Maximum value for nGrow */
+  LookasideClass aClass[LOOKASIDE_NCLASS];  /* Available buffers by class */
+  LookasideChunk *pChunk; /* Chunks allocated on demand. Newest first */
   void *pStart;           /* First byte of available memory space */
   void *pEnd;             /* First byte past end of available space */
 };
+struct LookasideChunk {
+  LookasideChunk *pNext;  /* Next (older) chunk */
+  u8 *pEnd;               /* First byte past the end of this chunk */
+  int iClass;             /* Size class of the buffers in this chunk */
+};
 struct LookasideSlot {
   LookasideSlot *pNext;    /* Next buffer in the list of free buffers */
 };
 
+/*
+** While an SQL statement is being prepared, the parse-tree objects
+** created for it are allocated from an Arena owned by its Parse object.
+** Memory is allocated by advancing a pointer through the current chunk,
+** and all of it is released at once when the statement has been
+** prepared. See the comments above sqlite3ArenaMallocRaw() for details.
+*/
+struct Arena {
+  ArenaChunk *pChunk;     /* Most recently allocated chunk, or NULL */
+  u8 *pFree;              /* First unused byte in pChunk */
+  u8 *pEnd;               /* First byte past the end of pChunk */
+  Arena *pOuter;          /* Arena of the enclosing statement, if any */
+};
+struct ArenaChunk {
+  ArenaChunk *pNext;      /* Next chunk in the list (allocated earlier) */
+  u8 *pEnd;               /* First byte past the end of this chunk */
+};
+
 /*
 ** A hash table for function definitions.
 **
@@ -813,6 +906,7 @@ struct sqlite3 {
   int errCode;                  /* Most recent error code (SQLITE_*) */
   int errMask;                  /* & result codes with this before returning */
   u8 autoCommit;                /* The auto-commit flag. */
+  u8 isConcurrent;              /* True after BEGIN CONCURRENT */
   u8 temp_store;                /* 1: file 2: memory 0: default */
   u8 mallocFailed;              /* True if we have seen a malloc failure */
   u8 dfltLockMode;              /* Default locking-mode for attached dbs */
@@ -865,6 +959,7 @@ struct sqlite3 {
     double notUsed1;            /* Spacer */
   } u1;
   Lookaside lookaside;          /* Lookaside malloc configuration */
+  Arena *pArena;                /* Arena of the statement being prepared */
 #ifndef SQLITE_OMIT_AUTHORIZATION
   int (*xAuth)(void*,int,const char*,const char*,const char*,const char*);
                                 /* Access authorization function */
@@ -1026,10 +1121,12 @@ struct FuncDestructor {
 #define SQLITE_FUNC_PRIVATE  0x10 /* Allowed for internal use only */
 #define SQLITE_FUNC_COUNT    0x20 /* Built-in count(*) aggregate */
 #define SQLITE_FUNC_COALESCE 0x40 /* Built-in coalesce() or ifnull() function */
+#define SQLITE_FUNC_CONSTANT 0x80 /* Deterministic.  SQLITE_DETERMINISTIC */
 
 /*
-** The following three macros, FUNCTION(), LIKEFUNC() and AGGREGATE() are
-** used to create the initializers for the FuncDef structures.
+** The following four macros, FUNCTION(), VFUNCTION(), LIKEFUNC() and
+** AGGREGATE() are used to create the initializers for the FuncDef
+** structures.
 **
 **   FUNCTION(zName, nArg, iArg, bNC, xFunc)
 **     Used to create a scalar function definition of a function zName 
@@ -1037,6 +1134,12 @@ struct FuncDestructor {
 **     value passed as iArg is cast to a (void*) and made available
 **     as the user-data (sqlite3_user_data()) for the function. If 
 **     argument bNC is true, then the SQLITE_FUNC_NEEDCOLL flag is set.
+**     The function is deterministic (SQLITE_FUNC_CONSTANT).
+**
+**   VFUNCTION(zName, nArg, iArg, bNC, xFunc)
+**     Like FUNCTION() except that the function is not deterministic:
+**     it may return different results for the same arguments, or
+**     have side effects, so that every call must be made.
 **
 **   AGGREGATE(zName, nArg, iArg, bNC, xStep, xFinal)
 **     Used to create an aggregate function definition implemented by
@@ -1050,16 +1153,20 @@ struct FuncDestructor {
 **     function likeFunc. Argument pArg is cast to a (void *) and made
 **     available as the function user-data (sqlite3_user_data()). The
 **     FuncDef.flags variable is set to the value passed as the flags
-**     parameter.
+**     parameter, plus SQLITE_FUNC_CONSTANT.
 */
 #define FUNCTION(zName, nArg, iArg, bNC, xFunc) \
+  {nArg, SQLITE_UTF8, SQLITE_FUNC_CONSTANT|bNC*SQLITE_FUNC_NEEDCOLL, \
+   SQLITE_INT_TO_PTR(iArg), 0, xFunc, 0, 0, #zName, 0, 0}
+#define VFUNCTION(zName, nArg, iArg, bNC, xFunc) \
   {nArg, SQLITE_UTF8, bNC*SQLITE_FUNC_NEEDCOLL, \
    SQLITE_INT_TO_PTR(iArg), 0, xFunc, 0, 0, #zName, 0, 0}
 #define STR_FUNCTION(zName, nArg, pArg, bNC, xFunc) \
   {nArg, SQLITE_UTF8, bNC*SQLITE_FUNC_NEEDCOLL, \
    pArg, 0, xFunc, 0, 0, #zName, 0, 0}
 #define LIKEFUNC(zName, nArg, arg, flags) \
-  {nArg, SQLITE_UTF8, flags, (void *)arg, 0, likeFunc, 0, 0, #zName, 0, 0}
+  {nArg, SQLITE_UTF8, SQLITE_FUNC_CONSTANT|flags, \
+   (void *)arg, 0, likeFunc, 0, 0, #zName, 0, 0}
 #define AGGREGATE(zName, nArg, arg, nc, xStep, xFinal) \
   {nArg, SQLITE_UTF8, nc*SQLITE_FUNC_NEEDCOLL, \
    SQLITE_INT_TO_PTR(arg), 0, 0, xStep,xFinal,#zName,0,0}
@@ -2212,6 +2319,7 @@ struct Parse {
   struct yColCache {
     int iTable;           /* Table cursor number */
     int iColumn;          /* Table column number */
+    Expr *pExpr;          /* Cached expression, or NULL for a column */
     u8 tempReg;           /* iReg is a temp register that needs to be freed */
     int iLevel;           /* Nesting level */
     int iReg;             /* Reg with value of this column. 0 means none. */
@@ -2241,6 +2349,7 @@ struct Parse {
   u8 eOrconf;          /* Default ON CONFLICT policy for trigger steps */
   u8 disableTriggers;  /* True to disable triggers */
   double nQueryLoop;   /* Estimated number of iterations of a query */
+  Arena sArena;        /* Memory for the parse tree of this statement */
 
   /* Above is constant between recursions.  Below is reset before and after
   ** each recursion */
@@ -2299,6 +2408,8 @@ struct AuthContext {
 #define OPFLAG_APPEND        0x08    /* This is likely to be an append */
 #define OPFLAG_USESEEKRESULT 0x10    /* Try to avoid a seek in BtreeInsert() */
 #define OPFLAG_CLEARCACHE    0x20    /* Clear pseudo-table cache in OP_Column */
+#define OPFLAG_SEEKSCAN      0x40    /* Seek keys arrive in ascending order */
+#define OPFLAG_REALAFFINITY  0x80    /* Apply REAL affinity in OP_Column */
 
 /*
  * Each trigger present in the database schema is stored as an instance of
@@ -2428,6 +2539,7 @@ typedef struct {
   int iDb;            /* 0 for main database.  1 for TEMP, 2.. for ATTACHed */
   char **pzErrMsg;    /* Error message stored here */
   int rc;             /* Result code stored here */
+  u8 bLazy;           /* Defer parsing tables until they are used */
 } InitData;
 
 /*
@@ -2457,6 +2569,8 @@ struct Sqlite3Config {
   int nPage;                        /* Number of pages in pPage[] */
   int mxParserStack;                /* maximum depth of the parser stack */
   int sharedCacheEnabled;           /* true if shared-cache mode enabled */
+  int nSchemaCache;                 /* Max number of cached schemas */
+  int bLazySchema;                  /* True to parse tables on first use */
   /* The above might be initialized to non-zero.  The following need to always
   ** initially be zero, however. */
   int isInit;                       /* True after initialization has finished */
@@ -2578,6 +2692,10 @@ void *sqlite3Malloc(int);
 void *sqlite3MallocZero(int);
 void *sqlite3DbMallocZero(sqlite3*, int);
 void *sqlite3DbMallocRaw(sqlite3*, int);
+void *sqlite3ArenaMallocZero(sqlite3*, int);
+void *sqlite3ArenaMallocRaw(sqlite3*, int);
+void sqlite3ArenaBegin(sqlite3*, Arena*);
+void sqlite3ArenaEnd(sqlite3*, Arena*);
 char *sqlite3DbStrDup(sqlite3*,const char*);
 char *sqlite3DbStrNDup(sqlite3*,const char*, int);
 void *sqlite3Realloc(void*, int);
@@ -2618,6 +2736,10 @@ const sqlite3_mem_methods *sqlite3MemGetMemsys3(void);
 #ifdef SQLITE_ENABLE_MEMSYS5
 const sqlite3_mem_methods *sqlite3MemGetMemsys5(void);
 #endif
+#ifdef SQLITE_ENABLE_MEMSYS6
+const sqlite3_mem_methods *sqlite3MemGetMemsys6(void);
+int sqlite3Memsys6Config(int);
+#endif
 
 
 #ifndef SQLITE_MUTEX_OMIT
@@ -2626,6 +2748,8 @@ const sqlite3_mem_methods *sqlite3MemGetMemsys5(void);
   sqlite3_mutex *sqlite3MutexAlloc(int);
   int sqlite3MutexInit(void);
   int sqlite3MutexEnd(void);
+  void sqlite3RwMutexEnter(int, int);
+  void sqlite3RwMutexLeave(int);
 #endif
 
 int sqlite3StatusValue(int);
@@ -2675,6 +2799,11 @@ void sqlite3ExprListSetSpan(Parse*,ExprList*,ExprSpan*);
 void sqlite3ExprListDelete(sqlite3*, ExprList*);
 int sqlite3Init(sqlite3*, char**);
 int sqlite3InitCallback(void*, int, char**, char**);
+int sqlite3SchemaCacheLoad(InitData*, const char*);
+void sqlite3SchemaCacheReset(void);
+void sqlite3LazyParse(sqlite3*, int, const char*);
+void sqlite3LazyParseAll(sqlite3*, int);
+void sqlite3LazyDelete(sqlite3*, LazyTable*);
 void sqlite3Pragma(Parse*,Token*,Token*,Token*,int);
 void sqlite3ResetInternalSchema(sqlite3*, int);
 void sqlite3BeginParse(Parse*,int);
@@ -2760,6 +2889,7 @@ void sqlite3ExprCodeGetColumnOfTable(Vdbe*, Table*, int, int, int);
 void sqlite3ExprCodeMove(Parse*, int, int, int);
 void sqlite3ExprCodeCopy(Parse*, int, int, int);
 void sqlite3ExprCacheStore(Parse*, int, int, int);
+void sqlite3ExprCacheStoreExpr(Parse*, Expr*, int);
 void sqlite3ExprCachePush(Parse*);
 void sqlite3ExprCachePop(Parse*, int);
 void sqlite3ExprCacheRemove(Parse*, int, int);
@@ -3011,6 +3141,7 @@ int sqlite3FindDb(sqlite3*, Token*);
 int sqlite3FindDbName(sqlite3 *, const char *);
 int sqlite3AnalysisLoad(sqlite3*,int iDB);
 void sqlite3DeleteIndexSamples(sqlite3*,Index*);
+void sqlite3DecodeStat1(Table*, Index*, const char*);
 void sqlite3DefaultRowEst(Index*);
 void sqlite3RegisterLikeFunctions(sqlite3*, int);
 int sqlite3IsLikeFunction(sqlite3*,Expr*,int*,char*);
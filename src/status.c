@@ -132,6 +132,24 @@ int sqlite3_db_status(
       break;
     }
 
+    case SQLITE_DBSTATUS_LOOKASIDE_CLASS0:
+    case SQLITE_DBSTATUS_LOOKASIDE_CLASS1:
+    case SQLITE_DBSTATUS_LOOKASIDE_CLASS2: {
+      LookasideClass *pClass;
+      testcase( op==SQLITE_DBSTATUS_LOOKASIDE_CLASS0 );
+      testcase( op==SQLITE_DBSTATUS_LOOKASIDE_CLASS1 );
+      testcase( op==SQLITE_DBSTATUS_LOOKASIDE_CLASS2 );
+      assert( (op-SQLITE_DBSTATUS_LOOKASIDE_CLASS0)<LOOKASIDE_NCLASS );
+      pClass = &db->lookaside.aClass[op - SQLITE_DBSTATUS_LOOKASIDE_CLASS0];
+      *pCurrent = pClass->nHit;
+      *pHighwater = pClass->nMiss;
+      if( resetFlag ){
+        pClass->nHit = 0;
+        pClass->nMiss = 0;
+      }
+      break;
+    }
+
     /* 
     ** Return an approximation for the amount of memory currently used
     ** by all pagers associated with the given database connection.  The
@@ -154,6 +172,32 @@ int sqlite3_db_status(
       break;
     }
 
+    /*
+    ** Set *pCurrent to the total number of b-tree seeks performed on all
+    ** databases that did (SEEK_LOCAL) or did not (SEEK_ROOT) manage to
+    ** avoid starting from the root page. *pHighwater is set to zero.
+    */
+    case SQLITE_DBSTATUS_SEEK_LOCAL:
+    case SQLITE_DBSTATUS_SEEK_ROOT: {
+      int nSeek = 0;
+      int i;
+      testcase( op==SQLITE_DBSTATUS_SEEK_LOCAL );
+      testcase( op==SQLITE_DBSTATUS_SEEK_ROOT );
+      sqlite3BtreeEnterAll(db);
+      for(i=0; i<db->nDb; i++){
+        Btree *pBt = db->aDb[i].pBt;
+        if( pBt ){
+          nSeek += sqlite3BtreeSeekCount(pBt, 
+              op==SQLITE_DBSTATUS_SEEK_LOCAL, resetFlag
+          );
+        }
+      }
+      sqlite3BtreeLeaveAll(db);
+      *pCurrent = nSeek;
+      *pHighwater = 0;
+      break;
+    }
+
     /*
     ** *pCurrent gets an accurate estimate of the amount of memory used
     ** to store the schema for all databases (main, temp, and any ATTACHed
@@ -169,17 +213,20 @@ int sqlite3_db_status(
         Schema *pSchema = db->aDb[i].pSchema;
         if( ALWAYS(pSchema!=0) ){
           HashElem *p;
+          LazyTable *pLazy;
 
           nByte += sqlite3GlobalConfig.m.xRoundup(sizeof(HashElem)) * (
               pSchema->tblHash.count 
             + pSchema->trigHash.count
             + pSchema->idxHash.count
             + pSchema->fkeyHash.count
+            + pSchema->lazyHash.count
           );
           nByte += sqlite3MallocSize(pSchema->tblHash.ht);
           nByte += sqlite3MallocSize(pSchema->trigHash.ht);
           nByte += sqlite3MallocSize(pSchema->idxHash.ht);
           nByte += sqlite3MallocSize(pSchema->fkeyHash.ht);
+          nByte += sqlite3MallocSize(pSchema->lazyHash.ht);
 
           for(p=sqliteHashFirst(&pSchema->trigHash); p; p=sqliteHashNext(p)){
             sqlite3DeleteTrigger(db, (Trigger*)sqliteHashData(p));
@@ -187,6 +234,9 @@ int sqlite3_db_status(
           for(p=sqliteHashFirst(&pSchema->tblHash); p; p=sqliteHashNext(p)){
             sqlite3DeleteTable(db, (Table *)sqliteHashData(p));
           }
+          for(pLazy=pSchema->pLazy; pLazy; pLazy=pLazy->pNext){
+            sqlite3LazyDelete(db, pLazy);
+          }
         }
       }
       db->pnBytesFreed = 0;
@@ -123,6 +123,7 @@ const char *sqlite3TestErrorName(int rc){
     case SQLITE_PERM:                zName = "SQLITE_PERM";              break;
     case SQLITE_ABORT:               zName = "SQLITE_ABORT";             break;
     case SQLITE_BUSY:                zName = "SQLITE_BUSY";              break;
+    case SQLITE_BUSY_SNAPSHOT:       zName = "SQLITE_BUSY_SNAPSHOT";     break;
     case SQLITE_LOCKED:              zName = "SQLITE_LOCKED";            break;
     case SQLITE_LOCKED_SHAREDCACHE:  zName = "SQLITE_LOCKED_SHAREDCACHE";break;
     case SQLITE_NOMEM:               zName = "SQLITE_NOMEM";             break;
@@ -5455,6 +5456,85 @@ static int test_wal_checkpoint_v2(
   return TCL_OK;
 }
 
+/*
+** Usage: sqlite3_snapshot_get DB DBNAME
+**
+** Return a pointer to a new snapshot object. If an error occurs, return
+** the error code (e.g. "SQLITE_ERROR") as a Tcl error.
+*/
+static int test_snapshot_get(
+  ClientData clientData, /* Unused */
+  Tcl_Interp *interp,    /* The TCL interpreter that invoked this command */
+  int objc,              /* Number of arguments */
+  Tcl_Obj *CONST objv[]  /* Command arguments */
+){
+  sqlite3 *db;
+  sqlite3_snapshot *pSnapshot = 0;
+  char zBuf[100];
+  int rc;
+
+  if( objc!=3 ){
+    Tcl_WrongNumArgs(interp, 1, objv, "DB DBNAME");
+    return TCL_ERROR;
+  }
+  if( getDbPointer(interp, Tcl_GetString(objv[1]), &db) ) return TCL_ERROR;
+
+  rc = sqlite3_snapshot_get(db, Tcl_GetString(objv[2]), &pSnapshot);
+  if( rc!=SQLITE_OK ){
+    Tcl_SetResult(interp, (char *)sqlite3TestErrorName(rc), TCL_VOLATILE);
+    return TCL_ERROR;
+  }
+  if( sqlite3TestMakePointerStr(interp, zBuf, pSnapshot) ) return TCL_ERROR;
+  Tcl_SetResult(interp, zBuf, TCL_VOLATILE);
+  return TCL_OK;
+}
+
+/*
+** Usage: sqlite3_snapshot_open DB DBNAME SNAPSHOT
+**
+** Return the result of sqlite3_snapshot_open() as an error code name.
+*/
+static int test_snapshot_open(
+  ClientData clientData, /* Unused */
+  Tcl_Interp *interp,    /* The TCL interpreter that invoked this command */
+  int objc,              /* Number of arguments */
+  Tcl_Obj *CONST objv[]  /* Command arguments */
+){
+  sqlite3 *db;
+  sqlite3_snapshot *pSnapshot;
+  int rc;
+
+  if( objc!=4 ){
+    Tcl_WrongNumArgs(interp, 1, objv, "DB DBNAME SNAPSHOT");
+    return TCL_ERROR;
+  }
+  if( getDbPointer(interp, Tcl_GetString(objv[1]), &db) ) return TCL_ERROR;
+  pSnapshot = (sqlite3_snapshot*)sqlite3TestTextToPtr(Tcl_GetString(objv[3]));
+
+  rc = sqlite3_snapshot_open(db, Tcl_GetString(objv[2]), pSnapshot);
+  Tcl_SetResult(interp, (char *)sqlite3TestErrorName(rc), TCL_VOLATILE);
+  return TCL_OK;
+}
+
+/*
+** Usage: sqlite3_snapshot_free SNAPSHOT
+*/
+static int test_snapshot_free(
+  ClientData clientData, /* Unused */
+  Tcl_Interp *interp,    /* The TCL interpreter that invoked this command */
+  int objc,              /* Number of arguments */
+  Tcl_Obj *CONST objv[]  /* Command arguments */
+){
+  if( objc!=2 ){
+    Tcl_WrongNumArgs(interp, 1, objv, "SNAPSHOT");
+    return TCL_ERROR;
+  }
+  sqlite3_snapshot_free(
+      (sqlite3_snapshot*)sqlite3TestTextToPtr(Tcl_GetString(objv[1]))
+  );
+  return TCL_OK;
+}
+
 /*
 ** tclcmd:  test_sqlite3_log ?SCRIPT?
 */
@@ -5822,6 +5902,8 @@ int Sqlitetest1_Init(Tcl_Interp *interp){
   extern int sqlite3_hostid_num;
 #endif
   extern int sqlite3_max_blobsize;
+  extern int sqlite3_arena_alloc_count;
+  extern int sqlite3_schemacache_hit_count;
   extern int sqlite3BtreeSharedCacheReport(void*,
                                           Tcl_Interp*,int,Tcl_Obj*CONST*);
   static struct {
@@ -6014,6 +6096,9 @@ int Sqlitetest1_Init(Tcl_Interp *interp){
 #endif
      { "sqlite3_wal_checkpoint",   test_wal_checkpoint, 0  },
      { "sqlite3_wal_checkpoint_v2",test_wal_checkpoint_v2, 0  },
+     { "sqlite3_snapshot_get",     test_snapshot_get,      0  },
+     { "sqlite3_snapshot_open",    test_snapshot_open,     0  },
+     { "sqlite3_snapshot_free",    test_snapshot_free,     0  },
      { "test_sqlite3_log",         test_sqlite3_log, 0  },
 #ifndef SQLITE_OMIT_EXPLAIN
      { "print_explain_query_plan", test_print_eqp, 0  },
@@ -6029,9 +6114,19 @@ int Sqlitetest1_Init(Tcl_Interp *interp){
   extern int sqlite3_pager_readdb_count;
   extern int sqlite3_pager_writedb_count;
   extern int sqlite3_pager_writej_count;
+  extern int sqlite3_pager_writev_count;
+  extern int sqlite3_pager_prefetch_count;
+#ifndef SQLITE_OMIT_WAL
+  extern int sqlite3_wal_writeback_count;
+  extern int sqlite3_wal_hash_probe_count;
+#endif
 #if SQLITE_OS_WIN
   extern int sqlite3_os_type;
 #endif
+#if SQLITE_OS_UNIX
+  extern int sqlite3_unix_directio_copy_count;
+  extern int sqlite3_uring_max_submit;
+#endif
 #ifdef SQLITE_DEBUG
   extern int sqlite3WhereTrace;
   extern int sqlite3OSTrace;
@@ -6063,6 +6158,10 @@ int Sqlitetest1_Init(Tcl_Interp *interp){
       (char*)&sqlite3_max_blobsize, TCL_LINK_INT);
   Tcl_LinkVar(interp, "sqlite_like_count", 
       (char*)&sqlite3_like_count, TCL_LINK_INT);
+  Tcl_LinkVar(interp, "sqlite_arena_alloc_count", 
+      (char*)&sqlite3_arena_alloc_count, TCL_LINK_INT);
+  Tcl_LinkVar(interp, "sqlite_schemacache_hit_count", 
+      (char*)&sqlite3_schemacache_hit_count, TCL_LINK_INT);
   Tcl_LinkVar(interp, "sqlite_interrupt_count", 
       (char*)&sqlite3_interrupt_count, TCL_LINK_INT);
   Tcl_LinkVar(interp, "sqlite_open_file_count", 
@@ -6081,6 +6180,22 @@ int Sqlitetest1_Init(Tcl_Interp *interp){
       (char*)&sqlite3_pager_writedb_count, TCL_LINK_INT);
   Tcl_LinkVar(interp, "sqlite3_pager_writej_count",
       (char*)&sqlite3_pager_writej_count, TCL_LINK_INT);
+  Tcl_LinkVar(interp, "sqlite3_pager_writev_count",
+      (char*)&sqlite3_pager_writev_count, TCL_LINK_INT);
+  Tcl_LinkVar(interp, "sqlite3_pager_prefetch_count",
+      (char*)&sqlite3_pager_prefetch_count, TCL_LINK_INT);
+#ifndef SQLITE_OMIT_WAL
+  Tcl_LinkVar(interp, "sqlite3_wal_writeback_count",
+      (char*)&sqlite3_wal_writeback_count, TCL_LINK_INT);
+  Tcl_LinkVar(interp, "sqlite3_wal_hash_probe_count",
+      (char*)&sqlite3_wal_hash_probe_count, TCL_LINK_INT);
+#endif
+#if SQLITE_OS_UNIX
+  Tcl_LinkVar(interp, "sqlite3_unix_directio_copy_count",
+      (char*)&sqlite3_unix_directio_copy_count, TCL_LINK_INT);
+  Tcl_LinkVar(interp, "sqlite3_uring_max_submit",
+      (char*)&sqlite3_uring_max_submit, TCL_LINK_INT);
+#endif
 #ifndef SQLITE_OMIT_UTF16
   Tcl_LinkVar(interp, "unaligned_string_counter",
       (char*)&unaligned_string_counter, TCL_LINK_INT);
@@ -1094,6 +1094,38 @@ static int test_db_config_lookaside(
   return TCL_OK;
 }
 
+/*
+** Usage:    sqlite3_db_config_lookaside_growth  CONNECTION  NBYTE
+**
+** Set the maximum number of bytes of lookaside memory that CONNECTION
+** may allocate on demand. Return the limit in effect after the call.
+*/
+static int test_db_config_lookaside_growth(
+  void * clientData,
+  Tcl_Interp *interp,
+  int objc,
+  Tcl_Obj *CONST objv[]
+){
+  int rc;
+  int nByte;
+  int nRes = 0;
+  sqlite3 *db;
+  int getDbPointer(Tcl_Interp*, const char*, sqlite3**);
+  if( objc!=3 ){
+    Tcl_WrongNumArgs(interp, 1, objv, "CONNECTION NBYTE");
+    return TCL_ERROR;
+  }
+  if( getDbPointer(interp, Tcl_GetString(objv[1]), &db) ) return TCL_ERROR;
+  if( Tcl_GetIntFromObj(interp, objv[2], &nByte) ) return TCL_ERROR;
+  rc = sqlite3_db_config(db, SQLITE_DBCONFIG_LOOKASIDE_GROWTH, nByte, &nRes);
+  if( rc!=SQLITE_OK ){
+    Tcl_SetResult(interp, (char *)sqlite3TestErrorName(rc), TCL_VOLATILE);
+    return TCL_ERROR;
+  }
+  Tcl_SetObjResult(interp, Tcl_NewIntObj(nRes));
+  return TCL_OK;
+}
+
 /*
 ** Usage:
 **
@@ -1203,6 +1235,93 @@ static int test_config_uri(
   return TCL_OK;
 }
 
+/*
+** tclcmd:     sqlite3_config_malloccache  NBYTE
+**
+** Invoke sqlite3_config(SQLITE_CONFIG_MALLOCCACHE, NBYTE). Return the
+** name of the result code.
+*/
+static int test_config_malloccache(
+  void * clientData, 
+  Tcl_Interp *interp,
+  int objc,
+  Tcl_Obj *CONST objv[]
+){
+  int rc;
+  int nByte;
+
+  if( objc!=2 ){
+    Tcl_WrongNumArgs(interp, 1, objv, "NBYTE");
+    return TCL_ERROR;
+  }
+  if( Tcl_GetIntFromObj(interp, objv[1], &nByte) ){
+    return TCL_ERROR;
+  }
+
+  rc = sqlite3_config(SQLITE_CONFIG_MALLOCCACHE, nByte);
+  Tcl_SetResult(interp, (char *)sqlite3TestErrorName(rc), TCL_VOLATILE);
+
+  return TCL_OK;
+}
+
+/*
+** tclcmd:     sqlite3_config_schemacache  NSCHEMA
+**
+** Invoke sqlite3_config(SQLITE_CONFIG_SCHEMACACHE, NSCHEMA). Return the
+** name of the result code.
+*/
+static int test_config_schemacache(
+  void * clientData, 
+  Tcl_Interp *interp,
+  int objc,
+  Tcl_Obj *CONST objv[]
+){
+  int rc;
+  int nSchema;
+
+  if( objc!=2 ){
+    Tcl_WrongNumArgs(interp, 1, objv, "NSCHEMA");
+    return TCL_ERROR;
+  }
+  if( Tcl_GetIntFromObj(interp, objv[1], &nSchema) ){
+    return TCL_ERROR;
+  }
+
+  rc = sqlite3_config(SQLITE_CONFIG_SCHEMACACHE, nSchema);
+  Tcl_SetResult(interp, (char *)sqlite3TestErrorName(rc), TCL_VOLATILE);
+
+  return TCL_OK;
+}
+
+/*
+** tclcmd:     sqlite3_config_lazyschema  BOOLEAN
+**
+** Invoke sqlite3_config(SQLITE_CONFIG_LAZYSCHEMA, BOOLEAN). Return the
+** name of the result code.
+*/
+static int test_config_lazyschema(
+  void * clientData, 
+  Tcl_Interp *interp,
+  int objc,
+  Tcl_Obj *CONST objv[]
+){
+  int rc;
+  int bLazy;
+
+  if( objc!=2 ){
+    Tcl_WrongNumArgs(interp, 1, objv, "BOOL");
+    return TCL_ERROR;
+  }
+  if( Tcl_GetBooleanFromObj(interp, objv[1], &bLazy) ){
+    return TCL_ERROR;
+  }
+
+  rc = sqlite3_config(SQLITE_CONFIG_LAZYSCHEMA, bLazy);
+  Tcl_SetResult(interp, (char *)sqlite3TestErrorName(rc), TCL_VOLATILE);
+
+  return TCL_OK;
+}
+
 /*
 ** Usage:    
 **
@@ -1325,7 +1444,12 @@ static int test_db_status(
     { "STMT_USED",           SQLITE_DBSTATUS_STMT_USED           },
     { "LOOKASIDE_HIT",       SQLITE_DBSTATUS_LOOKASIDE_HIT       },
     { "LOOKASIDE_MISS_SIZE", SQLITE_DBSTATUS_LOOKASIDE_MISS_SIZE },
-    { "LOOKASIDE_MISS_FULL", SQLITE_DBSTATUS_LOOKASIDE_MISS_FULL }
+    { "LOOKASIDE_MISS_FULL", SQLITE_DBSTATUS_LOOKASIDE_MISS_FULL },
+    { "SEEK_LOCAL",          SQLITE_DBSTATUS_SEEK_LOCAL          },
+    { "SEEK_ROOT",           SQLITE_DBSTATUS_SEEK_ROOT           },
+    { "LOOKASIDE_CLASS0",    SQLITE_DBSTATUS_LOOKASIDE_CLASS0    },
+    { "LOOKASIDE_CLASS1",    SQLITE_DBSTATUS_LOOKASIDE_CLASS1    },
+    { "LOOKASIDE_CLASS2",    SQLITE_DBSTATUS_LOOKASIDE_CLASS2    }
   };
   Tcl_Obj *pResult;
   if( objc!=4 ){
@@ -1452,7 +1576,12 @@ int Sqlitetest_malloc_Init(Tcl_Interp *interp){
      { "sqlite3_config_lookaside",   test_config_lookaside         ,0 },
      { "sqlite3_config_error",       test_config_error             ,0 },
      { "sqlite3_config_uri",         test_config_uri               ,0 },
+     { "sqlite3_config_malloccache", test_config_malloccache       ,0 },
+     { "sqlite3_config_schemacache", test_config_schemacache       ,0 },
+     { "sqlite3_config_lazyschema",  test_config_lazyschema        ,0 },
      { "sqlite3_db_config_lookaside",test_db_config_lookaside      ,0 },
+     { "sqlite3_db_config_lookaside_growth",
+                                   test_db_config_lookaside_growth ,0 },
      { "sqlite3_dump_memsys3",       test_dump_memsys3             ,3 },
      { "sqlite3_dump_memsys5",       test_dump_memsys3             ,5 },
      { "sqlite3_install_memsys3",    test_install_memsys3          ,0 },
@@ -1463,6 +1592,13 @@ int Sqlitetest_malloc_Init(Tcl_Interp *interp){
     ClientData c = (ClientData)SQLITE_INT_TO_PTR(aObjCmd[i].clientData);
     Tcl_CreateObjCommand(interp, aObjCmd[i].zName, aObjCmd[i].xProc, c, 0);
   }
+#ifdef SQLITE_ENABLE_MEMSYS6
+  {
+    extern int sqlite3_memsys6_backing_count;
+    Tcl_LinkVar(interp, "sqlite3_memsys6_backing_count",
+        (char*)&sqlite3_memsys6_backing_count, TCL_LINK_INT);
+  }
+#endif
   return TCL_OK;
 }
 #endif
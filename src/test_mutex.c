@@ -409,6 +409,159 @@ static int test_leave_db_mutex(
   return TCL_OK;
 }
 
+#if SQLITE_OS_UNIX && SQLITE_THREADSAFE
+#include <pthread.h>
+
+/*
+** State shared by the threads started by the [rwmutex_stress] command.
+*/
+static struct RwStress {
+  int nIter;                    /* Iterations run by each thread */
+  sqlite3_vfs aVfs[2];          /* VFS registered by each writer thread */
+  sqlite3_mutex *pMutex;        /* SQLITE_MUTEX_FAST mutex for nCount, nErr */
+  int nCount;                   /* Total iterations completed */
+  int nErr;                     /* Number of inconsistencies seen */
+} rws;
+
+/*
+** Automatic extension registered by the writer threads.
+*/
+static int rwStressAutoExt(
+  sqlite3 *db,
+  char **pzErrMsg,
+  const void *pApi
+){
+  UNUSED_PARAMETER2(db, pzErrMsg);
+  UNUSED_PARAMETER(pApi);
+  return SQLITE_OK;
+}
+
+/*
+** Record the end of one iteration of a thread, and whether or not it
+** found an inconsistency. The mutex is contended by all threads, so
+** this also exercises the mutex implementation.
+*/
+static void rwStressCount(int bErr){
+  sqlite3_mutex_enter(rws.pMutex);
+  rws.nCount++;
+  rws.nErr += bErr;
+  sqlite3_mutex_leave(rws.pMutex);
+}
+
+/*
+** A reader thread. Look up the default VFS and the VFSes of the writer
+** threads, and open a connection, which loads the automatic extensions.
+*/
+static void *rwStressReader(void *pArg){
+  int i;
+  for(i=0; i<rws.nIter; i++){
+    sqlite3_vfs *pVfs = &rws.aVfs[i%2];
+    sqlite3_vfs *pFound;
+    sqlite3 *db = 0;
+    int bErr = 0;
+
+    pFound = sqlite3_vfs_find(pVfs->zName);
+    if( pFound!=0 && pFound!=pVfs ) bErr = 1;
+    if( sqlite3_vfs_find(0)==0 ) bErr = 1;
+    if( sqlite3_open_v2(":memory:", &db, SQLITE_OPEN_READWRITE, 0) ){
+      bErr = 1;
+    }
+    sqlite3_close(db);
+    rwStressCount(bErr);
+  }
+  UNUSED_PARAMETER(pArg);
+  return 0;
+}
+
+/*
+** A writer thread. Register and unregister a VFS, and add and remove
+** the automatic extension.
+*/
+static void *rwStressWriter(void *pArg){
+  sqlite3_vfs *pVfs = (sqlite3_vfs*)pArg;
+  int i;
+  for(i=0; i<rws.nIter; i++){
+    int bErr = 0;
+    sqlite3_vfs_register(pVfs, 0);
+    if( sqlite3_vfs_find(pVfs->zName)!=pVfs ) bErr = 1;
+    sqlite3_auto_extension((void(*)(void))rwStressAutoExt);
+    sqlite3_vfs_unregister(pVfs);
+    if( sqlite3_vfs_find(pVfs->zName)!=0 ) bErr = 1;
+    sqlite3_reset_auto_extension();
+    rwStressCount(bErr);
+  }
+  return 0;
+}
+
+/*
+** Usage:  rwmutex_stress NREADER NITER
+**
+** Start NREADER reader threads and two writer threads, and have each
+** run NITER iterations. The readers look up VFSes and open connections
+** while the writers register and unregister a VFS and an automatic
+** extension. Return a list of two integers: the number of
+** inconsistencies seen and the total number of iterations completed.
+**
+** The list of automatic extensions is empty afterwards.
+*/
+static int test_rwmutex_stress(
+  void * clientData,
+  Tcl_Interp *interp,
+  int objc,
+  Tcl_Obj *CONST objv[]
+){
+  pthread_t aThread[32];
+  int nReader;
+  int nThread;
+  int i;
+  Tcl_Obj *pRet;
+
+  if( objc!=3 ){
+    Tcl_WrongNumArgs(interp, 1, objv, "NREADER NITER");
+    return TCL_ERROR;
+  }
+  if( Tcl_GetIntFromObj(interp, objv[1], &nReader)
+   || Tcl_GetIntFromObj(interp, objv[2], &rws.nIter)
+  ){
+    return TCL_ERROR;
+  }
+  if( nReader<1 || nReader>30 ){
+    Tcl_AppendResult(interp, "NREADER must be between 1 and 30", 0);
+    return TCL_ERROR;
+  }
+
+  for(i=0; i<2; i++){
+    rws.aVfs[i] = *sqlite3_vfs_find(0);
+    rws.aVfs[i].zName = (i==0 ? "rwstress0" : "rwstress1");
+  }
+  rws.pMutex = sqlite3_mutex_alloc(SQLITE_MUTEX_FAST);
+  rws.nCount = 0;
+  rws.nErr = 0;
+
+  nThread = 0;
+  for(i=0; i<nReader+2; i++){
+    void *(*xThread)(void*) = (i<2 ? rwStressWriter : rwStressReader);
+    void *pArg = (void*)&rws.aVfs[i%2];
+    if( pthread_create(&aThread[nThread], 0, xThread, pArg) ) break;
+    nThread++;
+  }
+  for(i=0; i<nThread; i++){
+    pthread_join(aThread[i], 0);
+  }
+  sqlite3_mutex_free(rws.pMutex);
+  if( nThread<nReader+2 ){
+    Tcl_AppendResult(interp, "pthread_create() failed", 0);
+    return TCL_ERROR;
+  }
+
+  pRet = Tcl_NewObj();
+  Tcl_ListObjAppendElement(interp, pRet, Tcl_NewIntObj(rws.nErr));
+  Tcl_ListObjAppendElement(interp, pRet, Tcl_NewIntObj(rws.nCount));
+  Tcl_SetObjResult(interp, pRet);
+  return TCL_OK;
+}
+#endif /* SQLITE_OS_UNIX && SQLITE_THREADSAFE */
+
 int Sqlitetest_mutex_Init(Tcl_Interp *interp){
   static struct {
     char *zName;
@@ -425,6 +578,9 @@ int Sqlitetest_mutex_Init(Tcl_Interp *interp){
     { "install_mutex_counters",  (Tcl_ObjCmdProc*)test_install_mutex_counters },
     { "read_mutex_counters",     (Tcl_ObjCmdProc*)test_read_mutex_counters },
     { "clear_mutex_counters",    (Tcl_ObjCmdProc*)test_clear_mutex_counters },
+#if SQLITE_OS_UNIX && SQLITE_THREADSAFE
+    { "rwmutex_stress",          (Tcl_ObjCmdProc*)test_rwmutex_stress },
+#endif
   };
   int i;
   for(i=0; i<sizeof(aCmd)/sizeof(aCmd[0]); i++){
@@ -435,5 +591,12 @@ int Sqlitetest_mutex_Init(Tcl_Interp *interp){
               (char*)&g.disableInit, TCL_LINK_INT);
   Tcl_LinkVar(interp, "disable_mutex_try", 
               (char*)&g.disableTry, TCL_LINK_INT);
+#ifdef SQLITE_MUTEX_PTHREADS
+  {
+    extern int sqlite3_mutex_spin_always;
+    Tcl_LinkVar(interp, "sqlite3_mutex_spin_always", 
+                (char*)&sqlite3_mutex_spin_always, TCL_LINK_INT);
+  }
+#endif
   return SQLITE_OK;
 }
@@ -546,7 +546,7 @@ static int tvfsOpen(
   if( p->pScript && p->mask&TESTVFS_OPEN_MASK ){
     Tcl_Obj *pArg = Tcl_NewObj();
     Tcl_IncrRefCount(pArg);
-    if( flags&SQLITE_OPEN_MAIN_DB ){
+    if( flags&(SQLITE_OPEN_MAIN_DB|SQLITE_OPEN_WAL) ){
       const char *z = &zName[strlen(zName)+1];
       while( *z ){
         Tcl_ListObjAppendElement(0, pArg, Tcl_NewStringObj(z, -1));
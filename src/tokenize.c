@@ -509,6 +509,10 @@ abort_parse:
   for(i=pParse->nzVar-1; i>=0; i--) sqlite3DbFree(db, pParse->azVar[i]);
   sqlite3DbFree(db, pParse->azVar);
   sqlite3DbFree(db, pParse->aAlias);
+  if( pParse->nested==0 ){
+    /* Free expressions held by the column cache */
+    sqlite3ExprCacheClear(pParse);
+  }
   while( pParse->pAinc ){
     AutoincInfo *p = pParse->pAinc;
     pParse->pAinc = p->pNext;
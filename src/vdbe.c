@@ -1353,72 +1353,78 @@ case OP_CollSeq: {
 ** sqlite3_set_auxdata() API may be safely retained until the next
 ** invocation of this opcode.
 **
+** The first time this opcode runs, the FuncDef in P4 is replaced by an
+** sqlite3_context object (P4_FUNCCTX) that is used by every subsequent
+** invocation.  It holds the function, its collating sequence, any
+** auxiliary data and an array of pointers to the argument registers, so
+** that none of these need to be set up again for each row.  The function
+** stores its result directly in register P3.
+**
 ** See also: AggStep and AggFinal
 */
 case OP_Function: {
   int i;
   Mem *pArg;
-  sqlite3_context ctx;
-  sqlite3_value **apVal;
+  sqlite3_context *pCtx;
   int n;
 
   n = pOp->p5;
-  apVal = p->apArg;
-  assert( apVal || n==0 );
   assert( pOp->p3>0 && pOp->p3<=p->nMem );
   pOut = &aMem[pOp->p3];
   memAboutToChange(p, pOut);
 
   assert( n==0 || (pOp->p2>0 && pOp->p2+n<=p->nMem+1) );
   assert( pOp->p3<pOp->p2 || pOp->p3>=pOp->p2+n );
+
+  assert( pOp->p4type==P4_FUNCDEF || pOp->p4type==P4_FUNCCTX );
+  if( pOp->p4type==P4_FUNCDEF ){
+    int nByte = sizeof(sqlite3_context) + (n>1 ? n-1 : 0)*sizeof(sqlite3_value*);
+    pCtx = (sqlite3_context *)sqlite3DbMallocZero(db, nByte);
+    if( pCtx==0 ) goto no_mem;
+    pCtx->pFunc = pOp->p4.pFunc;
+    pCtx->argc = n;
+    if( pCtx->pFunc->flags & SQLITE_FUNC_NEEDCOLL ){
+      assert( pOp>aOp );
+      assert( pOp[-1].p4type==P4_COLLSEQ );
+      assert( pOp[-1].opcode==OP_CollSeq );
+      pCtx->pColl = pOp[-1].p4.pColl;
+    }
+    pOp->p4type = P4_FUNCCTX;
+    pOp->p4.pCtx = pCtx;
+  }
+  pCtx = pOp->p4.pCtx;
+
+  /* The argument pointers are set up the first time the opcode runs, and
+  ** again if it runs in a different register file.  That happens when
+  ** the opcode is part of a trigger program invoked more than once. */
+  if( pCtx->pOut!=pOut ){
+    pCtx->pOut = pOut;
+    for(i=0; i<n; i++){
+      pCtx->argv[i] = &aMem[pOp->p2+i];
+    }
+  }
   pArg = &aMem[pOp->p2];
   for(i=0; i<n; i++, pArg++){
     assert( memIsValid(pArg) );
-    apVal[i] = pArg;
     Deephemeralize(pArg);
     sqlite3VdbeMemStoreType(pArg);
     REGISTER_TRACE(pOp->p2+i, pArg);
   }
 
-  assert( pOp->p4type==P4_FUNCDEF || pOp->p4type==P4_VDBEFUNC );
-  if( pOp->p4type==P4_FUNCDEF ){
-    ctx.pFunc = pOp->p4.pFunc;
-    ctx.pVdbeFunc = 0;
-  }else{
-    ctx.pVdbeFunc = (VdbeFunc*)pOp->p4.pVdbeFunc;
-    ctx.pFunc = ctx.pVdbeFunc->pFunc;
-  }
-
-  ctx.s.flags = MEM_Null;
-  ctx.s.db = db;
-  ctx.s.xDel = 0;
-  ctx.s.zMalloc = 0;
-
-  /* The output cell may already have a buffer allocated. Move
-  ** the pointer to ctx.s so in case the user-function can use
-  ** the already allocated buffer instead of allocating a new one.
+  /* The output cell may already have a buffer allocated, which the
+  ** function may reuse for its result.
   */
-  sqlite3VdbeMemMove(&ctx.s, pOut);
-  MemSetTypeFlag(&ctx.s, MEM_Null);
-
-  ctx.isError = 0;
-  if( ctx.pFunc->flags & SQLITE_FUNC_NEEDCOLL ){
-    assert( pOp>aOp );
-    assert( pOp[-1].p4type==P4_COLLSEQ );
-    assert( pOp[-1].opcode==OP_CollSeq );
-    ctx.pColl = pOp[-1].p4.pColl;
-  }
+  MemSetTypeFlag(pOut, MEM_Null);
+  pCtx->isError = 0;
   db->lastRowid = lastRowid;
-  (*ctx.pFunc->xFunc)(&ctx, n, apVal); /* IMP: R-24505-23230 */
+  (*pCtx->pFunc->xFunc)(pCtx, n, pCtx->argv); /* IMP: R-24505-23230 */
   lastRowid = db->lastRowid;
 
   /* If any auxiliary data functions have been called by this user function,
   ** immediately call the destructor for any non-static values.
   */
-  if( ctx.pVdbeFunc ){
-    sqlite3VdbeDeleteAuxData(ctx.pVdbeFunc, pOp->p1);
-    pOp->p4.pVdbeFunc = ctx.pVdbeFunc;
-    pOp->p4type = P4_VDBEFUNC;
+  if( pCtx->pVdbeFunc ){
+    sqlite3VdbeDeleteAuxData(pCtx->pVdbeFunc, pOp->p1);
   }
 
   if( db->mallocFailed ){
@@ -1427,19 +1433,17 @@ case OP_Function: {
     ** to return a value. The following call releases any resources
     ** associated with such a value.
     */
-    sqlite3VdbeMemRelease(&ctx.s);
+    sqlite3VdbeMemSetNull(pOut);
     goto no_mem;
   }
 
   /* If the function returned an error, throw an exception */
-  if( ctx.isError ){
-    sqlite3SetString(&p->zErrMsg, db, "%s", sqlite3_value_text(&ctx.s));
-    rc = ctx.isError;
+  if( pCtx->isError ){
+    sqlite3SetString(&p->zErrMsg, db, "%s", sqlite3_value_text(pOut));
+    rc = pCtx->isError;
   }
 
-  /* Copy the result of the function into register P3 */
-  sqlite3VdbeChangeEncoding(&ctx.s, encoding);
-  sqlite3VdbeMemMove(pOut, &ctx.s);
+  sqlite3VdbeChangeEncoding(pOut, encoding);
   if( sqlite3VdbeMemTooBig(pOut) ){
     goto too_big;
   }
@@ -2112,6 +2116,11 @@ case OP_NotNull: {            /* same as TK_NOTNULL, jump, in1 */
 ** then the cache of the cursor is reset prior to extracting the column.
 ** The first OP_Column against a pseudo-table after the value of the content
 ** register has changed should have this bit set.
+**
+** If the OPFLAG_REALAFFINITY bit is set on P5, then an integer value
+** extracted is converted to a real, as if by OP_RealAffinity.  This bit
+** is set by the peephole optimizer in place of an OP_RealAffinity that
+** follows the OP_Column.
 */
 case OP_Column: {
   u32 payloadSize;   /* Number of bytes in the record */
@@ -2400,6 +2409,9 @@ case OP_Column: {
   rc = sqlite3VdbeMemMakeWriteable(pDest);
 
 op_column_out:
+  if( (pOp->p5 & OPFLAG_REALAFFINITY)!=0 && (pDest->flags & MEM_Int)!=0 ){
+    sqlite3VdbeMemRealify(pDest);
+  }
   UPDATE_MAX_BLOBSIZE(pDest);
   REGISTER_TRACE(pOp->p3, pDest);
   break;
@@ -2750,13 +2762,15 @@ case OP_Savepoint: {
   break;
 }
 
-/* Opcode: AutoCommit P1 P2 * * *
+/* Opcode: AutoCommit P1 P2 P3 * *
 **
 ** Set the database auto-commit flag to P1 (1 or 0). If P2 is true, roll
 ** back any currently active btree transactions. If there are any active
 ** VMs (apart from this one), then a ROLLBACK fails.  A COMMIT fails if
 ** there are active writing VMs or active VMs that use shared cache.
 **
+** If P1 is 0 (BEGIN), then P3 is true for a BEGIN CONCURRENT transaction.
+**
 ** This instruction causes the VM to halt.
 */
 case OP_AutoCommit: {
@@ -2795,6 +2809,9 @@ case OP_AutoCommit: {
       goto vdbe_return;
     }else{
       db->autoCommit = (u8)desiredAutoCommit;
+      if( desiredAutoCommit==0 ){
+        db->isConcurrent = (u8)pOp->p3;
+      }
       if( sqlite3VdbeHalt(p)==SQLITE_BUSY ){
         p->pc = pc;
         db->autoCommit = (u8)(1-desiredAutoCommit);
@@ -3288,7 +3305,7 @@ case OP_Close: {
   break;
 }
 
-/* Opcode: SeekGe P1 P2 P3 P4 *
+/* Opcode: SeekGe P1 P2 P3 P4 P5
 **
 ** If cursor P1 refers to an SQL table (B-Tree that uses integer keys), 
 ** use the value in register P3 as the key.  If cursor P1 refers 
@@ -3299,9 +3316,15 @@ case OP_Close: {
 ** is greater than or equal to the key value. If there are no records 
 ** greater than or equal to the key and P2 is not zero, then jump to P2.
 **
+** If P1 is an index cursor and the OPFLAG_SEEKSCAN bit of P5 is set, then
+** the keys passed to successive invocations of this opcode are likely to
+** be in ascending order. In this case, try to find the target entry by 
+** moving forward from the current position of the cursor before 
+** seeking from the root of the b-tree.
+**
 ** See also: Found, NotFound, Distinct, SeekLt, SeekGt, SeekLe
 */
-/* Opcode: SeekGt P1 P2 P3 P4 *
+/* Opcode: SeekGt P1 P2 P3 P4 P5
 **
 ** If cursor P1 refers to an SQL table (B-Tree that uses integer keys), 
 ** use the value in register P3 as a key. If cursor P1 refers 
@@ -3312,6 +3335,8 @@ case OP_Close: {
 ** is greater than the key value. If there are no records greater than 
 ** the key and P2 is not zero, then jump to P2.
 **
+** The OPFLAG_SEEKSCAN bit of P5 has the same meaning as for OP_SeekGe.
+**
 ** See also: Found, NotFound, Distinct, SeekLt, SeekGe, SeekLe
 */
 /* Opcode: SeekLt P1 P2 P3 P4 * 
@@ -3446,9 +3471,23 @@ case OP_SeekGt: {       /* jump, in3 */
       { int i; for(i=0; i<r.nField; i++) assert( memIsValid(&r.aMem[i]) ); }
 #endif
       ExpandBlob(r.aMem);
-      rc = sqlite3BtreeMovetoUnpacked(pC->pCursor, &r, 0, 0, &res);
-      if( rc!=SQLITE_OK ){
-        goto abort_due_to_error;
+
+      /* If sqlite3BtreeSeekForward() finds the target entry it sets res
+      ** to 1. The cursor then already points to the smallest entry that
+      ** is greater than (or equal to) the key, and the sqlite3BtreeNext()
+      ** call below is skipped. */
+      res = 0;
+      if( (pOp->p5 & OPFLAG_SEEKSCAN)!=0 && oc>=OP_SeekGe ){
+        rc = sqlite3BtreeSeekForward(pC->pCursor, &r, &res);
+        if( rc!=SQLITE_OK ){
+          goto abort_due_to_error;
+        }
+      }
+      if( res==0 ){
+        rc = sqlite3BtreeMovetoUnpacked(pC->pCursor, &r, 0, 0, &res);
+        if( rc!=SQLITE_OK ){
+          goto abort_due_to_error;
+        }
       }
       pC->rowidIsValid = 0;
     }
@@ -4810,6 +4849,7 @@ case OP_ParseSchema: {
     initData.db = db;
     initData.iDb = pOp->p1;
     initData.pzErrMsg = &p->zErrMsg;
+    initData.bLazy = 0;
     zSql = sqlite3MPrintf(db,
        "SELECT name, rootpage, sql FROM '%q'.%s WHERE %s ORDER BY rowid",
        db->aDb[iDb].zName, zMaster, pOp->p4.z);
@@ -5320,6 +5360,7 @@ case OP_AggStep: {
   Mem *pRec;
   sqlite3_context ctx;
   sqlite3_value **apVal;
+  Mem t;
 
   n = pOp->p5;
   assert( n>=0 );
@@ -5336,11 +5377,12 @@ case OP_AggStep: {
   assert( pOp->p3>0 && pOp->p3<=p->nMem );
   ctx.pMem = pMem = &aMem[pOp->p3];
   pMem->n++;
-  ctx.s.flags = MEM_Null;
-  ctx.s.z = 0;
-  ctx.s.zMalloc = 0;
-  ctx.s.xDel = 0;
-  ctx.s.db = db;
+  t.flags = MEM_Null;
+  t.z = 0;
+  t.zMalloc = 0;
+  t.xDel = 0;
+  t.db = db;
+  ctx.pOut = &t;
   ctx.isError = 0;
   ctx.pColl = 0;
   if( ctx.pFunc->flags & SQLITE_FUNC_NEEDCOLL ){
@@ -5351,11 +5393,11 @@ case OP_AggStep: {
   }
   (ctx.pFunc->xStep)(&ctx, n, apVal); /* IMP: R-24505-23230 */
   if( ctx.isError ){
-    sqlite3SetString(&p->zErrMsg, db, "%s", sqlite3_value_text(&ctx.s));
+    sqlite3SetString(&p->zErrMsg, db, "%s", sqlite3_value_text(&t));
     rc = ctx.isError;
   }
 
-  sqlite3VdbeMemRelease(&ctx.s);
+  sqlite3VdbeMemRelease(&t);
 
   break;
 }
@@ -5796,13 +5838,11 @@ case OP_VColumn: {
   assert( pModule->xColumn );
   memset(&sContext, 0, sizeof(sContext));
 
-  /* The output cell may already have a buffer allocated. Move
-  ** the current contents to sContext.s so in case the user-function 
-  ** can use the already allocated buffer instead of allocating a 
-  ** new one.
+  /* The result is written directly into the P3 register, so that the
+  ** xColumn method may use any buffer already allocated there.
   */
-  sqlite3VdbeMemMove(&sContext.s, pDest);
-  MemSetTypeFlag(&sContext.s, MEM_Null);
+  sContext.pOut = pDest;
+  MemSetTypeFlag(pDest, MEM_Null);
 
   rc = pModule->xColumn(pCur->pVtabCursor, &sContext, pOp->p2);
   importVtabErrMsg(p, pVtab);
@@ -5810,12 +5850,7 @@ case OP_VColumn: {
     rc = sContext.isError;
   }
 
-  /* Copy the result of the function to the P3 register. We
-  ** do this regardless of whether or not an error occurred to ensure any
-  ** dynamic allocation in sContext.s (a Mem struct) is  released.
-  */
-  sqlite3VdbeChangeEncoding(&sContext.s, encoding);
-  sqlite3VdbeMemMove(pDest, &sContext.s);
+  sqlite3VdbeChangeEncoding(pDest, encoding);
   REGISTER_TRACE(pOp->p3, pDest);
   UPDATE_MAX_BLOBSIZE(pDest);
 
@@ -249,10 +249,12 @@ struct VdbeFunc {
 struct sqlite3_context {
   FuncDef *pFunc;       /* Pointer to function information.  MUST BE FIRST */
   VdbeFunc *pVdbeFunc;  /* Auxilary data, if created. */
-  Mem s;                /* The return value is stored here */
+  Mem *pOut;            /* The return value is stored here */
   Mem *pMem;            /* Memory cell used to store aggregate context */
   int isError;          /* Error code returned by the function. */
   CollSeq *pColl;       /* Collating sequence */
+  int argc;             /* Number of entries in argv[] */
+  sqlite3_value *argv[1];  /* Arguments. Used only by OP_Function */
 };
 
 /*
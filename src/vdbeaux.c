@@ -452,6 +452,176 @@ static void resolveP2Values(Vdbe *p, int *pMaxFuncArgs){
   *pMaxFuncArgs = nMaxArgs;
 }
 
+/*
+** Return true if the P2 operand of instruction pOp is a jump destination.
+** The comparison opcodes use P2 as a register instead if the
+** SQLITE_STOREP2 flag is set.
+*/
+static int isJumpP2(Op *pOp){
+  if( (pOp->opflags & OPFLG_JUMP)==0 ) return 0;
+  switch( pOp->opcode ){
+    case OP_Eq: case OP_Ne: case OP_Lt: case OP_Le: case OP_Gt: case OP_Ge:
+      return (pOp->p5 & SQLITE_STOREP2)==0;
+  }
+  return 1;
+}
+
+/*
+** Return the address that a jump to address iAddr of program aOp[] may
+** be redirected to.  If the instruction at iAddr is an OP_Goto that jumps
+** forward, the jump is redirected to the destination of the OP_Goto, and
+** so on.  Backward OP_Goto instructions are not bypassed, as each loop
+** must continue to pass through its CHECK_FOR_INTERRUPT.
+*/
+static int threadJump(Op *aOp, int nOp, int iAddr){
+  while( iAddr>0 && iAddr<nOp
+      && aOp[iAddr].opcode==OP_Goto && aOp[iAddr].p2>iAddr
+  ){
+    iAddr = aOp[iAddr].p2;
+  }
+  return iAddr;
+}
+
+/*
+** Return true if instruction pOp loads an address into a register used
+** by OP_Yield or OP_Return.  aAddrReg[] flags the registers so used.
+*/
+static int isAddrLoad(Op *pOp, u8 *aAddrReg, int mxReg){
+  return pOp->opcode==OP_Integer && pOp->p2<=mxReg && aAddrReg[pOp->p2];
+}
+
+static void freeP4(sqlite3*, int, void*);
+
+/*
+** Change instruction pOp to an OP_Noop.
+*/
+static void changeToNoop(sqlite3 *db, Op *pOp){
+  freeP4(db, pOp->p4type, pOp->p4.p);
+#ifdef SQLITE_DEBUG
+  sqlite3DbFree(db, pOp->zComment);
+#endif
+  memset(pOp, 0, sizeof(pOp[0]));
+  pOp->opcode = OP_Noop;
+}
+
+/*
+** This routine is called once the jump destinations of program p have
+** been resolved, to make simple improvements to the program that are
+** awkward to make while it is being generated:
+**
+**   *  Jumps to a forward OP_Goto are redirected to its destination.
+**
+**   *  An OP_RealAffinity that follows an OP_Column on the same register
+**      is folded into the OP_Column, by setting OPFLAG_REALAFFINITY.
+**      This is the pattern coded for every read of a REAL column.
+**
+**   *  OP_Noop instructions, and OP_Goto instructions that jump to the
+**      very next instruction, are removed from the program.
+**
+** Addresses are also stored in registers, by the OP_Integer instructions
+** that set the initial resume address of a coroutine (for OP_Yield) or
+** the return address of a subroutine that is entered by falling into it
+** (for OP_Return).  Execution resumes at the instruction after the
+** address stored.  These OP_Integer instructions are recognized by their
+** P2 register, which is also the P1 register of an OP_Yield or OP_Return,
+** and their P1 values are adjusted along with the jump destinations.
+**
+** If a malloc fails, the program is left as it is.
+*/
+static void optimizeProgram(Vdbe *p){
+  sqlite3 *db = p->db;
+  Op *aOp = p->aOp;
+  int nOp = p->nOp;
+  Op *pOp;
+  int *aMap;           /* Jump destination flags, then new addresses */
+  u8 *aAddrReg;        /* aAddrReg[i] is true if register i holds addresses */
+  int mxReg = 0;       /* Largest register used by OP_Yield or OP_Return */
+  int i, j;
+
+  for(pOp=aOp; pOp<&aOp[nOp]; pOp++){
+    if( (pOp->opcode==OP_Yield || pOp->opcode==OP_Return) && pOp->p1>mxReg ){
+      mxReg = pOp->p1;
+    }
+  }
+  aMap = sqlite3DbMallocZero(db, sizeof(int)*(nOp+1) + mxReg+1);
+  if( aMap==0 ) return;
+  aAddrReg = (u8*)&aMap[nOp+1];
+  for(pOp=aOp; pOp<&aOp[nOp]; pOp++){
+    if( pOp->opcode==OP_Yield || pOp->opcode==OP_Return ){
+      aAddrReg[pOp->p1] = 1;
+    }
+  }
+
+  /* Redirect jumps, and mark each instruction that may be jumped to. */
+  for(pOp=aOp; pOp<&aOp[nOp]; pOp++){
+    if( isJumpP2(pOp) ){
+      pOp->p2 = threadJump(aOp, nOp, pOp->p2);
+      assert( pOp->p2>=0 && pOp->p2<=nOp );
+      aMap[pOp->p2] = 1;
+      if( pOp->opcode==OP_Jump ){
+        pOp->p1 = threadJump(aOp, nOp, pOp->p1);
+        pOp->p3 = threadJump(aOp, nOp, pOp->p3);
+        aMap[pOp->p1] = aMap[pOp->p3] = 1;
+      }
+    }else if( isAddrLoad(pOp, aAddrReg, mxReg) ){
+      assert( pOp->p1>=0 && pOp->p1<nOp );
+      aMap[pOp->p1+1] = 1;
+    }
+  }
+
+  /* Fold OP_RealAffinity into the preceding OP_Column. */
+  for(i=1; i<nOp; i++){
+    pOp = &aOp[i];
+    if( pOp->opcode==OP_RealAffinity && aMap[i]==0
+     && pOp[-1].opcode==OP_Column && pOp[-1].p3==pOp->p1
+    ){
+      pOp[-1].p5 |= OPFLAG_REALAFFINITY;
+      changeToNoop(db, pOp);
+    }
+  }
+
+  /* Remove unneeded instructions.  aMap[i] is set to the new address of
+  ** instruction i, or of the instruction that follows it if it is removed.
+  ** The first instruction, which sqlite3VdbeExpandSql() and others
+  ** expect to find the OP_Trace in, is never removed.  Neither are
+  ** OP_Noop instructions that carry a comment in debugging builds, as
+  ** they make EXPLAIN output easier to follow.  */
+  for(i=j=0; i<nOp; i++){
+    pOp = &aOp[i];
+    aMap[i] = j;
+    if( i==0
+     || (pOp->opcode!=OP_Noop && (pOp->opcode!=OP_Goto || pOp->p2!=i+1))
+#ifdef SQLITE_DEBUG
+     || (pOp->opcode==OP_Noop && pOp->zComment)
+#endif
+    ){
+      j++;
+    }
+  }
+  aMap[nOp] = j;
+  if( j<nOp ){
+    for(i=0; i<nOp; i++){
+      pOp = &aOp[i];
+      if( aMap[i]==aMap[i+1] ){
+        changeToNoop(db, pOp);
+        continue;
+      }
+      if( isJumpP2(pOp) ){
+        pOp->p2 = aMap[pOp->p2];
+        if( pOp->opcode==OP_Jump ){
+          pOp->p1 = aMap[pOp->p1];
+          pOp->p3 = aMap[pOp->p3];
+        }
+      }else if( isAddrLoad(pOp, aAddrReg, mxReg) ){
+        pOp->p1 = aMap[pOp->p1+1] - 1;
+      }
+      aOp[aMap[i]] = *pOp;
+    }
+    p->nOp = j;
+  }
+  sqlite3DbFree(db, aMap);
+}
+
 /*
 ** Return the address of the next instruction to be inserted.
 */
@@ -479,6 +649,7 @@ VdbeOp *sqlite3VdbeTakeOpArray(Vdbe *p, int *pnOp, int *pnMaxArg){
   assert( p->btreeMask==0 );
 
   resolveP2Values(p, pnMaxArg);
+  optimizeProgram(p);
   *pnOp = p->nOp;
   p->aOp = 0;
   return aOp;
@@ -612,11 +783,14 @@ static void freeP4(sqlite3 *db, int p4type, void *p4){
         if( db->pnBytesFreed==0 ) sqlite3_free(p4);
         break;
       }
-      case P4_VDBEFUNC: {
-        VdbeFunc *pVdbeFunc = (VdbeFunc *)p4;
-        freeEphemeralFunction(db, pVdbeFunc->pFunc);
-        if( db->pnBytesFreed==0 ) sqlite3VdbeDeleteAuxData(pVdbeFunc, 0);
-        sqlite3DbFree(db, pVdbeFunc);
+      case P4_FUNCCTX: {
+        sqlite3_context *pCtx = (sqlite3_context *)p4;
+        freeEphemeralFunction(db, pCtx->pFunc);
+        if( pCtx->pVdbeFunc ){
+          if( db->pnBytesFreed==0 ) sqlite3VdbeDeleteAuxData(pCtx->pVdbeFunc, 0);
+          sqlite3DbFree(db, pCtx->pVdbeFunc);
+        }
+        sqlite3DbFree(db, pCtx);
         break;
       }
       case P4_FUNCDEF: {
@@ -900,6 +1074,11 @@ static char *displayP4(Op *pOp, char *zTemp, int nTemp){
       sqlite3_snprintf(nTemp, zTemp, "%s(%d)", pDef->zName, pDef->nArg);
       break;
     }
+    case P4_FUNCCTX: {
+      FuncDef *pDef = pOp->p4.pCtx->pFunc;
+      sqlite3_snprintf(nTemp, zTemp, "%s(%d)", pDef->zName, pDef->nArg);
+      break;
+    }
     case P4_INT64: {
       sqlite3_snprintf(nTemp, zTemp, "%lld", *pOp->p4.pI64);
       break;
@@ -1495,13 +1674,15 @@ void sqlite3VdbeMakeReady(
   */
   nMem += nCursor;
 
+  resolveP2Values(p, &nArg);
+  optimizeProgram(p);
+
   /* Allocate space for memory registers, SQL variables, VDBE cursors and 
   ** an array to marshal SQL function arguments in.
   */
   zCsr = (u8*)&p->aOp[p->nOp];       /* Memory avaliable for allocation */
   zEnd = (u8*)&p->aOp[p->nOpAlloc];  /* First byte past end of zCsr[] */
 
-  resolveP2Values(p, &nArg);
   p->usesStmtJournal = (u8)(pParse->isMultiWrite && pParse->mayAbort);
   if( pParse->explain && nMem<10 ){
     nMem = 10;
@@ -1767,6 +1948,23 @@ static int vdbeCommit(sqlite3 *db, Vdbe *p){
     return rc;
   }
 
+  /* Obtain the WAL write lock for each database written by a BEGIN
+  ** CONCURRENT transaction and check each for conflicts, before any of
+  ** them is committed. If this fails for any database, release the locks
+  ** already obtained for the others. Either the transaction is rolled 
+  ** back (SQLITE_BUSY_SNAPSHOT), or the COMMIT may be retried later 
+  ** (SQLITE_BUSY) and should not block other writers in the meantime.
+  */
+  for(i=0; rc==SQLITE_OK && i<db->nDb; i++){
+    rc = sqlite3BtreeLockForCommit(db->aDb[i].pBt);
+  }
+  if( rc!=SQLITE_OK ){
+    for(i=0; i<db->nDb; i++){
+      sqlite3BtreeUnlockForCommit(db->aDb[i].pBt);
+    }
+    return rc;
+  }
+
   /* If there are any write-transactions at all, invoke the commit hook */
   if( needXcommit && db->xCommitCallback ){
     rc = db->xCommitCallback(db->pCommitArg);
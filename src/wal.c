@@ -403,6 +403,70 @@ struct WalCkptInfo {
   WAL_HDRSIZE + ((iFrame)-1)*(i64)((szPage)+WAL_FRAME_HDRSIZE)         \
 )
 
+/*
+** When a transaction that is to be synced writes more than this many
+** frames to the WAL file, the VFS is asked to start writing back each
+** group of this many frames as soon as it has been written (see
+** SQLITE_FCNTL_WRITEBACK). This leaves less data to be written by the 
+** sync at the end of the transaction. Zero disables the hint.
+*/
+#ifndef SQLITE_WAL_WRITEBACK
+# define SQLITE_WAL_WRITEBACK 64
+#endif
+
+/*
+** The following variable counts the SQLITE_FCNTL_WRITEBACK hints accepted
+** by the VFS. It is used for testing only.
+*/
+#ifdef SQLITE_TEST
+int sqlite3_wal_writeback_count = 0;
+#endif
+
+/*
+** Once the part of the WAL visible to a reader spans more than this many
+** wal-index hash tables, sqlite3WalRead() stops searching the older hash
+** tables one at a time. Instead, it builds a private WalMap (see below)
+** of all but the last of them and searches that. Zero disables the map.
+*/
+#ifndef SQLITE_WAL_MAP_NSEG
+# define SQLITE_WAL_MAP_NSEG 4
+#endif
+
+/*
+** The following variable counts the wal-index hash tables searched by
+** sqlite3WalRead(). It is used for testing only.
+*/
+#ifdef SQLITE_TEST
+int sqlite3_wal_hash_probe_count = 0;
+#endif
+
+/*
+** A WalMap is a summary of the first nSeg hash tables of the wal-index,
+** held in private heap memory by a single connection. It maps each page
+** number that appears in frames 1 to mxFrame of the WAL to the last of
+** those frames that contains the page.
+**
+** Each hash table other than the last one visible to a reader is full.
+** Its content does not change until the WAL is restarted, which changes
+** the salt values in the wal-index header. Or until a rollback by this
+** connection removes uncommitted frames (see walCleanupHash()). So the
+** map remains valid as long as the salt values match and the reader can
+** see all of frames 1 to mxFrame.
+**
+** Array aSlot[] is an open-addressing hash table of nSlot entries, each
+** of which is a pair of u32 values: the page number (or 0 for an unused
+** slot) followed by the frame number.
+*/
+typedef struct WalMap WalMap;
+struct WalMap {
+  u32 aSalt[2];              /* Salt values of WAL summarized by this map */
+  int nSeg;                  /* Hash tables 0 to nSeg-1 are in the map */
+  u32 mxFrame;               /* Last frame of hash table nSeg-1 */
+  int nSlot;                 /* Number of slots in aSlot[] (a power of 2) */
+  int nEntry;                /* Number of used slots in aSlot[] */
+  u32 *aSlot;                /* Hash table of (page number, frame) pairs */
+};
+
 /*
 ** An open write-ahead log file is represented by an instance of the
 ** following object.
@@ -413,6 +477,8 @@ struct Wal {
   sqlite3_file *pWalFd;      /* File handle for WAL file */
   u32 iCallback;             /* Value to pass to log callback (or 0) */
   i64 mxWalSize;             /* Truncate WAL to this size upon reset */
+  int szChunk;               /* Allocate WAL file in chunks of this size */
+  i64 szAlloc;               /* WAL file is allocated up to this offset */
   int nWiData;               /* Size of array apWiData */
   volatile u32 **apWiData;   /* Pointer to wal-index content in memory */
   u32 szPage;                /* Database page size */
@@ -424,6 +490,8 @@ struct Wal {
   WalIndexHdr hdr;           /* Wal-index header for current transaction */
   const char *zWalName;      /* Name of WAL file */
   u32 nCkpt;                 /* Checkpoint sequence counter in the wal-header */
+  WalMap map;                /* Summary of older hash tables for readers */
+  WalIndexHdr *pSnapshot;    /* Snapshot to open, or NULL for the latest */
 #ifdef SQLITE_DEBUG
   u8 lockError;              /* True if a locking error has occurred */
 #endif
@@ -888,6 +956,123 @@ static u32 walFramePgno(Wal *pWal, u32 iFrame){
   return pWal->apWiData[iHash][(iFrame-1-HASHTABLE_NPAGE_ONE)%HASHTABLE_NPAGE];
 }
 
+/*
+** Free the memory used by a WalMap and reset it to empty.
+*/
+static void walMapClear(WalMap *p){
+  sqlite3_free(p->aSlot);
+  memset(p, 0, sizeof(WalMap));
+}
+
+/*
+** Return the index of the slot in hash table aSlot[] (of nSlot entries)
+** that contains page number pgno. Or, if there is no such slot, of the
+** unused slot at which it would be inserted.
+*/
+static int walMapSlot(u32 *aSlot, int nSlot, u32 pgno){
+  int i;
+  for(i=(pgno*HASHTABLE_HASH_1) & (nSlot-1); 
+      aSlot[i*2] && aSlot[i*2]!=pgno; 
+      i=(i+1) & (nSlot-1)
+  );
+  return i;
+}
+
+/*
+** Record that frame iFrame is the last frame in the map that contains
+** page pgno. Return SQLITE_OK if successful, or SQLITE_NOMEM if the hash
+** table needs to be enlarged and the allocation fails.
+*/
+static int walMapInsert(WalMap *p, u32 pgno, u32 iFrame){
+  int i;
+  if( (p->nEntry+1)*2>p->nSlot ){
+    int nNew = p->nSlot ? p->nSlot*2 : HASHTABLE_NSLOT;
+    u32 *aNew = (u32 *)sqlite3MallocZero(nNew*2*sizeof(u32));
+    if( aNew==0 ) return SQLITE_NOMEM;
+    for(i=0; i<p->nSlot; i++){
+      if( p->aSlot[i*2] ){
+        int iNew = walMapSlot(aNew, nNew, p->aSlot[i*2]);
+        aNew[iNew*2] = p->aSlot[i*2];
+        aNew[iNew*2+1] = p->aSlot[i*2+1];
+      }
+    }
+    sqlite3_free(p->aSlot);
+    p->aSlot = aNew;
+    p->nSlot = nNew;
+  }
+  i = walMapSlot(p->aSlot, p->nSlot, pgno);
+  if( p->aSlot[i*2]==0 ){
+    p->aSlot[i*2] = pgno;
+    p->nEntry++;
+  }
+  p->aSlot[i*2+1] = iFrame;
+  return SQLITE_OK;
+}
+
+/*
+** Return the last frame in the map that contains page pgno, or 0 if the
+** page does not appear in the map.
+*/
+static u32 walMapLookup(WalMap *p, u32 pgno){
+  int i;
+  if( p->nSlot==0 ) return 0;
+  i = walMapSlot(p->aSlot, p->nSlot, pgno);
+  return p->aSlot[i*2+1];
+}
+
+/*
+** This function is called by sqlite3WalRead() before it searches for a
+** page in a WAL of which frames 1 to iLast are visible. It discards the
+** map if it does not describe the same WAL. Then, if searching the hash
+** tables not covered by the map would mean more than SQLITE_WAL_MAP_NSEG
+** probes, it adds all hash tables except the last one to the map.
+**
+** Failure to allocate memory for the map is not an error. The map is 
+** discarded and the hash tables are searched as usual. Any other error 
+** code is returned to the caller.
+*/
+static int walMapUpdate(Wal *pWal, u32 iLast){
+  WalMap *p = &pWal->map;
+  int rc = SQLITE_OK;
+
+  if( p->nSeg>0 && (p->mxFrame>iLast 
+   || memcmp(p->aSalt, pWal->hdr.aSalt, sizeof(p->aSalt)))
+  ){
+    walMapClear(p);
+  }
+
+  if( SQLITE_WAL_MAP_NSEG>0 
+   && walFramePage(iLast)+1-p->nSeg>SQLITE_WAL_MAP_NSEG 
+  ){
+    memcpy(p->aSalt, pWal->hdr.aSalt, sizeof(p->aSalt));
+    sqlite3BeginBenignMalloc();
+    while( rc==SQLITE_OK && p->nSeg<walFramePage(iLast) ){
+      volatile ht_slot *aHash;    /* Hash table (unused) */
+      volatile u32 *aPgno;        /* Page numbers of hash table p->nSeg */
+      u32 iZero;                  /* Frame number of aPgno[0] */
+      int nFrame;                 /* Number of frames in hash table */
+      int i;
+
+      rc = walHashGet(pWal, p->nSeg, &aHash, &aPgno, &iZero);
+      nFrame = (p->nSeg==0 ? HASHTABLE_NPAGE_ONE : HASHTABLE_NPAGE);
+      for(i=1; rc==SQLITE_OK && i<=nFrame; i++){
+        u32 pgno = aPgno[i];
+        if( pgno ) rc = walMapInsert(p, pgno, iZero+i);
+      }
+      if( rc==SQLITE_OK ){
+        p->nSeg++;
+        p->mxFrame = iZero + nFrame;
+      }
+    }
+    sqlite3EndBenignMalloc();
+    if( rc!=SQLITE_OK ){
+      walMapClear(p);
+      if( rc==SQLITE_NOMEM ) rc = SQLITE_OK;
+    }
+  }
+  return rc;
+}
+
 /*
 ** Remove entries from the hash table that point to WAL slots greater
 ** than pWal->hdr.mxFrame.
@@ -913,6 +1098,12 @@ static void walCleanupHash(Wal *pWal){
   testcase( pWal->hdr.mxFrame==HASHTABLE_NPAGE_ONE );
   testcase( pWal->hdr.mxFrame==HASHTABLE_NPAGE_ONE+1 );
 
+  /* If the private map of older hash tables includes any of the frames
+  ** just removed, it is no longer valid.  */
+  if( pWal->map.mxFrame>pWal->hdr.mxFrame ){
+    walMapClear(&pWal->map);
+  }
+
   if( pWal->hdr.mxFrame==0 ) return;
 
   /* Obtain pointers to the hash-table and page-number array containing 
@@ -1308,6 +1499,22 @@ void sqlite3WalLimit(Wal *pWal, i64 iLimit){
   if( pWal ) pWal->mxWalSize = iLimit;
 }
 
+/*
+** Set the size of the chunks in which the WAL file is allocated. Before
+** frames are appended past the allocated end of the file, it is extended
+** by one or more chunks of this size using SQLITE_FCNTL_SIZE_HINT. Once
+** allocated, the space is reused after each WAL reset, so that a steady
+** stream of transactions does not allocate file-system space. Zero means
+** the file grows as frames are written.
+*/
+void sqlite3WalChunkSize(Wal *pWal, int szChunk){
+  if( pWal ){
+    pWal->szChunk = (szChunk>0 ? szChunk : 0);
+    pWal->szAlloc = 0;
+    sqlite3OsFileControl(pWal->pWalFd, SQLITE_FCNTL_CHUNK_SIZE, &szChunk);
+  }
+}
+
 /*
 ** Find the smallest page number out of all pages held in the WAL that
 ** has not been returned by any prior invocation of this method on the
@@ -1701,6 +1908,7 @@ static int walCheckpoint(
   ){
     i64 nSize;                    /* Current size of database file */
     u32 nBackfill = pInfo->nBackfill;
+    int bBatch = 0;               /* True if db file writes are batched */
 
     /* Sync the WAL to disk */
     if( sync_flags ){
@@ -1718,6 +1926,12 @@ static int walCheckpoint(
       }
     }
 
+    /* Allow the VFS to batch the writes to the db file. */
+    if( rc==SQLITE_OK ){
+      bBatch = SQLITE_OK==
+          sqlite3OsFileControl(pWal->pDbFd, SQLITE_FCNTL_BEGIN_BATCH, 0);
+    }
+
     /* Iterate through the contents of the WAL, copying data to the db file. */
     while( rc==SQLITE_OK && 0==walIteratorNext(pIter, &iDbpage, &iFrame) ){
       i64 iOffset;
@@ -1732,6 +1946,10 @@ static int walCheckpoint(
       rc = sqlite3OsWrite(pWal->pDbFd, zBuf, szPage, iOffset);
       if( rc!=SQLITE_OK ) break;
     }
+    if( bBatch ){
+      int rc2 = sqlite3OsFileControl(pWal->pDbFd, SQLITE_FCNTL_END_BATCH, 0);
+      if( rc==SQLITE_OK ) rc = rc2;
+    }
 
     /* If work was actually accomplished... */
     if( rc==SQLITE_OK ){
@@ -1823,6 +2041,7 @@ int sqlite3WalClose(
       sqlite3OsDelete(pWal->pVfs, pWal->zWalName, 0);
     }
     WALTRACE(("WAL%p: closed\n", pWal));
+    walMapClear(&pWal->map);
     sqlite3_free((void *)pWal->apWiData);
     sqlite3_free(pWal);
   }
@@ -2027,6 +2246,7 @@ static int walTryBeginRead(Wal *pWal, int *pChanged, int useWal, int cnt){
   int mxI;                        /* Index of largest aReadMark[] value */
   int i;                          /* Loop counter */
   int rc = SQLITE_OK;             /* Return code  */
+  u32 mxFrame;                    /* Largest usable aReadMark[] value */
 
   assert( pWal->readLock<0 );     /* Not currently locked */
 
@@ -2089,8 +2309,19 @@ static int walTryBeginRead(Wal *pWal, int *pChanged, int useWal, int cnt){
     }
   }
 
+  /* If a snapshot is to be opened (see sqlite3WalSnapshotOpen()), the
+  ** read-lock must be on an aReadMark[] value no greater than the 
+  ** snapshot's mxFrame. And the WAL may only be ignored if it is empty.
+  */
+  mxFrame = pWal->hdr.mxFrame;
+  if( pWal->pSnapshot && pWal->pSnapshot->mxFrame<mxFrame ){
+    mxFrame = pWal->pSnapshot->mxFrame;
+  }
+
   pInfo = walCkptInfo(pWal);
-  if( !useWal && pInfo->nBackfill==pWal->hdr.mxFrame ){
+  if( !useWal && pInfo->nBackfill==pWal->hdr.mxFrame
+   && (pWal->pSnapshot==0 || pWal->hdr.mxFrame==0)
+  ){
     /* The WAL has been completely backfilled (or it is empty).
     ** and can be safely ignored.
     */
@@ -2124,13 +2355,13 @@ static int walTryBeginRead(Wal *pWal, int *pChanged, int useWal, int cnt){
   /* If we get this far, it means that the reader will want to use
   ** the WAL to get at content from recent commits.  The job now is
   ** to select one of the aReadMark[] entries that is closest to
-  ** but not exceeding pWal->hdr.mxFrame and lock that entry.
+  ** but not exceeding mxFrame and lock that entry.
   */
   mxReadMark = 0;
   mxI = 0;
   for(i=1; i<WAL_NREADER; i++){
     u32 thisMark = pInfo->aReadMark[i];
-    if( mxReadMark<=thisMark && thisMark<=pWal->hdr.mxFrame ){
+    if( mxReadMark<=thisMark && thisMark<=mxFrame ){
       assert( thisMark!=READMARK_NOT_USED );
       mxReadMark = thisMark;
       mxI = i;
@@ -2139,12 +2370,12 @@ static int walTryBeginRead(Wal *pWal, int *pChanged, int useWal, int cnt){
   /* There was once an "if" here. The extra "{" is to preserve indentation. */
   {
     if( (pWal->readOnly & WAL_SHM_RDONLY)==0
-     && (mxReadMark<pWal->hdr.mxFrame || mxI==0)
+     && (mxReadMark<mxFrame || mxI==0)
     ){
       for(i=1; i<WAL_NREADER; i++){
         rc = walLockExclusive(pWal, WAL_READ_LOCK(i), 1);
         if( rc==SQLITE_OK ){
-          mxReadMark = pInfo->aReadMark[i] = pWal->hdr.mxFrame;
+          mxReadMark = pInfo->aReadMark[i] = mxFrame;
           mxI = i;
           walUnlockExclusive(pWal, WAL_READ_LOCK(i), 1);
           break;
@@ -2213,6 +2444,12 @@ static int walTryBeginRead(Wal *pWal, int *pChanged, int useWal, int cnt){
 int sqlite3WalBeginReadTransaction(Wal *pWal, int *pChanged){
   int rc;                         /* Return code */
   int cnt = 0;                    /* Number of TryBeginRead attempts */
+  WalIndexHdr *pSnapshot = pWal->pSnapshot;
+  int bChanged = 0;               /* True if pSnapshot differs from pWal->hdr */
+
+  if( pSnapshot && memcmp(pSnapshot, &pWal->hdr, sizeof(WalIndexHdr)) ){
+    bChanged = 1;
+  }
 
   do{
     rc = walTryBeginRead(pWal, pChanged, 0, ++cnt);
@@ -2221,6 +2458,44 @@ int sqlite3WalBeginReadTransaction(Wal *pWal, int *pChanged){
   testcase( (rc&0xff)==SQLITE_IOERR );
   testcase( rc==SQLITE_PROTOCOL );
   testcase( rc==SQLITE_OK );
+
+  if( rc==SQLITE_OK && pSnapshot
+   && memcmp(pSnapshot, &pWal->hdr, sizeof(WalIndexHdr))
+  ){
+    /* The read-lock held is on an aReadMark[] value no greater than
+    ** pSnapshot->mxFrame, but pWal->hdr is the header of the current
+    ** head of the WAL. The snapshot may only be opened if the WAL has not
+    ** been restarted since it was taken (in which case the salts would
+    ** differ) and no frames following it have been copied into the
+    ** database file by a checkpointer.
+    **
+    ** A checkpointer that started before the read-lock was obtained might
+    ** still be copying such frames without having updated nBackfill. So 
+    ** nBackfill is only checked while holding a shared CKPT lock, which
+    ** cannot be obtained while a checkpoint is running.
+    */
+    volatile WalCkptInfo *pInfo = walCkptInfo(pWal);
+    rc = walLockShared(pWal, WAL_CKPT_LOCK);
+    if( rc==SQLITE_OK ){
+      if( memcmp(pSnapshot->aSalt, pWal->hdr.aSalt, sizeof(pWal->hdr.aSalt))==0
+       && pSnapshot->szPage==pWal->hdr.szPage
+       && pSnapshot->mxFrame<=pWal->hdr.mxFrame
+       && pSnapshot->mxFrame>=pInfo->nBackfill
+       && (pWal->readLock==0 
+           || pInfo->aReadMark[pWal->readLock]<=pSnapshot->mxFrame)
+      ){
+        assert( pWal->readLock>0 || pSnapshot->mxFrame==0 );
+        memcpy(&pWal->hdr, pSnapshot, sizeof(WalIndexHdr));
+        *pChanged = bChanged;
+      }else{
+        rc = SQLITE_BUSY_SNAPSHOT;
+      }
+      walUnlockShared(pWal, WAL_CKPT_LOCK);
+    }
+    if( rc!=SQLITE_OK ){
+      sqlite3WalEndReadTransaction(pWal);
+    }
+  }
   return rc;
 }
 
@@ -2254,6 +2529,7 @@ int sqlite3WalRead(
   u32 iRead = 0;                  /* If !=0, WAL frame to return data from */
   u32 iLast = pWal->hdr.mxFrame;  /* Last page in WAL for this reader */
   int iHash;                      /* Used to loop through N hash tables */
+  int rc;                         /* Error code */
 
   /* This routine is only be called from within a read transaction. */
   assert( pWal->readLock>=0 || pWal->lockError );
@@ -2293,15 +2569,24 @@ int sqlite3WalRead(
   **   (iFrame<=iLast): 
   **     This condition filters out entries that were added to the hash
   **     table after the current read-transaction had started.
+  **
+  ** Hash tables summarized by the private map pWal->map are not searched.
+  ** If the page is not found in the others, it is looked up in the map.
   */
-  for(iHash=walFramePage(iLast); iHash>=0 && iRead==0; iHash--){
+  rc = walMapUpdate(pWal, iLast);
+  if( rc!=SQLITE_OK ){
+    return rc;
+  }
+  for(iHash=walFramePage(iLast); iHash>=pWal->map.nSeg && iRead==0; iHash--){
     volatile ht_slot *aHash;      /* Pointer to hash table */
     volatile u32 *aPgno;          /* Pointer to array of page numbers */
     u32 iZero;                    /* Frame number corresponding to aPgno[0] */
     int iKey;                     /* Hash slot index */
     int nCollide;                 /* Number of hash collisions remaining */
-    int rc;                       /* Error code */
 
+#ifdef SQLITE_TEST
+    sqlite3_wal_hash_probe_count++;
+#endif
     rc = walHashGet(pWal, iHash, &aHash, &aPgno, &iZero);
     if( rc!=SQLITE_OK ){
       return rc;
@@ -2318,6 +2603,10 @@ int sqlite3WalRead(
       }
     }
   }
+  if( iRead==0 ){
+    iRead = walMapLookup(&pWal->map, pgno);
+    assert( iRead<=iLast );
+  }
 
 #ifdef SQLITE_ENABLE_EXPENSIVE_ASSERT
   /* If expensive assert() statements are available, do a linear search
@@ -2414,6 +2703,102 @@ int sqlite3WalBeginWriteTransaction(Wal *pWal){
   return rc;
 }
 
+/*
+** This function is called when a BEGIN CONCURRENT transaction is about
+** to commit. Such a transaction does not take the write lock when it 
+** starts, so other connections may have committed transactions to the
+** log since its read snapshot was taken. The pages it has read (and
+** hence all pages it has modified) are recorded in bitvec pAllRead, or
+** pAllRead is NULL if the set of pages is not known.
+**
+** Obtain the write lock, returning SQLITE_BUSY if it is held by another
+** connection. Then check each frame appended to the log since the 
+** snapshot was taken. If any of them contains a page in pAllRead (or if
+** pAllRead is NULL), the transaction may not be committed: release the
+** write lock and return SQLITE_BUSY_SNAPSHOT.
+**
+** Otherwise, move the snapshot forward to the current end of the log and
+** invoke xUndo for each page written by the other transactions, so that
+** the caller can discard its out-of-date copies of those pages. The 
+** caller may then write its transaction to the log as if it had held
+** the write lock since it began.
+*/
+int sqlite3WalLockForCommit(
+  Wal *pWal,                      /* WAL handle */
+  Bitvec *pAllRead,               /* Pages read by the transaction */
+  int (*xUndo)(void *, Pgno),     /* Callback for pages written by others */
+  void *pUndoCtx                  /* First argument to xUndo */
+){
+  volatile WalIndexHdr *pHead;    /* Current wal-index header */
+  u32 iFirst;                     /* First frame written by another txn */
+  u32 iFrame;                     /* Used to iterate through frames */
+  int rc;
+
+  assert( pWal->readLock>=0 );
+  if( pWal->writeLock ) return SQLITE_OK;
+  if( pWal->readOnly ) return SQLITE_READONLY;
+
+  rc = walLockExclusive(pWal, WAL_WRITE_LOCK, 1);
+  if( rc ){
+    return rc;
+  }
+  pWal->writeLock = 1;
+
+  pHead = walIndexHdr(pWal);
+  if( memcmp(&pWal->hdr, (void *)pHead, sizeof(WalIndexHdr))==0 ){
+    return SQLITE_OK;
+  }
+
+  /* If the log has been restarted since the snapshot was taken (only 
+  ** possible if this connection is ignoring the log, pWal->readLock==0),
+  ** then every frame in it was written by another transaction.  */
+  if( memcmp(pWal->hdr.aSalt, (void *)pHead->aSalt, sizeof(pWal->hdr.aSalt)) ){
+    assert( pWal->readLock==0 );
+    iFirst = 1;
+  }else{
+    iFirst = pWal->hdr.mxFrame+1;
+  }
+  for(iFrame=iFirst; rc==SQLITE_OK && iFrame<=pHead->mxFrame; iFrame++){
+    volatile u32 *aPage;
+    rc = walIndexPage(pWal, walFramePage(iFrame), &aPage);
+    if( rc==SQLITE_OK ){
+      u32 pgno = walFramePgno(pWal, iFrame);
+      if( pAllRead==0 || sqlite3BitvecTest(pAllRead, pgno) ){
+        rc = SQLITE_BUSY_SNAPSHOT;
+      }
+    }
+  }
+
+  if( rc==SQLITE_OK ){
+    memcpy(&pWal->hdr, (void *)pHead, sizeof(WalIndexHdr));
+
+    /* A connection holding WAL_READ_LOCK(0) reads every page from the
+    ** database file. Now that the snapshot includes frames that may not 
+    ** have been checkpointed, switch to a read lock that uses the log. 
+    ** This cannot return SQLITE_BUSY, as the write lock is held.  */
+    if( pWal->readLock==0 ){
+      int cnt = 0;
+      walUnlockShared(pWal, WAL_READ_LOCK(0));
+      pWal->readLock = -1;
+      do{
+        int notUsed;
+        rc = walTryBeginRead(pWal, &notUsed, 1, ++cnt);
+      }while( rc==WAL_RETRY );
+      assert( (rc&0xff)!=SQLITE_BUSY );
+    }
+
+    for(iFrame=iFirst; rc==SQLITE_OK && iFrame<=pWal->hdr.mxFrame; iFrame++){
+      rc = xUndo(pUndoCtx, walFramePgno(pWal, iFrame));
+    }
+  }
+
+  if( rc!=SQLITE_OK ){
+    walUnlockExclusive(pWal, WAL_WRITE_LOCK, 1);
+    pWal->writeLock = 0;
+  }
+  return rc;
+}
+
 /*
 ** End a write transaction.  The commit has already been done.  This
 ** routine merely releases the lock.
@@ -2440,7 +2825,10 @@ int sqlite3WalEndWriteTransaction(Wal *pWal){
 */
 int sqlite3WalUndo(Wal *pWal, int (*xUndo)(void *, Pgno), void *pUndoCtx){
   int rc = SQLITE_OK;
-  if( ALWAYS(pWal->writeLock) ){
+
+  /* A BEGIN CONCURRENT transaction rolled back before it obtained the 
+  ** write lock has not written anything to the log.  */
+  if( pWal->writeLock ){
     Pgno iMax = pWal->hdr.mxFrame;
     Pgno iFrame;
   
@@ -2478,9 +2866,13 @@ int sqlite3WalUndo(Wal *pWal, int (*xUndo)(void *, Pgno), void *pUndoCtx){
 ** values. This function populates the array with values required to 
 ** "rollback" the write position of the WAL handle back to the current 
 ** point in the event of a savepoint rollback (via WalSavepointUndo()).
+**
+** A BEGIN CONCURRENT transaction may open a savepoint before it holds the
+** write lock. The values saved are then those of its snapshot, and are
+** ignored by WalSavepointUndo().
 */
 void sqlite3WalSavepoint(Wal *pWal, u32 *aWalData){
-  assert( pWal->writeLock );
+  assert( pWal->readLock>=0 );
   aWalData[0] = pWal->hdr.mxFrame;
   aWalData[1] = pWal->hdr.aFrameCksum[0];
   aWalData[2] = pWal->hdr.aFrameCksum[1];
@@ -2496,7 +2888,11 @@ void sqlite3WalSavepoint(Wal *pWal, u32 *aWalData){
 int sqlite3WalSavepointUndo(Wal *pWal, u32 *aWalData){
   int rc = SQLITE_OK;
 
-  assert( pWal->writeLock );
+  /* Nothing to do for a BEGIN CONCURRENT transaction that has not yet
+  ** obtained the write lock. It has not written anything to the log.  */
+  if( pWal->writeLock==0 ){
+    return SQLITE_OK;
+  }
   assert( aWalData[3]!=pWal->nCkpt || aWalData[0]<=pWal->hdr.mxFrame );
 
   if( aWalData[3]!=pWal->nCkpt ){
@@ -2565,6 +2961,7 @@ static int walRestartLog(Wal *pWal){
           rx = sqlite3OsFileSize(pWal->pWalFd, &sz);
           if( rx==SQLITE_OK && (sz > pWal->mxWalSize) ){
             rx = sqlite3OsTruncate(pWal->pWalFd, pWal->mxWalSize);
+            pWal->szAlloc = 0;
           }
           sqlite3EndBenignMalloc();
           if( rx ){
@@ -2618,6 +3015,8 @@ int sqlite3WalFrames(
   PgHdr *p;                       /* Iterator to run through pList with. */
   PgHdr *pLast = 0;               /* Last frame in list */
   int nLast = 0;                  /* Number of extra copies of last page */
+  int nWriteback = 0;             /* Frames written since last WRITEBACK */
+  i64 iWriteback;                 /* Offset of first of those frames */
 
   assert( pList );
   assert( pWal->writeLock );
@@ -2668,6 +3067,32 @@ int sqlite3WalFrames(
   }
   assert( (int)pWal->szPage==szPage );
 
+  /* If a chunk size is configured, make sure the file is allocated up to
+  ** the end of the last frame. */
+  if( pWal->szChunk ){
+    i64 iEnd;
+    int nFrame = 0;
+    for(p=pList; p; p=p->pDirty) nFrame++;
+    iEnd = walFrameOffset(iFrame+nFrame+1, szPage);
+    if( sync_flags ){
+      /* Allow for the copies of the last frame that pad the log out to a
+      ** sector boundary before it is synced (see below). */
+      i64 iSector = sqlite3OsSectorSize(pWal->pWalFd);
+      iEnd = ((iEnd+iSector-1)/iSector)*iSector + szPage + WAL_FRAME_HDRSIZE;
+    }
+    if( iEnd>pWal->szAlloc ){
+      sqlite3BeginBenignMalloc();
+      rc = sqlite3OsFileControl(pWal->pWalFd, SQLITE_FCNTL_SIZE_HINT, &iEnd);
+      sqlite3EndBenignMalloc();
+      if( rc==SQLITE_OK ){
+        pWal->szAlloc = ((iEnd+pWal->szChunk-1)/pWal->szChunk)*pWal->szChunk;
+      }
+      rc = SQLITE_OK;
+    }
+  }
+  iWriteback = walFrameOffset(iFrame+1, szPage);
+  if( sync_flags==0 || SQLITE_WAL_WRITEBACK<=0 ) nWriteback = -1;
+
   /* Write the log file. */
   for(p=pList; p; p=p->pDirty){
     u32 nDbsize;                  /* Db-size field for frame header */
@@ -2696,6 +3121,24 @@ int sqlite3WalFrames(
       return rc;
     }
     pLast = p;
+
+    /* Start writeback of the last SQLITE_WAL_WRITEBACK frames */
+    if( nWriteback>=0 && ++nWriteback==SQLITE_WAL_WRITEBACK && p->pDirty ){
+      i64 aRange[2];
+      aRange[0] = iWriteback;
+      aRange[1] = iOffset + sizeof(aFrame) + szPage - iWriteback;
+      rc = sqlite3OsFileControl(pWal->pWalFd, SQLITE_FCNTL_WRITEBACK, aRange);
+      if( rc==SQLITE_OK ){
+#ifdef SQLITE_TEST
+        sqlite3_wal_writeback_count++;
+#endif
+        nWriteback = 0;
+        iWriteback += aRange[1];
+      }else{
+        nWriteback = -1;
+      }
+      rc = SQLITE_OK;
+    }
   }
 
   /* Sync the log file if the 'isSync' flag was specified. */
@@ -2940,6 +3383,44 @@ int sqlite3WalExclusiveMode(Wal *pWal, int op){
   return rc;
 }
 
+/*
+** Allocate a copy of the wal-index header of the current read transaction
+** and set *ppSnapshot to point to it. The caller must eventually free the
+** copy using sqlite3_free().
+**
+** SQLITE_ERROR is returned if no frame has ever been written to the WAL
+** file, as the read transaction cannot then be reliably identified. Or
+** SQLITE_NOMEM if a malloc fails.
+*/
+int sqlite3WalSnapshotGet(Wal *pWal, sqlite3_snapshot **ppSnapshot){
+  static const u32 aZero[2] = { 0, 0 };
+  WalIndexHdr *pRet;
+
+  assert( pWal->readLock>=0 );
+  *ppSnapshot = 0;
+  if( memcmp(pWal->hdr.aFrameCksum, aZero, sizeof(aZero))==0 ){
+    return SQLITE_ERROR;
+  }
+  pRet = (WalIndexHdr*)sqlite3_malloc(sizeof(WalIndexHdr));
+  if( pRet==0 ){
+    return SQLITE_NOMEM;
+  }
+  memcpy(pRet, &pWal->hdr, sizeof(WalIndexHdr));
+  *ppSnapshot = (sqlite3_snapshot*)pRet;
+  return SQLITE_OK;
+}
+
+/*
+** Configure the WAL so that the next read transaction is opened on the
+** snapshot passed as the second argument (obtained from an earlier call
+** to sqlite3WalSnapshotGet() on any connection to the same WAL), instead
+** of on the current head of the WAL. Or, if the second argument is NULL,
+** so that read transactions are opened on the current head of the WAL.
+*/
+void sqlite3WalSnapshotOpen(Wal *pWal, sqlite3_snapshot *pSnapshot){
+  pWal->pSnapshot = (WalIndexHdr*)pSnapshot;
+}
+
 /* 
 ** Return true if the argument is non-NULL and the WAL module is using
 ** heap-memory for the wal-index. Otherwise, if the argument is NULL or the
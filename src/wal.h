@@ -22,6 +22,7 @@
 #ifdef SQLITE_OMIT_WAL
 # define sqlite3WalOpen(x,y,z)                   0
 # define sqlite3WalLimit(x,y)
+# define sqlite3WalChunkSize(x,y)
 # define sqlite3WalClose(w,x,y,z)                0
 # define sqlite3WalBeginReadTransaction(y,z)     0
 # define sqlite3WalEndReadTransaction(z)
@@ -29,6 +30,7 @@
 # define sqlite3WalDbsize(y)                     0
 # define sqlite3WalBeginWriteTransaction(y)      0
 # define sqlite3WalEndWriteTransaction(x)        0
+# define sqlite3WalLockForCommit(w,x,y,z)        0
 # define sqlite3WalUndo(x,y,z)                   0
 # define sqlite3WalSavepoint(y,z)
 # define sqlite3WalSavepointUndo(y,z)            0
@@ -37,6 +39,8 @@
 # define sqlite3WalCallback(z)                   0
 # define sqlite3WalExclusiveMode(y,z)            0
 # define sqlite3WalHeapMemory(z)                 0
+# define sqlite3WalSnapshotGet(y,z)              SQLITE_ERROR
+# define sqlite3WalSnapshotOpen(y,z)
 #else
 
 #define WAL_SAVEPOINT_NDATA 4
@@ -53,6 +57,9 @@ int sqlite3WalClose(Wal *pWal, int sync_flags, int, u8 *);
 /* Set the limiting size of a WAL file. */
 void sqlite3WalLimit(Wal*, i64);
 
+/* Set the size of the chunks in which the WAL file is allocated. */
+void sqlite3WalChunkSize(Wal*, int);
+
 /* Used by readers to open (lock) and close (unlock) a snapshot.  A 
 ** snapshot is like a read-transaction.  It is the state of the database
 ** at an instant in time.  sqlite3WalOpenSnapshot gets a read lock and
@@ -73,6 +80,10 @@ Pgno sqlite3WalDbsize(Wal *pWal);
 int sqlite3WalBeginWriteTransaction(Wal *pWal);
 int sqlite3WalEndWriteTransaction(Wal *pWal);
 
+/* Obtain the WRITER lock for a BEGIN CONCURRENT transaction, checking 
+** that no page it has read has been modified since its snapshot. */
+int sqlite3WalLockForCommit(Wal*, Bitvec*, int (*)(void *, Pgno), void*);
+
 /* Undo any frames written (but not committed) to the log */
 int sqlite3WalUndo(Wal *pWal, int (*xUndo)(void *, Pgno), void *pUndoCtx);
 
@@ -118,5 +129,11 @@ int sqlite3WalExclusiveMode(Wal *pWal, int op);
 */
 int sqlite3WalHeapMemory(Wal *pWal);
 
+/* Return a copy of the snapshot of the current read transaction, or 
+** set the snapshot on which the next read transaction is opened.
+*/
+int sqlite3WalSnapshotGet(Wal *pWal, sqlite3_snapshot **ppSnapshot);
+void sqlite3WalSnapshotOpen(Wal *pWal, sqlite3_snapshot *pSnapshot);
+
 #endif /* ifndef SQLITE_OMIT_WAL */
 #endif /* _WAL_H_ */
@@ -254,6 +254,7 @@ struct WhereCost {
 #define WHERE_MULTI_OR     0x10000000  /* OR using multiple indices */
 #define WHERE_TEMP_INDEX   0x20000000  /* Uses an ephemeral index */
 #define WHERE_DISTINCT     0x40000000  /* Correct order for DISTINCT */
+#define WHERE_MERGE_JOIN   0x80000000  /* Seek keys ascend with outer loop */
 
 /*
 ** Initialize a preallocated WhereClause structure.
@@ -339,7 +340,7 @@ static int whereClauseInsert(WhereClause *pWC, Expr *p, u8 wtFlags){
   if( pWC->nTerm>=pWC->nSlot ){
     WhereTerm *pOld = pWC->a;
     sqlite3 *db = pWC->pParse->db;
-    pWC->a = sqlite3DbMallocRaw(db, sizeof(pWC->a[0])*pWC->nSlot*2 );
+    pWC->a = sqlite3ArenaMallocRaw(db, sizeof(pWC->a[0])*pWC->nSlot*2 );
     if( pWC->a==0 ){
       if( wtFlags & TERM_DYNAMIC ){
         sqlite3ExprDelete(db, p);
@@ -873,7 +874,7 @@ static void exprAnalyzeOrTerm(
   */
   assert( (pTerm->wtFlags & (TERM_DYNAMIC|TERM_ORINFO|TERM_ANDINFO))==0 );
   assert( pExpr->op==TK_OR );
-  pTerm->u.pOrInfo = pOrInfo = sqlite3DbMallocZero(db, sizeof(*pOrInfo));
+  pTerm->u.pOrInfo = pOrInfo = sqlite3ArenaMallocZero(db, sizeof(*pOrInfo));
   if( pOrInfo==0 ) return;
   pTerm->wtFlags |= TERM_ORINFO;
   pOrWc = &pOrInfo->wc;
@@ -894,7 +895,7 @@ static void exprAnalyzeOrTerm(
       assert( pOrTerm->eOperator==0 );
       assert( (pOrTerm->wtFlags & (TERM_ANDINFO|TERM_ORINFO))==0 );
       chngToIN = 0;
-      pAndInfo = sqlite3DbMallocRaw(db, sizeof(*pAndInfo));
+      pAndInfo = sqlite3ArenaMallocRaw(db, sizeof(*pAndInfo));
       if( pAndInfo ){
         WhereClause *pAndWC;
         WhereTerm *pAndTerm;
@@ -1711,6 +1712,72 @@ static int isSortingIndex(
   return 0;
 }
 
+/*
+** pLevel is a loop that has just been chosen by the optimizer, and pOuter
+** is the loop immediately enclosing it. This routine returns true if the
+** two loops can be advanced in lockstep, as in a merge join.
+**
+** This is the case if pLevel uses an index whose left-most column is
+** constrained by an == operator against a column of the table scanned by
+** pOuter, and pOuter visits its rows in ascending order of that column 
+** (either because it scans an index that satisfies "ORDER BY <column>",
+** as determined by isSortingIndex(), or because it scans the table in
+** rowid order and the column is the rowid). The keys used to seek the
+** index of pLevel then arrive in ascending order, so each seek can move
+** forward from the position left by the previous one, and the join makes
+** a single pass over both b-trees.
+*/
+static int isMergeJoin(
+  Parse *pParse,          /* Parsing context */
+  WhereClause *pWC,       /* The WHERE clause */
+  SrcList *pTabList,      /* The FROM clause */
+  WhereLevel *pOuter,     /* The enclosing loop */
+  WhereLevel *pLevel,     /* The loop that might be the inner loop of a merge */
+  Bitmask notReady        /* Tables not available to pLevel */
+){
+  u32 wsFlags = pLevel->plan.wsFlags;
+  u32 outerFlags = pOuter->plan.wsFlags;
+  int iCur = pTabList->a[pLevel->iFrom].iCursor;
+  int iOuterCur = pTabList->a[pOuter->iFrom].iCursor;
+  Index *pIdx = pLevel->plan.u.pIdx;
+  WhereTerm *pTerm;
+  Expr *pRight;
+  int rc = 0;
+
+  if( (wsFlags & WHERE_COLUMN_EQ)==0 
+   || (wsFlags & (WHERE_COLUMN_IN|WHERE_TEMP_INDEX|WHERE_REVERSE))!=0
+   || pIdx->aSortOrder[0]!=SQLITE_SO_ASC
+   || (outerFlags & (WHERE_COLUMN_IN|WHERE_ROWID_EQ|WHERE_TEMP_INDEX
+                     |WHERE_VIRTUALTABLE|WHERE_MULTI_OR|WHERE_REVERSE))!=0
+  ){
+    return 0;
+  }
+  pTerm = findTerm(pWC, iCur, pIdx->aiColumn[0], notReady,
+                   WO_EQ|WO_IN|WO_ISNULL, pIdx);
+  if( pTerm==0 || pTerm->eOperator!=WO_EQ ) return 0;
+  pRight = pTerm->pExpr->pRight;
+  if( pRight->op!=TK_COLUMN || pRight->iTable!=iOuterCur ) return 0;
+
+  if( outerFlags & WHERE_INDEXED ){
+    /* The outer loop scans an index. Check that the index delivers rows
+    ** in the same order as "ORDER BY <pRight>" would. */
+    sqlite3 *db = pParse->db;
+    ExprList *pList;
+    int bRev = 0;
+    pList = sqlite3ExprListAppend(pParse, 0, sqlite3ExprDup(db, pRight, 0));
+    if( pList ){
+      rc = isSortingIndex(pParse, pWC->pMaskSet, pOuter->plan.u.pIdx,
+                          iOuterCur, pList, pOuter->plan.nEq, outerFlags, &bRev
+      ) && bRev==0;
+      sqlite3ExprListDelete(db, pList);
+    }
+  }else{
+    /* The outer loop scans the table in rowid order. */
+    rc = pRight->iColumn<0;
+  }
+  return rc;
+}
+
 /*
 ** Prepare a crude estimate of the logarithm of the input value.
 ** The results need not be exact.  This is only used for estimating
@@ -4130,6 +4197,30 @@ static Bitmask codeOneLoopStart(
     testcase( op==OP_SeekLt );
     sqlite3VdbeAddOp4Int(v, op, iIdxCur, addrNxt, regBase, nConstraint);
 
+    /* If one or more of the equality constraints are IN operators, the
+    ** seek above is executed once for each combination of values on the
+    ** RHS of the IN operators. Those values are visited in sorted order,
+    ** so for a forward scan of an index with no DESC columns in the
+    ** first nEq positions each seek key is larger than the last. Let 
+    ** the seek try to find its target by moving forward from the current
+    ** position of the cursor instead of starting again from the root.
+    **
+    ** The same applies if this is the inner loop of a merge join (see
+    ** isMergeJoin()), in which case the keys ascend with the outer loop.
+    */
+    if( op==OP_SeekGe || op==OP_SeekGt ){
+      if( pLevel->plan.wsFlags & WHERE_MERGE_JOIN ){
+        sqlite3VdbeChangeP5(v, OPFLAG_SEEKSCAN);
+      }else if( (pLevel->plan.wsFlags & WHERE_IN_ABLE)!=0 
+             && pLevel->u.in.nIn>0 
+      ){
+        for(j=0; j<nEq && pIdx->aSortOrder[j]==SQLITE_SO_ASC; j++);
+        if( j==nEq ){
+          sqlite3VdbeChangeP5(v, OPFLAG_SEEKSCAN);
+        }
+      }
+    }
+
     /* Load the value for the inequality constraint at the end of the
     ** range (if any).
     */
@@ -4596,7 +4687,7 @@ WhereInfo *sqlite3WhereBegin(
   */
   db = pParse->db;
   nByteWInfo = ROUND8(sizeof(WhereInfo)+(nTabList-1)*sizeof(WhereLevel));
-  pWInfo = sqlite3DbMallocZero(db, 
+  pWInfo = sqlite3ArenaMallocZero(db, 
       nByteWInfo + 
       sizeof(WhereClause) +
       sizeof(WhereMaskSet)
@@ -4878,8 +4969,13 @@ WhereInfo *sqlite3WhereBegin(
     }else{
       pLevel->iIdxCur = -1;
     }
-    notReady &= ~getMask(pMaskSet, pTabList->a[bestJ].iCursor);
     pLevel->iFrom = (u8)bestJ;
+    if( pLevel>pWInfo->a 
+     && isMergeJoin(pParse, pWC, pTabList, &pLevel[-1], pLevel, notReady)
+    ){
+      pLevel->plan.wsFlags |= WHERE_MERGE_JOIN;
+    }
+    notReady &= ~getMask(pMaskSet, pTabList->a[bestJ].iCursor);
     if( bestPlan.plan.nRow>=(double)1 ){
       pParse->nQueryLoop *= bestPlan.plan.nRow;
     }
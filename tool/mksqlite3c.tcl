@@ -236,6 +236,7 @@ foreach file {
    mem2.c
    mem3.c
    mem5.c
+   mem6.c
    mutex.c
    mutex_noop.c
    mutex_os2.c
@@ -291,6 +292,7 @@ foreach file {
    loadext.c
    pragma.c
    prepare.c
+   schemacache.c
    select.c
    table.c
    trigger.c
@@ -0,0 +1,120 @@
+/*
+** Performance test for the hash tables used by SQLite.
+**
+** This program inserts a number of keys into an instance of the hash
+** table used for schema lookups (src/hash.c) and then looks each of them
+** up, and a key not in the table, many times.  If FTS3 is enabled, it
+** does the same with the hash table that FTS3 uses to accumulate pending
+** terms (ext/fts3/fts3_hash.c).  The time taken by each step is reported.
+**
+** The program includes the amalgamation directly, as the hash tables are
+** not part of the public interface.  To compare two versions of the hash
+** tables, build it once with the amalgamation for each version, then run
+** both with the same arguments.  For example:
+**
+**     gcc -O2 -DSQLITE_ENABLE_FTS3 -I. speedtest-hash.c -lpthread -ldl
+**
+** Run it with the number of keys and the number of lookups per key:
+**
+**     ./a.out 1000 1000
+*/
+#include "sqlite3.c"
+#include <stdio.h>
+#include <sys/time.h>
+
+/*
+** Return the current time in microseconds.
+*/
+static sqlite3_int64 timeOfDay(void){
+  struct timeval sNow;
+  gettimeofday(&sNow, 0);
+  return ((sqlite3_int64)sNow.tv_sec)*1000000 + sNow.tv_usec;
+}
+
+/*
+** Print the time elapsed since *piStart and reset *piStart.
+*/
+static void report(const char *zStep, sqlite3_int64 *piStart){
+  sqlite3_int64 iNow = timeOfDay();
+  printf("%-28s %10.3f ms\n", zStep, (double)(iNow-*piStart)/1000.0);
+  *piStart = timeOfDay();
+}
+
+int main(int argc, char **argv){
+  int nKey;                       /* Number of keys */
+  int nLookup;                    /* Lookups of each key */
+  char **azKey;                   /* Keys.  Names like "table_0042" */
+  int i, j;
+  int nMiss = 0;
+  sqlite3_int64 iStart;
+  Hash h;
+
+  if( argc!=3 ){
+    fprintf(stderr, "Usage: %s NKEY NLOOKUP\n", argv[0]);
+    return 1;
+  }
+  nKey = atoi(argv[1]);
+  nLookup = atoi(argv[2]);
+  sqlite3_config(SQLITE_CONFIG_MEMSTATUS, 0);
+  sqlite3_initialize();
+
+  azKey = (char **)malloc(sizeof(char*)*nKey);
+  for(i=0; i<nKey; i++){
+    azKey[i] = sqlite3_mprintf("Table_%04d", i);
+  }
+
+  iStart = timeOfDay();
+  sqlite3HashInit(&h);
+  for(i=0; i<nKey; i++){
+    sqlite3HashInsert(&h, azKey[i], sqlite3Strlen30(azKey[i]), azKey[i]);
+  }
+  report("Hash insert", &iStart);
+  for(j=0; j<nLookup; j++){
+    for(i=0; i<nKey; i++){
+      if( sqlite3HashFind(&h, azKey[i], sqlite3Strlen30(azKey[i]))==0 ){
+        nMiss++;
+      }
+    }
+  }
+  report("Hash lookup (present)", &iStart);
+  for(j=0; j<nLookup; j++){
+    for(i=0; i<nKey; i++){
+      if( sqlite3HashFind(&h, "no_such_tbl", 11) ) nMiss++;
+    }
+  }
+  report("Hash lookup (absent)", &iStart);
+  sqlite3HashClear(&h);
+  report("Hash clear", &iStart);
+
+#ifdef SQLITE_ENABLE_FTS3
+  {
+    Fts3Hash f;
+    sqlite3Fts3HashInit(&f, FTS3_HASH_STRING, 1);
+    for(i=0; i<nKey; i++){
+      sqlite3Fts3HashInsert(&f, azKey[i], sqlite3Strlen30(azKey[i]), azKey[i]);
+    }
+    report("Fts3Hash insert", &iStart);
+    for(j=0; j<nLookup; j++){
+      for(i=0; i<nKey; i++){
+        if( sqlite3Fts3HashFind(&f, azKey[i], sqlite3Strlen30(azKey[i]))==0 ){
+          nMiss++;
+        }
+      }
+    }
+    report("Fts3Hash lookup (present)", &iStart);
+    sqlite3Fts3HashClear(&f);
+    report("Fts3Hash clear", &iStart);
+  }
+#endif
+
+  for(i=0; i<nKey; i++){
+    sqlite3_free(azKey[i]);
+  }
+  free(azKey);
+  sqlite3_shutdown();
+  if( nMiss ){
+    fprintf(stderr, "%d lookups returned the wrong result\n", nMiss);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,125 @@
+/*
+** Performance test for the SQLite memory allocator.
+**
+** This program starts a number of threads. Each thread opens its own
+** in-memory database and repeatedly creates, fills, queries and drops
+** a table, which makes many small memory allocations. The total time
+** taken is reported.  It is used to compare the default allocator with
+** the caches enabled by SQLITE_CONFIG_MALLOCCACHE. Memory statistics
+** are disabled, as otherwise every allocation is serialized by the mutex
+** that protects them.
+**
+** To compile this program, first compile the SQLite library separately
+** with full optimizations and the mem6.c allocator enabled.  For example:
+**
+**     gcc -c -O2 -DSQLITE_ENABLE_MEMSYS6 sqlite3.c
+**
+** Then link against this program:
+**
+**     gcc -O2 speedtest-malloc.c sqlite3.o -lpthread -ldl -I.
+**
+** Run it with the number of threads, the number of iterations per thread
+** and the size of each cache in bytes (0 to use the default allocator):
+**
+**     ./a.out 8 200 65536
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+#include "sqlite3.h"
+
+static int nIter = 100;         /* Iterations per thread */
+
+/*
+** Return the current time in microseconds.
+*/
+static sqlite3_int64 timeOfDay(void){
+  struct timeval sNow;
+  gettimeofday(&sNow, 0);
+  return ((sqlite3_int64)sNow.tv_sec)*1000000 + sNow.tv_usec;
+}
+
+/*
+** Run SQL and exit with an error message if it fails.
+*/
+static void runSql(sqlite3 *db, const char *zSql){
+  char *zErr = 0;
+  if( sqlite3_exec(db, zSql, 0, 0, &zErr)!=SQLITE_OK ){
+    fprintf(stderr, "SQL error: %s\n", zErr);
+    exit(1);
+  }
+}
+
+/*
+** The body of each thread.
+*/
+static void *threadMain(void *pArg){
+  sqlite3 *db;
+  int i;
+  (void)pArg;
+  if( sqlite3_open(":memory:", &db)!=SQLITE_OK ){
+    fprintf(stderr, "cannot open database\n");
+    exit(1);
+  }
+  for(i=0; i<nIter; i++){
+    runSql(db,
+      "CREATE TABLE t1(a INTEGER PRIMARY KEY, b TEXT, c BLOB);"
+      "CREATE INDEX t1b ON t1(b);"
+      "INSERT INTO t1 VALUES(1, 'one', randomblob(20));"
+      "INSERT INTO t1 SELECT a+1, b||a, randomblob(30) FROM t1;"
+      "INSERT INTO t1 SELECT a+2, b||a, randomblob(40) FROM t1;"
+      "INSERT INTO t1 SELECT a+4, b||a, randomblob(50) FROM t1;"
+      "INSERT INTO t1 SELECT a+8, b||a, randomblob(60) FROM t1;"
+      "INSERT INTO t1 SELECT a+16, b||a, randomblob(70) FROM t1;"
+      "INSERT INTO t1 SELECT a+32, b||a, randomblob(80) FROM t1;"
+      "SELECT count(*), max(length(b)) FROM t1 WHERE b LIKE 'one%';"
+      "UPDATE t1 SET b = upper(b) WHERE a%3==0;"
+      "DROP TABLE t1;"
+    );
+  }
+  sqlite3_close(db);
+  return 0;
+}
+
+int main(int argc, char **argv){
+  int nThread;
+  int szCache;
+  int i;
+  int rc;
+  pthread_t *aThread;
+  sqlite3_int64 iStart;
+
+  if( argc!=4 ){
+    fprintf(stderr, "Usage: %s NTHREAD NITERATION CACHESIZE\n", argv[0]);
+    return 1;
+  }
+  nThread = atoi(argv[1]);
+  nIter = atoi(argv[2]);
+  szCache = atoi(argv[3]);
+
+  sqlite3_config(SQLITE_CONFIG_MEMSTATUS, 0);
+  if( szCache>0 ){
+    rc = sqlite3_config(SQLITE_CONFIG_MALLOCCACHE, szCache);
+    if( rc!=SQLITE_OK ){
+      fprintf(stderr, "SQLITE_CONFIG_MALLOCCACHE failed (rc=%d)\n", rc);
+      return 1;
+    }
+  }
+  sqlite3_initialize();
+
+  aThread = (pthread_t*)malloc(sizeof(pthread_t)*nThread);
+  iStart = timeOfDay();
+  for(i=0; i<nThread; i++){
+    pthread_create(&aThread[i], 0, threadMain, 0);
+  }
+  for(i=0; i<nThread; i++){
+    pthread_join(aThread[i], 0);
+  }
+  printf("%d threads, %d iterations, cache %d bytes: %.3f seconds\n",
+      nThread, nIter, szCache, (double)(timeOfDay()-iStart)/1000000.0);
+  free(aThread);
+  sqlite3_shutdown();
+  return 0;
+}